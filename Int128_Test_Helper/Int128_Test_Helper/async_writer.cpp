@@ -0,0 +1,281 @@
+#include "async_writer.hpp"
+#include "hex.hpp"
+#include <algorithm>
+#include <cassert>
+#include <locale>
+#include <utility>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	using namespace std::string_view_literals;
+
+	//tofstrm_t is opened in text mode.
+#ifdef _WIN32
+	constexpr std::string_view file_line_end = "\r\n"sv;
+#else
+	constexpr std::string_view file_line_end = "\n"sv;
+#endif
+
+	constexpr std::string_view utf16le_byte_order_mark = "\xff\xfe"sv;
+
+	void append_utf16le(std::string& dest, cjm::tchar_t c)
+	{
+		dest += static_cast<char>(c & 0xff);
+		dest += static_cast<char>(c >> 8);
+	}
+
+	void append_utf16le(std::string& dest, std::string_view ascii)
+	{
+		for (const char c : ascii)
+		{
+			append_utf16le(dest, static_cast<cjm::tchar_t>(c));
+		}
+	}
+
+	[[noreturn]] void throw_write_failure(cjm::fsv_t file_name, cjm::fsv_t step)
+	{
+		throw std::runtime_error{ "Unable to write file [" + cjm::fstr_t{ file_name } + "]: " + cjm::fstr_t{ step } + " failed." };
+	}
+}
+
+std::string cjm::to_file_text(tsv_t text, text_encoding encoding, bool starts_file)
+{
+	auto ret = std::string{};
+	if (encoding == text_encoding::utf16le)
+	{
+		if (starts_file)
+			ret += utf16le_byte_order_mark;
+		for (const tchar_t c : text)
+		{
+			if (c == w_newl)
+				append_utf16le(ret, file_line_end);
+			else
+				append_utf16le(ret, c);
+		}
+		return ret;
+	}
+	//the facet a tofstrm_t converts with.
+	using facet_t = std::codecvt<tchar_t, char, std::mbstate_t>;
+	const auto& facet = std::use_facet<facet_t>(std::locale{});
+	auto state = std::mbstate_t{};
+	auto buffer = std::string(text.size() * static_cast<size_t>(std::max(facet.max_length(), 1)), '\0');
+	const tchar_t* from_next = nullptr;
+	char* to_next = nullptr;
+	if (facet.out(state, text.data(), text.data() + text.size(), from_next, buffer.data(), buffer.data() + buffer.size(),
+		to_next) != facet_t::ok)
+		throw std::invalid_argument{ "Text cannot be converted to UTF-8." };
+	for (const char* it = buffer.data(); it != to_next; ++it)
+	{
+		if (*it == newl)
+			ret += file_line_end;
+		else
+			ret += *it;
+	}
+	return ret;
+}
+
+void cjm::append_file_text(std::vector<char>& dest, const std::vector<binary_operation>& ops, text_encoding encoding)
+{
+	//every character of a record is ASCII: it is its own UTF-8 encoding and the low byte of its UTF-16 one.
+	const size_t unit_size = encoding == text_encoding::utf16le ? 2 : 1;
+	size_t size = dest.size();
+	dest.resize(size + ops.size() * (max_serialized_record_size + file_line_end.size()) * unit_size);
+	auto record = std::array<char, max_serialized_record_size + file_line_end.size()>{};
+	for (const binary_operation& op : ops)
+	{
+		auto x = op;
+		if (!x.has_result())
+		{
+			x.calculate_result();
+		}
+		char* const begin = unit_size == 1 ? dest.data() + size : record.data();
+		char* end = format_record(begin, x.op_code(), x.left_operand(), x.right_operand(), x.result().value());
+		for (const char c : file_line_end)
+		{
+			*end++ = c;
+		}
+		if (unit_size == 1)
+		{
+			size = static_cast<size_t>(end - dest.data());
+			continue;
+		}
+		for (const char* it = begin; it != end; ++it)
+		{
+			dest[size++] = *it;
+			dest[size++] = '\0';
+		}
+	}
+	dest.resize(size);
+}
+
+cjm::async_file_writer::async_file_writer(fsv_t file_name, size_t buffer_size, size_t buffer_count)
+	: m_file_name{ file_name },
+#ifdef _WIN32
+	m_handle{ INVALID_HANDLE_VALUE },
+#else
+	m_descriptor{ -1 },
+#endif
+	m_buffer_size{ buffer_size }, m_current{}, m_bytes_written{ 0 }, m_wait_time{}, m_closed{ false }, m_mutex{}, m_changed{}, m_full{},
+	m_empty{}, m_error{}, m_closing{ false }, m_io_thread{}
+{
+	if (buffer_size == 0 || buffer_count < 2)
+		throw std::invalid_argument{ "An async_file_writer needs at least two buffers of at least one byte." };
+#ifdef _WIN32
+	m_handle = CreateFileA(m_file_name.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_handle == INVALID_HANDLE_VALUE)
+		throw_write_failure(m_file_name, "CreateFile"sv);
+#else
+	m_descriptor = open(m_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (m_descriptor == -1)
+		throw_write_failure(m_file_name, "open"sv);
+#endif
+	m_current.reserve(buffer_size);
+	m_empty.resize(buffer_count - 1);
+	for (auto& buffer : m_empty)
+	{
+		buffer.reserve(buffer_size);
+	}
+	m_io_thread = std::thread{ [this]() -> void { run_io(); } };
+}
+
+cjm::async_file_writer::~async_file_writer()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+
+	}
+}
+
+void cjm::async_file_writer::write(const char* data, size_t size)
+{
+	assert(!m_closed);
+	while (size > 0)
+	{
+		const size_t copied = std::min(size, m_buffer_size - m_current.size());
+		m_current.insert(m_current.end(), data, data + copied);
+		data += copied;
+		size -= copied;
+		m_bytes_written += copied;
+		if (m_current.size() == m_buffer_size)
+		{
+			submit_current();
+		}
+	}
+}
+
+void cjm::async_file_writer::close()
+{
+	if (m_closed)
+		return;
+	m_closed = true;
+	{
+		auto lock = std::unique_lock{ m_mutex };
+		if (!m_current.empty())
+		{
+			m_full.push_back(std::move(m_current));
+		}
+		m_closing = true;
+	}
+	m_changed.notify_all();
+	const auto wait_start = std::chrono::steady_clock::now();
+	m_io_thread.join();
+	m_wait_time += std::chrono::steady_clock::now() - wait_start;
+#ifdef _WIN32
+	const bool closed = CloseHandle(m_handle) != 0;
+	m_handle = INVALID_HANDLE_VALUE;
+	if (!closed && !m_error)
+		throw_write_failure(m_file_name, "CloseHandle"sv);
+#else
+	const bool closed = ::close(m_descriptor) == 0;
+	m_descriptor = -1;
+	if (!closed && !m_error)
+		throw_write_failure(m_file_name, "close"sv);
+#endif
+	if (m_error)
+		std::rethrow_exception(m_error);
+}
+
+void cjm::async_file_writer::submit_current()
+{
+	{
+		auto lock = std::unique_lock{ m_mutex };
+		if (m_empty.empty() && !m_error)
+		{
+			const auto wait_start = std::chrono::steady_clock::now();
+			m_changed.wait(lock, [this]() -> bool { return !m_empty.empty() || m_error; });
+			m_wait_time += std::chrono::steady_clock::now() - wait_start;
+		}
+		if (m_error)
+			std::rethrow_exception(m_error);
+		m_full.push_back(std::move(m_current));
+		m_current = std::move(m_empty.back());
+		m_empty.pop_back();
+	}
+	m_changed.notify_all();
+}
+
+void cjm::async_file_writer::run_io() noexcept
+{
+	auto lock = std::unique_lock{ m_mutex };
+	while (true)
+	{
+		m_changed.wait(lock, [this]() -> bool { return !m_full.empty() || m_closing; });
+		if (m_full.empty())
+			return;
+		std::vector<char> buffer = std::move(m_full.front());
+		m_full.pop_front();
+		const bool failed = static_cast<bool>(m_error);
+		lock.unlock();
+		//after a failure buffers are only recycled so the writing thread sees the error instead of blocking.
+		try
+		{
+			const char* data = buffer.data();
+			size_t remaining = failed ? 0 : buffer.size();
+			while (remaining > 0)
+			{
+#ifdef _WIN32
+				DWORD written = 0;
+				const auto request = static_cast<DWORD>(std::min<size_t>(remaining, 1 << 30));
+				if (!WriteFile(m_handle, data, request, &written, nullptr))
+					throw_write_failure(m_file_name, "WriteFile"sv);
+#else
+				const ssize_t written = ::write(m_descriptor, data, remaining);
+				if (written < 0 && errno == EINTR)
+					continue;
+				if (written <= 0)
+					throw_write_failure(m_file_name, "write"sv);
+#endif
+				data += written;
+				remaining -= static_cast<size_t>(written);
+			}
+			lock.lock();
+		}
+		catch (...)
+		{
+			lock.lock();
+			m_error = std::current_exception();
+		}
+		buffer.clear();
+		m_empty.push_back(std::move(buffer));
+		m_changed.notify_all();
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef CJM_ASYNC_WRITER_HPP_
+#define CJM_ASYNC_WRITER_HPP_
+#include "helper.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	class async_file_writer;
+
+	//text as it is stored in a text battery file: UTF-8 exactly as a tofstrm_t writes it, or UTF-16LE; either way
+	//with the platform's line ending for each newline.  If starts_file, a UTF-16LE file's byte order mark comes first.
+	std::string to_file_text(tsv_t text, text_encoding encoding = text_encoding::utf8, bool starts_file = false);
+	//appends ops as operator<<(tostrm_t&, const std::vector<binary_operation>&) writes them, stored as by to_file_text.
+	void append_file_text(std::vector<char>& dest, const std::vector<binary_operation>& ops,
+		text_encoding encoding = text_encoding::utf8);
+
+	//Writes a file on a dedicated I/O thread.  Bytes are copied into the current buffer; each full buffer is handed
+	//to the I/O thread, which writes buffers in order while the caller fills the next one.  With buffer_count buffers
+	//the caller blocks only once buffer_count - 1 full buffers are waiting on the disk.  Not thread safe: one thread
+	//writes, others may format what it writes.  An I/O error is rethrown by the next write or by close.
+	class async_file_writer final
+	{
+	public:
+		static constexpr size_t default_buffer_size = 1 << 22;
+		static constexpr size_t default_buffer_count = 2;
+
+		explicit async_file_writer(fsv_t file_name, size_t buffer_size = default_buffer_size,
+			size_t buffer_count = default_buffer_count);
+		async_file_writer(const async_file_writer& other) = delete;
+		async_file_writer(async_file_writer&& other) noexcept = delete;
+		async_file_writer& operator=(const async_file_writer& other) = delete;
+		async_file_writer& operator=(async_file_writer&& other) noexcept = delete;
+		~async_file_writer();
+
+		void write(const char* data, size_t size);
+		void write(const std::vector<char>& bytes) { write(bytes.data(), bytes.size()); }
+		void write(const std::string& bytes) { write(bytes.data(), bytes.size()); }
+		//writes what is buffered, waits for the I/O thread and closes the file.
+		void close();
+		[[nodiscard]] std::uint64_t bytes_written() const noexcept { return m_bytes_written; }
+		//how long the writing thread has blocked waiting for the I/O thread (for a free buffer, or in close)
+		[[nodiscard]] std::chrono::steady_clock::duration wait_time() const noexcept { return m_wait_time; }
+
+	private:
+		void submit_current();
+		void run_io() noexcept;
+
+		fstr_t m_file_name;
+#ifdef _WIN32
+		void* m_handle;
+#else
+		int m_descriptor;
+#endif
+		size_t m_buffer_size;
+		std::vector<char> m_current;
+		std::uint64_t m_bytes_written;
+		std::chrono::steady_clock::duration m_wait_time;
+		bool m_closed;
+		std::mutex m_mutex;
+		std::condition_variable m_changed;
+		std::deque<std::vector<char>> m_full;
+		std::vector<std::vector<char>> m_empty;
+		std::exception_ptr m_error;
+		bool m_closing;
+		std::thread m_io_thread;
+	};
+}
+#endif // CJM_ASYNC_WRITER_HPP_
@@ -0,0 +1,137 @@
+#include "batch.hpp"
+#include <utility>
+
+namespace
+{
+	//a right operand for which Op is defined whatever the left one: it stands in for an undefined row's so the kernels
+	//never divide by zero or shift out of range (a no-op for the kinds that are always defined).
+	template<cjm::binary_op Op>
+	constexpr cjm::int128_t masked_rhs(bool defined, cjm::int128_t rhs) noexcept
+	{
+		constexpr auto stand_in = cjm::int128_t{ Op == cjm::binary_op::divide || Op == cjm::binary_op::modulus ? 1 : 0 };
+		return defined ? rhs : stand_in;
+	}
+
+	template<cjm::binary_op Op>
+	void evaluate_kind(const cjm::int128_t* lhs, const cjm::int128_t* rhs, cjm::int128_t* results, size_t count) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const bool defined = cjm::is_defined(Op, lhs[i], rhs[i]);
+			const cjm::int128_t result = cjm::apply_op<Op>(lhs[i], masked_rhs<Op>(defined, rhs[i]));
+			results[i] = defined ? result : cjm::int128_t{ 0 };
+		}
+	}
+
+	template<cjm::binary_op Op>
+	size_t count_kind_mismatches(const cjm::int128_t* lhs, const cjm::int128_t* rhs, const cjm::int128_t* expected,
+		size_t count) noexcept
+	{
+		size_t ret = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const bool defined = cjm::is_defined(Op, lhs[i], rhs[i]);
+			const bool matches = cjm::apply_op<Op>(lhs[i], masked_rhs<Op>(defined, rhs[i])) == expected[i];
+			ret += static_cast<size_t>(!(defined & matches));
+		}
+		return ret;
+	}
+
+	using evaluator_t = void(*)(const cjm::int128_t*, const cjm::int128_t*, cjm::int128_t*, size_t) noexcept;
+	using mismatch_counter_t = size_t(*)(const cjm::int128_t*, const cjm::int128_t*, const cjm::int128_t*, size_t) noexcept;
+
+	template<size_t... Indices>
+	constexpr std::array<evaluator_t, sizeof...(Indices)> make_evaluators(std::index_sequence<Indices...>) noexcept
+	{
+		return std::array<evaluator_t, sizeof...(Indices)>{ &evaluate_kind<static_cast<cjm::binary_op>(Indices)>... };
+	}
+
+	template<size_t... Indices>
+	constexpr std::array<mismatch_counter_t, sizeof...(Indices)> make_mismatch_counters(std::index_sequence<Indices...>) noexcept
+	{
+		return std::array<mismatch_counter_t, sizeof...(Indices)>{ &count_kind_mismatches<static_cast<cjm::binary_op>(Indices)>... };
+	}
+
+	constexpr std::array<evaluator_t, cjm::binary_op_count> evaluators =
+		make_evaluators(std::make_index_sequence<cjm::binary_op_count>{});
+	constexpr std::array<mismatch_counter_t, cjm::binary_op_count> mismatch_counters =
+		make_mismatch_counters(std::make_index_sequence<cjm::binary_op_count>{});
+}
+
+void cjm::evaluate_batch(binary_op op, const int128_t* lhs, const int128_t* rhs, int128_t* results, size_t count) noexcept
+{
+	assert(static_cast<size_t>(op) < binary_op_count);
+	evaluators[static_cast<size_t>(op)](lhs, rhs, results, count);
+}
+
+size_t cjm::count_mismatches(binary_op op, const int128_t* lhs, const int128_t* rhs, const int128_t* expected, size_t count) noexcept
+{
+	assert(static_cast<size_t>(op) < binary_op_count);
+	return mismatch_counters[static_cast<size_t>(op)](lhs, rhs, expected, count);
+}
+
+cjm::partitioned_batch::partitioned_batch(size_t capacity) : m_capacity{ capacity }, m_ops{}, m_lhs{}, m_rhs{},
+	m_expected{}, m_index{}, m_offsets{}, m_part_lhs{}, m_part_rhs{}, m_part_expected{}, m_part_index{}
+{
+	if (capacity == 0)
+		throw std::invalid_argument{ "Batch capacity must be positive." };
+	m_ops.reserve(capacity);
+	m_lhs.reserve(capacity);
+	m_rhs.reserve(capacity);
+	m_expected.reserve(capacity);
+	m_index.reserve(capacity);
+	m_part_lhs.resize(capacity);
+	m_part_rhs.resize(capacity);
+	m_part_expected.resize(capacity);
+	m_part_index.resize(capacity);
+}
+
+void cjm::partitioned_batch::clear() noexcept
+{
+	m_ops.clear();
+	m_lhs.clear();
+	m_rhs.clear();
+	m_expected.clear();
+	m_index.clear();
+}
+
+void cjm::partitioned_batch::push_back(const binary_operation& op, std::uint64_t index)
+{
+	assert(op.has_result());
+	m_ops.push_back(op.op_code());
+	m_lhs.push_back(op.left_operand());
+	m_rhs.push_back(op.right_operand());
+	m_expected.push_back(op.result().value());
+	m_index.push_back(index);
+}
+
+void cjm::partitioned_batch::partition()
+{
+	const size_t count = m_ops.size();
+	if (m_part_lhs.size() < count)
+	{
+		m_part_lhs.resize(count);
+		m_part_rhs.resize(count);
+		m_part_expected.resize(count);
+		m_part_index.resize(count);
+	}
+	m_offsets.fill(0);
+	for (const binary_op op : m_ops)
+	{
+		++m_offsets[static_cast<size_t>(op) + 1];
+	}
+	for (size_t i = 1; i < m_offsets.size(); ++i)
+	{
+		m_offsets[i] += m_offsets[i - 1];
+	}
+	auto next = std::array<size_t, binary_op_count>{};
+	std::copy_n(m_offsets.cbegin(), binary_op_count, next.begin());
+	for (size_t i = 0; i < count; ++i)
+	{
+		const size_t dest = next[static_cast<size_t>(m_ops[i])]++;
+		m_part_lhs[dest] = m_lhs[i];
+		m_part_rhs[dest] = m_rhs[i];
+		m_part_expected[dest] = m_expected[i];
+		m_part_index[dest] = m_index[i];
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef CJM_BATCH_HPP_
+#define CJM_BATCH_HPP_
+#include "helper.hpp"
+#include <array>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	class partitioned_batch;
+
+	//result of each of count operations of kind op, from operand columns: one tight loop per op kind.  An operation
+	//without a defined result (is_defined) is not evaluated: its result is zero.
+	void evaluate_batch(binary_op op, const int128_t* lhs, const int128_t* rhs, int128_t* results, size_t count) noexcept;
+	//number of the count operations of kind op whose expected result is not the correct one (branch free); an operation
+	//without a defined result has no correct one, so it counts as a mismatch.
+	size_t count_mismatches(binary_op op, const int128_t* lhs, const int128_t* rhs, const int128_t* expected, size_t count) noexcept;
+
+	//Operations (with results) buffered in arrival order and, when verified, partitioned by op kind into structure of
+	//arrays columns (a counting sort) so each kind is checked by its own loop rather than a switch per record.
+	class partitioned_batch final
+	{
+	public:
+		static constexpr size_t default_capacity = 4'096;
+
+		explicit partitioned_batch(size_t capacity = default_capacity);
+
+		[[nodiscard]] size_t size() const noexcept { return m_ops.size(); }
+		[[nodiscard]] bool empty() const noexcept { return m_ops.empty(); }
+		[[nodiscard]] bool full() const noexcept { return m_ops.size() >= m_capacity; }
+		void clear() noexcept;
+
+		//op must have a result; index identifies it to the verify callback.
+		void push_back(const binary_operation& op, std::uint64_t index);
+
+		//checks every buffered result, calls on_failure(index, op) for each incorrect one (grouped by op kind,
+		//not in index order), empties the batch and returns the number of incorrect results.
+		template<typename OnFailure>
+		std::uint64_t verify(OnFailure&& on_failure);
+
+	private:
+		void partition();
+
+		size_t m_capacity;
+		//arrival order
+		std::vector<binary_op> m_ops;
+		std::vector<int128_t> m_lhs;
+		std::vector<int128_t> m_rhs;
+		std::vector<int128_t> m_expected;
+		std::vector<std::uint64_t> m_index;
+		//partitioned by op kind: kind k occupies [m_offsets[k], m_offsets[k + 1])
+		std::array<size_t, binary_op_count + 1> m_offsets;
+		std::vector<int128_t> m_part_lhs;
+		std::vector<int128_t> m_part_rhs;
+		std::vector<int128_t> m_part_expected;
+		std::vector<std::uint64_t> m_part_index;
+	};
+
+	template<typename OnFailure>
+	std::uint64_t partitioned_batch::verify(OnFailure&& on_failure)
+	{
+		partition();
+		std::uint64_t ret = 0;
+		for (size_t op_idx = 0; op_idx < binary_op_count; ++op_idx)
+		{
+			const auto op = static_cast<binary_op>(op_idx);
+			const size_t begin = m_offsets[op_idx];
+			const size_t count = m_offsets[op_idx + 1] - begin;
+			if (count == 0)
+				continue;
+			const size_t mismatches = count_mismatches(op, m_part_lhs.data() + begin, m_part_rhs.data() + begin,
+				m_part_expected.data() + begin, count);
+			if (mismatches == 0)
+				continue;
+			ret += mismatches;
+			for (size_t i = begin; i < begin + count; ++i)
+			{
+				const auto checked = binary_operation{ op, m_part_lhs[i], m_part_rhs[i], m_part_expected[i] };
+				if (!checked.has_correct_result())
+				{
+					on_failure(m_part_index[i], checked);
+				}
+			}
+		}
+		clear();
+		return ret;
+	}
+}
+#endif // CJM_BATCH_HPP_
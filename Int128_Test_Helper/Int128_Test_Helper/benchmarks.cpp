@@ -0,0 +1,681 @@
+#include "benchmarks.hpp"
+#include "hex.hpp"
+#include "parallel.hpp"
+#include "batch.hpp"
+#include "coverage.hpp"
+#include "conversion.hpp"
+#include "mul_div.hpp"
+#include "compressed.hpp"
+#include "differential.hpp"
+#include "reader.hpp"
+#include "mapped_file.hpp"
+#include <typeinfo>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+	//The iostream based formatting serialize(int128_t) used before the table driven formatter in hex.hpp:
+	//kept here as the baseline the formatter is measured against.
+	cjm::tstr_t legacy_serialize(cjm::int128_t value)
+	{
+		cjm::fstr_stream_t stream;
+		std::int64_t high = absl::Int128High64(value);
+		std::uint64_t low = absl::Int128Low64(value);
+		stream << std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill('0')
+			<< low << '\t'
+			<< std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill('0')
+			<< high << '\t';
+		auto temp = stream.str();
+		return cjm::to_tstr_t(temp);
+	}
+
+	void legacy_serialize(cjm::tostrm_t& ostr, cjm::int128_t value)
+	{
+		std::int64_t high = absl::Int128High64(value);
+		std::uint64_t low = absl::Int128Low64(value);
+		ostr << std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill(u'0')
+			<< low << u'\t'
+			<< std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill(u'0')
+			<< high << u'\t';
+	}
+
+	//The split + narrow + stringstream parsing deserialize used before the parser in hex.hpp.
+	std::uint64_t legacy_parse_hex(cjm::tsv_t parse)
+	{
+		cjm::fstr_t converted;
+		converted.reserve(parse.size());
+		for (const cjm::tchar_t c : parse)
+		{
+			if (c > static_cast<cjm::tchar_t>(std::numeric_limits<cjm::fchar_t>::max())) 
+				throw std::invalid_argument{ "character out of range for conversion." };
+			converted.push_back(static_cast<cjm::fchar_t>(c));
+		}
+		std::uint64_t ret = 0;
+		cjm::fstr_stream_t stream;
+		stream.exceptions(std::ios::failbit | std::ios::badbit);
+		stream << std::hex << converted;
+		stream >> ret;
+		return ret;
+	}
+
+	cjm::int128_t legacy_deserialize(cjm::tsv_t deser_me)
+	{
+		auto split = cjm::split(deser_me, u'\t');
+		if (split.size() < 2)
+			throw std::invalid_argument{ "Not enough data in string." };
+		const std::uint64_t low = legacy_parse_hex(split[0]);
+		const auto high = static_cast<std::int64_t>(legacy_parse_hex(split[1]));
+		return absl::MakeInt128(high, low);
+	}
+
+	template<typename Invocable>
+	double time_seconds(Invocable invocable)
+	{
+		const auto start = cjm::bench::bench_clock_t::now();
+		invocable();
+		const auto stop = cjm::bench::bench_clock_t::now();
+		return std::chrono::duration<double>(stop - start).count();
+	}
+
+	//keeps the timed loops' results observable.
+	volatile std::uint64_t bench_sink;
+
+	using op_timer_t = double(*)(const std::vector<cjm::int128_t>& lhs, const std::vector<cjm::int128_t>& rhs);
+
+	template<cjm::binary_op Op>
+	double time_op(const std::vector<cjm::int128_t>& lhs, const std::vector<cjm::int128_t>& rhs)
+	{
+		cjm::int128_t acc = 0;
+		const double ret = time_seconds([&]() -> void
+		{
+			for (size_t i = 0; i < lhs.size(); ++i)
+			{
+				acc ^= cjm::apply_op<Op>(lhs[i], rhs[i]);
+			}
+		});
+		bench_sink = absl::Int128Low64(acc);
+		return ret;
+	}
+
+	template<size_t... Indices>
+	constexpr std::array<op_timer_t, sizeof...(Indices)> make_op_timers(std::index_sequence<Indices...>) noexcept
+	{
+		return std::array<op_timer_t, sizeof...(Indices)>{ &time_op<static_cast<cjm::binary_op>(Indices)>... };
+	}
+	constexpr std::array<op_timer_t, cjm::binary_op_count> op_timers = make_op_timers(std::make_index_sequence<cjm::binary_op_count>{});
+}
+
+double cjm::bench::bench_result::ops_per_second() const noexcept
+{
+	return seconds > 0 ? static_cast<double>(operations) / seconds : 0.0;
+}
+
+double cjm::bench::bench_result::ns_per_op() const noexcept
+{
+	return operations > 0 ? seconds * 1e9 / static_cast<double>(operations) : 0.0;
+}
+
+void cjm::bench::run_benchmark(fsv_t benchmark_name, size_t count, std::uint64_t seed, unsigned thread_count,
+	operand_distribution distribution, const std::optional<fstr_t>& json_file)
+{
+	std::vector<bench_result> results;
+	if (benchmark_name == "coverage"sv)
+	{
+		run_coverage_report(count, seed, thread_count, json_file);
+		return;
+	}
+	if (benchmark_name == "serialize"sv)
+	{
+		results = run_serialize_benchmark(count, seed, thread_count);
+	}
+	else if (benchmark_name == "deserialize"sv)
+	{
+		results = run_deserialize_benchmark(count, seed, thread_count);
+	}
+	else if (benchmark_name == "ops"sv)
+	{
+		results = run_op_benchmark(count, seed, distribution);
+	}
+	else if (benchmark_name == "verify"sv)
+	{
+		results = run_verify_benchmark(count, seed, thread_count, distribution);
+	}
+	else if (benchmark_name == "conversion"sv)
+	{
+		results = run_conversion_benchmark(count, seed);
+	}
+	else if (benchmark_name == "mul_div"sv)
+	{
+		results = run_mul_div_benchmark(count, seed);
+	}
+	else if (benchmark_name == "compression"sv)
+	{
+		results = run_compression_benchmark(count, seed, thread_count);
+	}
+	else if (benchmark_name == "differential"sv)
+	{
+		results = run_differential_benchmark(count, seed, thread_count, distribution);
+	}
+	else if (benchmark_name == "draw"sv)
+	{
+		results = run_draw_benchmark(count, seed, distribution);
+	}
+	else
+	{
+		throw std::domain_error{ "Unrecognized benchmark: ["s + fstr_t{ benchmark_name } + "]."s };
+	}
+
+	if (!json_file.has_value())
+	{
+		print_results(std::cout, benchmark_name, results);
+	}
+	else if (json_file->empty())
+	{
+		print_json(std::cout, benchmark_name, count, seed, distribution, results);
+	}
+	else
+	{
+		auto stream = std::ofstream{};
+		stream.exceptions(std::ios::badbit | std::ios::failbit);
+		stream.open(*json_file, std::ios::trunc);
+		print_json(stream, benchmark_name, count, seed, distribution, results);
+		std::cout << "Wrote results of benchmark [" << benchmark_name << "] to [" << *json_file << "]." << newl;
+	}
+}
+
+std::vector<cjm::bench::bench_result> cjm::bench::run_serialize_benchmark(size_t count, std::uint64_t seed, unsigned thread_count)
+{
+	constexpr auto field_delim = binary_operation_serdeser::item_field_delimiter;
+	auto narrow = bench_result{ "iostream: narrow stringstream + to_tstr_t", 0, 0.0, true };
+	auto wide = bench_result{ "iostream: char16_t std::hex/setw", 0, 0.0, true };
+	auto table = bench_result{ "table driven format_record", 0, 0.0, true };
+
+	auto narrow_text = tstr_t{};
+	auto wide_stream = tstr_stream_t{};
+	auto buffer = std::vector<tchar_t>{};
+	size_t sink = 0;
+	generate_random_blocks(seed, 0, count, thread_count, [&](const std::vector<binary_operation>& block) -> void
+	{
+		narrow.seconds += time_seconds([&]() -> void
+		{
+			narrow_text.clear();
+			for (const binary_operation& op : block)
+			{
+				narrow_text += text(op.op_code()).value();
+				narrow_text += field_delim;
+				narrow_text += legacy_serialize(op.left_operand());
+				narrow_text += field_delim;
+				narrow_text += legacy_serialize(op.right_operand());
+				narrow_text += field_delim;
+				narrow_text += legacy_serialize(op.result().value());
+				narrow_text += field_delim;
+				narrow_text += binary_operation_serdeser::item_delimiter;
+			}
+		});
+		narrow.operations += block.size();
+		sink += narrow_text.size();
+
+		if (wide.supported)
+		{
+			try
+			{
+				wide.seconds += time_seconds([&]() -> void
+				{
+					wide_stream.str(tstr_t{});
+					for (const binary_operation& op : block)
+					{
+						wide_stream << text(op.op_code()).value() << field_delim;
+						legacy_serialize(wide_stream, op.left_operand());
+						wide_stream << field_delim;
+						legacy_serialize(wide_stream, op.right_operand());
+						wide_stream << field_delim;
+						legacy_serialize(wide_stream, op.result().value());
+						wide_stream << field_delim << binary_operation_serdeser::item_delimiter;
+					}
+				});
+				wide.operations += block.size();
+			}
+			catch (const std::bad_cast&)
+			{
+				//this standard library has no num_put<char16_t> facet.
+				wide.supported = false;
+			}
+		}
+
+		table.seconds += time_seconds([&]() -> void
+		{
+			buffer.resize(block.size() * (max_serialized_record_size + 1));
+			tchar_t* dest = buffer.data();
+			for (const binary_operation& op : block)
+			{
+				dest = format_record(dest, op.op_code(), op.left_operand(), op.right_operand(), op.result().value());
+				*dest++ = binary_operation_serdeser::item_delimiter[0];
+			}
+			buffer.resize(static_cast<size_t>(dest - buffer.data()));
+		});
+		table.operations += block.size();
+		sink += buffer.size();
+	});
+	if (sink == 0)
+	{
+		throw std::logic_error{ "Benchmark produced no output." };
+	}
+
+	//whole battery files, generation included: the stream batteries used to be written through and write_random_ops.
+	constexpr fsv_t file_name = "serialize_benchmark.txt"sv;
+	const double stream_seconds = time_seconds([&]() -> void
+	{
+		auto stream = tofstrm_t{};
+		stream.exceptions(std::ios::badbit | std::ios::failbit);
+		stream.open(fstr_t{ file_name });
+		generate_random_blocks(seed, 0, count, thread_count, [&](const std::vector<binary_operation>& block) -> void
+		{
+			stream << block;
+		});
+		stream.close();
+	});
+	const double async_seconds = time_seconds([&]() -> void
+	{
+		write_random_ops("Serialize Benchmark Battery"sv, file_name, count, seed, thread_count, 0, operand_distribution::uniform);
+	});
+	std::remove(file_name.data());
+	auto stream_file = bench_result{ "battery file: tofstrm_t operator<<", count, stream_seconds, true };
+	auto async_file = bench_result{ "battery file: async_file_writer", count, async_seconds, true };
+	return std::vector<bench_result>{narrow, wide, table, stream_file, async_file};
+}
+
+std::vector<cjm::bench::bench_result> cjm::bench::run_deserialize_benchmark(size_t count, std::uint64_t seed, unsigned thread_count)
+{
+	auto legacy = bench_result{ "split + to_fstr_t + stringstream", 0, 0.0, true };
+	auto fast = bench_result{ "try_parse_int128", 0, 0.0, true };
+
+	//each block's operands and results, serialized back to back (serialized_int128_size characters apiece).
+	auto text = tstr_t{};
+	int128_t sink = 0;
+	generate_random_blocks(seed, 0, count, thread_count, [&](const std::vector<binary_operation>& block) -> void
+	{
+		text.resize(block.size() * 3 * serialized_int128_size);
+		tchar_t* dest = text.data();
+		for (const binary_operation& op : block)
+		{
+			dest = format_int128(dest, op.left_operand());
+			dest = format_int128(dest, op.right_operand());
+			dest = format_int128(dest, op.result().value());
+		}
+		const auto values = tsv_t{ text };
+		const size_t value_count = block.size() * 3;
+
+		legacy.seconds += time_seconds([&]() -> void
+		{
+			for (size_t i = 0; i < value_count; ++i)
+			{
+				sink ^= legacy_deserialize(values.substr(i * serialized_int128_size, serialized_int128_size));
+			}
+		});
+		legacy.operations += value_count;
+
+		fast.seconds += time_seconds([&]() -> void
+		{
+			for (size_t i = 0; i < value_count; ++i)
+			{
+				sink ^= deserialize(values.substr(i * serialized_int128_size, serialized_int128_size));
+			}
+		});
+		fast.operations += value_count;
+	});
+	if (sink != 0)
+	{
+		throw std::logic_error{ "Each value was parsed an even number of times: the xor of all of them must be zero." };
+	}
+	return std::vector<bench_result>{legacy, fast};
+}
+
+//Times each binary_op kind over count operands drawn the way cjm_helper_rgen::random_operation draws them for
+//distribution (uniform: full range add/subtract/bitwise/compare, 64 x 64 bit multiply, 128 / 64 bit divide and
+//modulus, 64 bit shifted by [0, 128); wide: 128 x 128 bit multiply, 128 / 128 bit divide and modulus).
+//Operands are generated up front; only the evaluation loop is timed, on the calling thread.
+std::vector<cjm::bench::bench_result> cjm::bench::run_op_benchmark(size_t count, std::uint64_t seed, operand_distribution distribution)
+{
+	auto ret = std::vector<bench_result>{};
+	ret.reserve(binary_op_count);
+	auto lhs = std::vector<int128_t>{};
+	auto rhs = std::vector<int128_t>{};
+	lhs.reserve(count);
+	rhs.reserve(count);
+	for (size_t op_idx = 0; op_idx < binary_op_count; ++op_idx)
+	{
+		const auto op = static_cast<binary_op>(op_idx);
+		auto gen = cjm_helper_rgen::make_rgen(derive_block_seed(seed, op_idx), distribution);
+		lhs.clear();
+		rhs.clear();
+		for (size_t i = 0; i < count; ++i)
+		{
+			const binary_operation operation = gen->random_operation(op);
+			lhs.push_back(operation.left_operand());
+			rhs.push_back(operation.right_operand());
+		}
+		const tsv_t name = op_name_lookup[op_idx];
+		ret.push_back(bench_result{ fstr_t{ name.cbegin(), name.cend() }, count, op_timers[op_idx](lhs, rhs), true });
+	}
+	return ret;
+}
+
+//Checks the results of a mixed random battery one record at a time (a switch per record) and with partitioned_batch.
+std::vector<cjm::bench::bench_result> cjm::bench::run_verify_benchmark(size_t count, std::uint64_t seed, unsigned thread_count,
+	operand_distribution distribution)
+{
+	auto per_record = bench_result{ "has_correct_result per record", 0, 0.0, true };
+	auto batched = bench_result{ "partitioned_batch", 0, 0.0, true };
+	auto batch = partitioned_batch{};
+	std::uint64_t failures = 0;
+	generate_random_blocks(seed, 0, count, thread_count, [&](const std::vector<binary_operation>& block) -> void
+	{
+		per_record.seconds += time_seconds([&]() -> void
+		{
+			for (const binary_operation& op : block)
+			{
+				failures += static_cast<std::uint64_t>(!op.has_correct_result());
+			}
+		});
+		per_record.operations += block.size();
+
+		batched.seconds += time_seconds([&]() -> void
+		{
+			const auto ignore_failure = [](std::uint64_t, const binary_operation&) -> void {};
+			for (size_t i = 0; i < block.size(); ++i)
+			{
+				batch.push_back(block[i], i);
+				if (batch.full())
+					failures += batch.verify(ignore_failure);
+			}
+			failures += batch.verify(ignore_failure);
+		});
+		batched.operations += block.size();
+	}, random_op_block_size, distribution);
+	if (failures != 0)
+	{
+		throw std::logic_error{ "Generated operations must all have correct results." };
+	}
+	return std::vector<bench_result>{per_record, batched};
+}
+
+//Times count TimeSpan -> Stopwatch -> TimeSpan tick round trips (ticks * factor / divisor and back, as two int128
+//multiplies and two divides) at each of the default stopwatch frequencies.  Ticks are drawn up front as a conversion
+//battery draws them; only the round trips are timed.
+std::vector<cjm::bench::bench_result> cjm::bench::run_conversion_benchmark(size_t count, std::uint64_t seed)
+{
+	auto ret = std::vector<bench_result>{};
+	ret.reserve(default_stopwatch_frequencies.size());
+	auto ticks = std::vector<int128_t>(count);
+	for (size_t i = 0; i < default_stopwatch_frequencies.size(); ++i)
+	{
+		const tick_conversion conversion = tick_conversion::for_frequency(default_stopwatch_frequencies[i]);
+		auto engine = std::mt19937_64{ derive_block_seed(seed, i) };
+		std::generate(ticks.begin(), ticks.end(), [&]() -> int128_t
+		{
+			return random_timespan_ticks(engine, conversion.max_ticks);
+		});
+		const double seconds = time_seconds([&]() -> void
+		{
+			int128_t acc = 0;
+			for (const int128_t t : ticks)
+			{
+				acc ^= conversion.to_timespan_ticks(conversion.to_stopwatch_ticks(t));
+			}
+			bench_sink = absl::Int128Low64(acc);
+		});
+		ret.push_back(bench_result{ std::to_string(conversion.frequency) + " Hz round trip", count, seconds, true });
+	}
+	return ret;
+}
+
+//Times a * b / c over count tick conversions as the chained int128 multiply and divide and as the fused mul_div (exact
+//256 bit product), then mul_div over count wide operations whose products need more than 128 bits -- which the
+//chained form gets wrong, so it is not timed there.
+std::vector<cjm::bench::bench_result> cjm::bench::run_mul_div_benchmark(size_t count, std::uint64_t seed)
+{
+	auto chained = bench_result{ "conversions: chained multiply, divide", count, 0.0, true };
+	auto fused = bench_result{ "conversions: fused mul_div", count, 0.0, true };
+	auto wide = bench_result{ "wide operands: fused mul_div", count, 0.0, true };
+	auto ops = std::vector<mul_div_operation>(count);
+	auto engine = std::mt19937_64{ derive_block_seed(seed, 0) };
+	std::generate(ops.begin(), ops.end(), [&]() -> mul_div_operation { return random_conversion_mul_div(engine); });
+	int128_t chained_acc = 0;
+	chained.seconds = time_seconds([&]() -> void
+	{
+		for (const mul_div_operation& op : ops)
+		{
+			chained_acc ^= op.multiplicand() * op.multiplier() / op.divisor();
+		}
+	});
+	int128_t fused_acc = 0;
+	fused.seconds = time_seconds([&]() -> void
+	{
+		for (const mul_div_operation& op : ops)
+		{
+			fused_acc ^= mul_div(op.multiplicand(), op.multiplier(), op.divisor()).value_or(0);
+		}
+	});
+	if (chained_acc != fused_acc)
+	{
+		throw std::logic_error{ "Tick conversion products fit in 128 bits: chained and fused results must agree." };
+	}
+
+	engine.seed(derive_block_seed(seed, 1));
+	std::generate(ops.begin(), ops.end(), [&]() -> mul_div_operation { return random_wide_mul_div(engine); });
+	int128_t wide_acc = 0;
+	wide.seconds = time_seconds([&]() -> void
+	{
+		for (const mul_div_operation& op : ops)
+		{
+			wide_acc ^= mul_div(op.multiplicand(), op.multiplier(), op.divisor()).value_or(0);
+		}
+	});
+	bench_sink = absl::Int128Low64(fused_acc ^ wide_acc);
+	return std::vector<bench_result>{chained, fused, wide};
+}
+
+//Compares the operand coverage of count operations drawn from each operand_distribution with the same seed.
+void cjm::bench::run_coverage_report(size_t count, std::uint64_t seed, unsigned thread_count, const std::optional<fstr_t>& json_file)
+{
+	auto coverages = std::vector<operand_coverage>(operand_distribution_count);
+	for (size_t i = 0; i < operand_distribution_count; ++i)
+	{
+		generate_random_blocks(seed, 0, count, thread_count, [&](const std::vector<binary_operation>& block) -> void
+		{
+			coverages[i].add(block);
+		}, random_op_block_size, static_cast<operand_distribution>(i));
+	}
+
+	if (!json_file.has_value())
+	{
+		std::cout << "Operand coverage of " << count << " operations:" << newl;
+		for (size_t i = 0; i < operand_distribution_count; ++i)
+		{
+			std::cout << "Distribution [" << name(static_cast<operand_distribution>(i)) << "]:" << newl << coverages[i];
+		}
+		return;
+	}
+	auto file = std::ofstream{};
+	if (!json_file->empty())
+	{
+		file.exceptions(std::ios::badbit | std::ios::failbit);
+		file.open(*json_file, std::ios::trunc);
+	}
+	std::ostream& ostr = json_file->empty() ? std::cout : file;
+	ostr << "{" << newl << "\t\"benchmark\": \"coverage\"," << newl << "\t\"count\": " << count << "," << newl
+		<< "\t\"seed\": \"0x" << std::hex << std::setw(sizeof(std::uint64_t) * 2) << std::setfill('0') << seed << std::dec << "\","
+		<< newl << "\t\"distributions\": [";
+	for (size_t i = 0; i < operand_distribution_count; ++i)
+	{
+		const operand_coverage& coverage = coverages[i];
+		ostr << (i == 0 ? "" : ",") << newl << "\t\t{ \"name\": \"" << name(static_cast<operand_distribution>(i))
+			<< "\", \"combinations_hit\": " << coverage.combinations_hit() << ", \"boundary_shifts\": "
+			<< coverage.boundary_shifts() << ", \"buckets\": [";
+		for (size_t bucket = 0; bucket < operand_bucket_count; ++bucket)
+		{
+			ostr << (bucket == 0 ? "" : ",") << newl << "\t\t\t{ \"name\": \"" << bucket_name(bucket) << "\", \"left\": "
+				<< coverage.left_hits(bucket) << ", \"right\": " << coverage.right_hits(bucket) << " }";
+		}
+		ostr << newl << "\t\t] }";
+	}
+	ostr << newl << "\t]" << newl << "}" << newl;
+	if (!json_file->empty())
+	{
+		std::cout << "Wrote operand coverage to [" << *json_file << "]." << newl;
+	}
+}
+
+void cjm::bench::print_results(std::ostream& ostr, fsv_t benchmark_name, const std::vector<bench_result>& results)
+{
+	ostr << "Benchmark [" << benchmark_name << "]:" << newl;
+	for (const bench_result& result : results)
+	{
+		ostr << "\t[" << result.name << "]: ";
+		if (result.supported)
+		{
+			ostr << std::fixed << std::setprecision(0) << result.ops_per_second() << " ops/sec; "
+				<< std::setprecision(2) << result.ns_per_op() << " ns/op (" << std::dec << result.operations << " ops)." << newl;
+		}
+		else
+		{
+			ostr << "not supported by this standard library." << newl;
+		}
+	}
+	ostr << std::defaultfloat;
+}
+
+void cjm::bench::print_json(std::ostream& ostr, fsv_t benchmark_name, size_t count, std::uint64_t seed,
+	operand_distribution distribution, const std::vector<bench_result>& results)
+{
+	ostr << "{" << newl << "\t\"benchmark\": \"" << benchmark_name << "\"," << newl
+		<< "\t\"count\": " << std::dec << count << "," << newl
+		<< "\t\"seed\": \"0x" << std::hex << std::setw(sizeof(std::uint64_t) * 2) << std::setfill('0') << seed << std::dec << "\"," << newl
+		<< "\t\"distribution\": \"" << name(distribution) << "\"," << newl
+		<< "\t\"results\": [";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const bench_result& result = results[i];
+		ostr << (i == 0 ? "" : ",") << newl << "\t\t{ \"name\": \"" << result.name << "\", \"supported\": "
+			<< (result.supported ? "true" : "false") << ", \"operations\": " << result.operations
+			<< std::fixed << std::setprecision(3) << ", \"ns_per_op\": " << result.ns_per_op()
+			<< ", \"ops_per_second\": " << std::setprecision(0) << result.ops_per_second() << " }" << std::defaultfloat;
+	}
+	ostr << newl << "\t]" << newl << "}" << newl;
+}
+
+//Writes and then verifies the same random battery as plain text and as a compressed battery, each end to end from the
+//file system (generation and parsing included); the file sizes are part of the result names.
+std::vector<cjm::bench::bench_result> cjm::bench::run_compression_benchmark(size_t count, std::uint64_t seed, unsigned thread_count)
+{
+	constexpr fsv_t battery_name = "Compression Benchmark Battery"sv;
+	constexpr fsv_t raw_file = "compression_benchmark.txt"sv;
+	constexpr fsv_t compressed_file = "compression_benchmark.cjmz"sv;
+	const double raw_write = time_seconds([&]() -> void
+	{
+		write_random_ops(battery_name, raw_file, count, seed, thread_count, 0, operand_distribution::uniform);
+	});
+	const double compressed_write = time_seconds([&]() -> void
+	{
+		write_compressed_random_ops(battery_name, compressed_file, count, seed, thread_count, 0, operand_distribution::uniform);
+	});
+	const auto raw_size = static_cast<double>(mapped_file{ raw_file }.size());
+	const auto compressed_size = static_cast<double>(mapped_file{ compressed_file }.size());
+
+	std::uint64_t failures = 0;
+	const double raw_verify = time_seconds([&]() -> void
+	{
+		failures += verify_battery(raw_file, thread_count).failures;
+	});
+	const double compressed_verify = time_seconds([&]() -> void
+	{
+		failures += verify_battery(compressed_file, thread_count).failures;
+	});
+	std::remove(raw_file.data());
+	std::remove(compressed_file.data());
+	if (failures != 0)
+	{
+		throw std::logic_error{ "Generated operations must all have correct results." };
+	}
+
+	fstr_stream_t raw_name;
+	raw_name << std::fixed << std::setprecision(1) << "text (" << raw_size / 1e6 << " MB)";
+	fstr_stream_t compressed_name;
+	compressed_name << std::fixed << std::setprecision(1) << "lz4 frames (" << compressed_size / 1e6 << " MB, "
+		<< std::setprecision(2) << raw_size / compressed_size << "x)";
+	return std::vector<bench_result>{
+		bench_result{ "write " + raw_name.str(), count, raw_write, true },
+		bench_result{ "write " + compressed_name.str(), count, compressed_write, true },
+		bench_result{ "verify " + raw_name.str(), count, raw_verify, true },
+		bench_result{ "verify " + compressed_name.str(), count, compressed_verify, true } };
+}
+
+//Evaluates a random battery under every int128 backend (see run_differential) and reports each backend's ns/op; any
+//disagreement with absl::int128 is written to std::cerr and fails the benchmark.
+std::vector<cjm::bench::bench_result> cjm::bench::run_differential_benchmark(size_t count, std::uint64_t seed,
+	unsigned thread_count, operand_distribution distribution)
+{
+	const differential_summary summary = run_differential(count, seed, thread_count, 0, distribution);
+	if (!summary.passed())
+	{
+		std::cerr << summary;
+		throw std::runtime_error{ "The int128 backends disagree on " + std::to_string(summary.disagreements) + " records." };
+	}
+	auto ret = std::vector<bench_result>{};
+	ret.reserve(summary.timings.size());
+	for (const backend_timing& timing : summary.timings)
+	{
+		const fsv_t backend_name = name(timing.backend);
+		ret.push_back(bench_result{ fstr_t{ backend_name } + (timing.backend == summary.fastest() ? " (fastest)" : ""),
+			timing.operations, timing.seconds, timing.available });
+	}
+	return ret;
+}
+
+//Draw rates of each rgen_engine on one thread, for count draws of each kind.  The kinds are raw 64 bit outputs, op
+//codes (values in [0, binary_op_count): std::uniform_int_distribution for mt19937_64, bounded_uniform for xoshiro256**)
+//and whole operations from cjm_helper_rgen::random_operation with distribution.
+std::vector<cjm::bench::bench_result> cjm::bench::run_draw_benchmark(size_t count, std::uint64_t seed,
+	operand_distribution distribution)
+{
+	auto ret = std::vector<bench_result>{};
+	ret.reserve(3 * rgen_engine_count);
+	const auto time_engine = [&](rgen_engine engine, auto& bits, auto&& draw_op_code) -> void
+	{
+		const fstr_t prefix = fstr_t{ name(engine) } + ": ";
+		std::uint64_t acc = 0;
+		ret.push_back(bench_result{ prefix + "64 bit outputs", count, time_seconds([&]() -> void
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				acc ^= bits();
+			}
+		}), true });
+		ret.push_back(bench_result{ prefix + "op codes", count, time_seconds([&]() -> void
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				acc += draw_op_code();
+			}
+		}), true });
+		auto gen = cjm_helper_rgen::make_rgen(seed, distribution, engine);
+		ret.push_back(bench_result{ prefix + "random_operation (" + fstr_t{ name(distribution) } + ")", count,
+			time_seconds([&]() -> void
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				acc ^= absl::Uint128Low64(gen->random_operation().left_operand());
+			}
+		}), true });
+		bench_sink = acc;
+	};
+
+	auto twister = std::mt19937_64{ seed };
+	auto op_distrib = std::uniform_int_distribution<std::uint64_t>{ 0, binary_op_count - 1 };
+	time_engine(rgen_engine::mt19937_64, twister, [&]() -> std::uint64_t { return op_distrib(twister); });
+	auto xoshiro = xoshiro256ss{ seed };
+	time_engine(rgen_engine::xoshiro256ss, xoshiro, [&]() -> std::uint64_t { return bounded_uniform(xoshiro, binary_op_count); });
+	return ret;
+}
@@ -0,0 +1,43 @@
+#ifndef CJM_BENCHMARKS_HPP_
+#define CJM_BENCHMARKS_HPP_
+#include "helper.hpp"
+#include <chrono>
+#include <optional>
+#include <ostream>
+#include <vector>
+namespace cjm::bench
+{
+	using bench_clock_t = std::chrono::steady_clock;
+
+	struct bench_result final
+	{
+		fstr_t name;
+		std::uint64_t operations;
+		double seconds;
+		bool supported;
+
+		[[nodiscard]] double ops_per_second() const noexcept;
+		[[nodiscard]] double ns_per_op() const noexcept;
+	};
+
+	void run_benchmark(fsv_t benchmark_name, size_t count, std::uint64_t seed, unsigned thread_count,
+		operand_distribution distribution = operand_distribution::uniform, const std::optional<fstr_t>& json_file = std::nullopt);
+	std::vector<bench_result> run_serialize_benchmark(size_t count, std::uint64_t seed, unsigned thread_count);
+	std::vector<bench_result> run_deserialize_benchmark(size_t count, std::uint64_t seed, unsigned thread_count);
+	std::vector<bench_result> run_op_benchmark(size_t count, std::uint64_t seed,
+		operand_distribution distribution = operand_distribution::uniform);
+	std::vector<bench_result> run_verify_benchmark(size_t count, std::uint64_t seed, unsigned thread_count,
+		operand_distribution distribution = operand_distribution::uniform);
+	std::vector<bench_result> run_conversion_benchmark(size_t count, std::uint64_t seed);
+	std::vector<bench_result> run_mul_div_benchmark(size_t count, std::uint64_t seed);
+	std::vector<bench_result> run_compression_benchmark(size_t count, std::uint64_t seed, unsigned thread_count);
+	std::vector<bench_result> run_differential_benchmark(size_t count, std::uint64_t seed, unsigned thread_count,
+		operand_distribution distribution = operand_distribution::uniform);
+	std::vector<bench_result> run_draw_benchmark(size_t count, std::uint64_t seed,
+		operand_distribution distribution = operand_distribution::uniform);
+	void run_coverage_report(size_t count, std::uint64_t seed, unsigned thread_count, const std::optional<fstr_t>& json_file);
+	void print_results(std::ostream& ostr, fsv_t benchmark_name, const std::vector<bench_result>& results);
+	void print_json(std::ostream& ostr, fsv_t benchmark_name, size_t count, std::uint64_t seed, operand_distribution distribution,
+		const std::vector<bench_result>& results);
+}
+#endif // CJM_BENCHMARKS_HPP_
@@ -0,0 +1,364 @@
+#include "binary_format.hpp"
+#include "parallel.hpp"
+#include "monitor.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	using crc_table_t = std::array<std::array<std::uint32_t, 256>, 8>;
+
+	//slicing by 8: crc_tables[k][b] is the crc of byte b followed by k zero bytes, so eight bytes are folded in at once.
+	constexpr crc_table_t init_crc_tables() noexcept
+	{
+		crc_table_t tables{};
+		for (std::uint32_t i = 0; i < tables[0].size(); ++i)
+		{
+			std::uint32_t r = i;
+			for (int j = 0; j < 8; ++j)
+			{
+				r = (r >> 1) ^ (0xedb8'8320u & (0u - (r & 1u)));
+			}
+			tables[0][i] = r;
+		}
+		for (size_t k = 1; k < tables.size(); ++k)
+		{
+			for (size_t i = 0; i < tables[k].size(); ++i)
+			{
+				const std::uint32_t previous = tables[k - 1][i];
+				tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xffu];
+			}
+		}
+		return tables;
+	}
+	constexpr crc_table_t crc_tables = init_crc_tables();
+	constexpr const std::array<std::uint32_t, 256>& crc_table = crc_tables[0];
+
+	using gf2_matrix_t = std::array<std::uint32_t, 32>;
+
+	std::uint32_t gf2_matrix_times(const gf2_matrix_t& matrix, std::uint32_t vector) noexcept
+	{
+		std::uint32_t ret = 0;
+		for (size_t i = 0; vector != 0; ++i, vector >>= 1)
+		{
+			ret ^= matrix[i] & (0u - (vector & 1u));
+		}
+		return ret;
+	}
+
+	gf2_matrix_t gf2_matrix_square(const gf2_matrix_t& matrix) noexcept
+	{
+		gf2_matrix_t ret{};
+		for (size_t i = 0; i < ret.size(); ++i)
+		{
+			ret[i] = gf2_matrix_times(matrix, matrix[i]);
+		}
+		return ret;
+	}
+
+	void write_le(unsigned char* dest, std::uint64_t value, size_t bytes) noexcept
+	{
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			dest[i] = static_cast<unsigned char>(value >> (8 * i));
+		}
+	}
+
+	std::uint64_t read_le(const unsigned char* src, size_t bytes) noexcept
+	{
+		std::uint64_t ret = 0;
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			ret |= static_cast<std::uint64_t>(src[i]) << (8 * i);
+		}
+		return ret;
+	}
+
+	void write_int128(unsigned char* dest, cjm::int128_t value) noexcept
+	{
+		write_le(dest, absl::Int128Low64(value), sizeof(std::uint64_t));
+		write_le(dest + sizeof(std::uint64_t), static_cast<std::uint64_t>(absl::Int128High64(value)), sizeof(std::uint64_t));
+	}
+
+	cjm::int128_t read_int128(const unsigned char* src) noexcept
+	{
+		const std::uint64_t low = read_le(src, sizeof(std::uint64_t));
+		const auto high = static_cast<std::int64_t>(read_le(src + sizeof(std::uint64_t), sizeof(std::uint64_t)));
+		return absl::MakeInt128(high, low);
+	}
+}
+
+void cjm::crc32::update(const unsigned char* data, size_t size) noexcept
+{
+	std::uint32_t state = m_state;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		const std::uint32_t low = state ^ static_cast<std::uint32_t>(read_le(data + i, 4));
+		const auto high = static_cast<std::uint32_t>(read_le(data + i + 4, 4));
+		state = crc_tables[7][low & 0xffu] ^ crc_tables[6][(low >> 8) & 0xffu]
+			^ crc_tables[5][(low >> 16) & 0xffu] ^ crc_tables[4][low >> 24]
+			^ crc_tables[3][high & 0xffu] ^ crc_tables[2][(high >> 8) & 0xffu]
+			^ crc_tables[1][(high >> 16) & 0xffu] ^ crc_tables[0][high >> 24];
+	}
+	for (; i < size; ++i)
+	{
+		state = (state >> 8) ^ crc_table[(state ^ data[i]) & 0xffu];
+	}
+	m_state = state;
+}
+
+std::uint32_t cjm::crc32::combine(std::uint32_t first, std::uint32_t second, std::uint64_t second_size) noexcept
+{
+	if (second_size == 0)
+		return first;
+	//operator advancing a crc by one zero bit, squared repeatedly to advance it by second_size zero bytes.
+	gf2_matrix_t odd{};
+	odd[0] = 0xedb8'8320u;
+	for (size_t i = 1; i < odd.size(); ++i)
+	{
+		odd[i] = std::uint32_t{ 1 } << (i - 1);
+	}
+	gf2_matrix_t even = gf2_matrix_square(odd);
+	odd = gf2_matrix_square(even);
+	do
+	{
+		even = gf2_matrix_square(odd);
+		if (second_size & 1u)
+			first = gf2_matrix_times(even, first);
+		second_size >>= 1;
+		if (second_size == 0)
+			break;
+		odd = gf2_matrix_square(even);
+		if (second_size & 1u)
+			first = gf2_matrix_times(odd, first);
+		second_size >>= 1;
+	} while (second_size != 0);
+	return first ^ second;
+}
+
+void cjm::binary_battery_header::set_engine_name(fsv_t name) noexcept
+{
+	engine_name.fill('\0');
+	std::copy_n(name.cbegin(), std::min(name.size(), engine_name.size()), engine_name.begin());
+}
+
+void cjm::binary_battery_header::write_to(unsigned char* dest) const noexcept
+{
+	std::memset(dest, 0, size);
+	std::memcpy(dest, magic.data(), magic.size());
+	write_le(dest + 8, version, sizeof(std::uint32_t));
+	write_le(dest + 12, size, sizeof(std::uint32_t));
+	write_le(dest + 16, record_size, sizeof(std::uint32_t));
+	write_le(dest + 20, crc, sizeof(std::uint32_t));
+	write_le(dest + 24, count, sizeof(std::uint64_t));
+	write_le(dest + 32, seed, sizeof(std::uint64_t));
+	write_le(dest + 40, first_record, sizeof(std::uint64_t));
+	write_le(dest + 48, block_size, sizeof(std::uint64_t));
+	std::memcpy(dest + 56, engine_name.data(), engine_name.size());
+	dest[72] = static_cast<unsigned char>(distribution);
+}
+
+cjm::binary_battery_header cjm::binary_battery_header::read_from(const unsigned char* src)
+{
+	if (std::memcmp(src, magic.data(), magic.size()) != 0)
+		throw std::invalid_argument{ "The data is not a binary operation battery." };
+	binary_battery_header ret;
+	ret.version = static_cast<std::uint32_t>(read_le(src + 8, sizeof(std::uint32_t)));
+	const auto header_size = read_le(src + 12, sizeof(std::uint32_t));
+	ret.record_size = static_cast<std::uint32_t>(read_le(src + 16, sizeof(std::uint32_t)));
+	if (ret.version != current_version || header_size != size || ret.record_size != binary_record_size)
+		throw std::invalid_argument{ "The binary operation battery has an unsupported version or layout." };
+	ret.crc = static_cast<std::uint32_t>(read_le(src + 20, sizeof(std::uint32_t)));
+	ret.count = read_le(src + 24, sizeof(std::uint64_t));
+	ret.seed = read_le(src + 32, sizeof(std::uint64_t));
+	ret.first_record = read_le(src + 40, sizeof(std::uint64_t));
+	ret.block_size = read_le(src + 48, sizeof(std::uint64_t));
+	std::memcpy(ret.engine_name.data(), src + 56, ret.engine_name.size());
+	if (src[72] >= operand_distribution_count)
+		throw std::invalid_argument{ "The binary operation battery has an unrecognized operand distribution." };
+	ret.distribution = static_cast<operand_distribution>(src[72]);
+	return ret;
+}
+
+void cjm::write_binary_record(unsigned char* dest, const binary_operation& op)
+{
+	int128_t result;
+	if (op.has_result())
+	{
+		result = op.result().value();
+	}
+	else
+	{
+		auto temp = op;
+		temp.calculate_result();
+		result = temp.result().value();
+	}
+	dest[0] = static_cast<unsigned char>(op.op_code());
+	write_int128(dest + 1, op.left_operand());
+	write_int128(dest + 1 + binary_int128_size, op.right_operand());
+	write_int128(dest + 1 + 2 * binary_int128_size, result);
+}
+
+cjm::binary_operation cjm::read_binary_record(const unsigned char* src)
+{
+	if (src[0] >= binary_op_count)
+		throw std::invalid_argument{ "The binary record contains an unrecognized op code." };
+	return binary_operation{ static_cast<binary_op>(src[0]), read_int128(src + 1),
+		read_int128(src + 1 + binary_int128_size), read_int128(src + 1 + 2 * binary_int128_size) };
+}
+
+cjm::binary_battery_writer::binary_battery_writer(fsv_t file_name, const binary_battery_header& header)
+	: m_stream{}, m_header{ header }, m_crc{}, m_buffer{}, m_closed{ false }
+{
+	m_header.count = 0;
+	m_header.crc = 0;
+	m_stream.exceptions(std::ios::badbit | std::ios::failbit);
+	m_stream.open(fstr_t{ file_name }, std::ios::binary | std::ios::trunc);
+	auto header_bytes = std::array<unsigned char, binary_battery_header::size>{};
+	m_header.write_to(header_bytes.data());
+	m_stream.write(reinterpret_cast<const char*>(header_bytes.data()), header_bytes.size());
+}
+
+cjm::binary_battery_writer::~binary_battery_writer()
+{
+	//only an explicit close() finalizes the header: a writer abandoned part way (e.g. by an exception) leaves the
+	//record count at zero so the partial file fails --verify instead of passing as a shorter battery.
+	try
+	{
+		if (!m_closed)
+		{
+			m_closed = true;
+			m_stream.close();
+		}
+	}
+	catch (...)
+	{
+
+	}
+}
+
+void cjm::binary_battery_writer::write(const std::vector<binary_operation>& ops)
+{
+	assert(!m_closed);
+	m_buffer.resize(ops.size() * binary_record_size);
+	unsigned char* dest = m_buffer.data();
+	for (const binary_operation& op : ops)
+	{
+		write_binary_record(dest, op);
+		dest += binary_record_size;
+	}
+	m_crc.update(m_buffer.data(), m_buffer.size());
+	m_stream.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+	m_header.count += ops.size();
+}
+
+void cjm::binary_battery_writer::close()
+{
+	if (m_closed)
+		return;
+	m_closed = true;
+	m_header.crc = m_crc.value();
+	auto header_bytes = std::array<unsigned char, binary_battery_header::size>{};
+	m_header.write_to(header_bytes.data());
+	m_stream.seekp(0);
+	m_stream.write(reinterpret_cast<const char*>(header_bytes.data()), header_bytes.size());
+	m_stream.close();
+}
+
+std::vector<cjm::binary_operation> cjm::load_binary_battery(fsv_t file_name)
+{
+	auto stream = std::ifstream{};
+	stream.exceptions(std::ios::badbit | std::ios::failbit);
+	stream.open(fstr_t{ file_name }, std::ios::binary);
+	auto header_bytes = std::array<unsigned char, binary_battery_header::size>{};
+	stream.read(reinterpret_cast<char*>(header_bytes.data()), header_bytes.size());
+	const binary_battery_header header = binary_battery_header::read_from(header_bytes.data());
+	//the header is not verified yet: check its count against the file before reserving for it.
+	stream.seekg(0, std::ios::end);
+	const std::uint64_t payload_size = static_cast<std::uint64_t>(stream.tellg()) - binary_battery_header::size;
+	stream.seekg(static_cast<std::streamoff>(binary_battery_header::size));
+	if (payload_size / binary_record_size < header.count)
+		throw std::invalid_argument{ "The binary operation battery contains fewer records than its header declares." };
+
+	auto ret = std::vector<binary_operation>{};
+	ret.reserve(static_cast<size_t>(header.count));
+	auto crc = crc32{};
+	auto buffer = std::vector<unsigned char>(random_op_block_size * binary_record_size);
+	std::uint64_t remaining = header.count;
+	while (remaining > 0)
+	{
+		const size_t records = static_cast<size_t>(std::min<std::uint64_t>(remaining, random_op_block_size));
+		const size_t bytes = records * binary_record_size;
+		stream.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(bytes));
+		crc.update(buffer.data(), bytes);
+		for (size_t i = 0; i < records; ++i)
+		{
+			ret.emplace_back(read_binary_record(buffer.data() + i * binary_record_size));
+			if (!ret.back().is_defined())
+			{
+				throw std::invalid_argument{ "Record " + std::to_string(ret.size() - 1)
+					+ " of the binary operation battery has no defined result." };
+			}
+		}
+		remaining -= records;
+	}
+	if (stream.peek() != std::ifstream::traits_type::eof())
+		throw std::invalid_argument{ "The binary operation battery contains more data than its header declares." };
+	if (crc.value() != header.crc)
+		throw std::invalid_argument{ "The binary operation battery failed its crc check." };
+	return ret;
+}
+
+std::uint32_t cjm::write_random_ops_binary(fsv_t file_name, size_t count, std::uint64_t seed, unsigned thread_count,
+	std::uint64_t first_record, operand_distribution distribution, rgen_engine engine, generation_monitor* monitor)
+{
+	auto header = binary_battery_header{};
+	header.seed = seed;
+	header.first_record = first_record;
+	header.distribution = distribution;
+	header.block_size = random_op_block_size;
+	header.set_engine_name(name(engine));
+	auto writer = binary_battery_writer{ file_name, header };
+	generate_random_blocks(seed, first_record, count, thread_count, [&](const std::vector<binary_operation>& block) -> void
+	{
+		{
+			const auto timer = stage_timer{ monitor, generation_stage::io_wait, block.size() * binary_record_size };
+			writer.write(block);
+		}
+		if (monitor)
+			monitor->complete(block.size());
+	}, random_op_block_size, distribution, engine, monitor);
+	const auto timer = stage_timer{ monitor, generation_stage::io_wait, 0 };
+	writer.close();
+	return writer.crc();
+}
+
+void cjm::serialize_random_ops_binary(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+	unsigned thread_count, std::uint64_t first_record, operand_distribution distribution, rgen_engine engine,
+	generation_monitor* monitor)
+{
+	if (file_name.empty())
+	{
+		throw std::invalid_argument{ "File name supplied cannot be empty." };
+	}
+	if (count == 0)
+	{
+		throw std::invalid_argument{ "Count of operations must be positive." };
+	}
+	try
+	{
+		std::cout << "Saving " << count << " operations of " << test_battery_name << " in binary format to file [" << file_name << "] using "
+			<< resolve_thread_count(thread_count) << " threads... ";
+		write_random_ops_binary(file_name, count, seed, thread_count, first_record, distribution, engine, monitor);
+	}
+	catch (const std::exception& ex)
+	{
+		fstr_stream_t message;
+		message << "Unable to save "sv << test_battery_name << " to file "sv << file_name
+			<< " because of exception: ["sv << ex.what() << "]."sv;
+		throw std::runtime_error{ message.str() };
+	}
+	std::cout << " successfully saved battery " << test_battery_name << " to file: [" << file_name << "]." << newl;
+}
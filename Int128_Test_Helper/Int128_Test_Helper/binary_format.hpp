@@ -0,0 +1,98 @@
+#ifndef CJM_BINARY_FORMAT_HPP_
+#define CJM_BINARY_FORMAT_HPP_
+#include "helper.hpp"
+#include <array>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	//Fixed width little endian battery format:
+	//	header (binary_battery_header::size bytes) followed by count records of binary_record_size bytes:
+	//	[0] op code, [1, 17) left operand, [17, 33) right operand, [33, 49) result.
+	//	Each int128 is stored as its low 64 bits followed by its high 64 bits (same order as the text format).
+	constexpr size_t binary_int128_size = 16;
+	constexpr size_t binary_record_size = 1 + 3 * binary_int128_size;
+
+	class crc32;
+	struct binary_battery_header;
+	class binary_battery_writer;
+
+	void write_binary_record(unsigned char* dest, const binary_operation& op);
+	binary_operation read_binary_record(const unsigned char* src);
+	std::vector<binary_operation> load_binary_battery(fsv_t file_name);
+	void serialize_random_ops_binary(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+		unsigned thread_count = 0, std::uint64_t first_record = 0,
+		operand_distribution distribution = operand_distribution::uniform, rgen_engine engine = rgen_engine::mt19937_64,
+		generation_monitor* monitor = nullptr);
+
+	//serialize_random_ops_binary without the progress messages; returns the crc of the records.  The writes are
+	//synchronous: monitor (if not null) counts them as io_wait.
+	std::uint32_t write_random_ops_binary(fsv_t file_name, size_t count, std::uint64_t seed, unsigned thread_count,
+		std::uint64_t first_record, operand_distribution distribution, rgen_engine engine = rgen_engine::mt19937_64,
+		generation_monitor* monitor = nullptr);
+
+	//CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) -- same checksum as BigMath/Utils/Crc32.cs.
+	class crc32 final
+	{
+	public:
+		void update(const unsigned char* data, size_t size) noexcept;
+		[[nodiscard]] std::uint32_t value() const noexcept { return ~m_state; }
+		//crc of the concatenation of two byte ranges given the crc of each and the size of the second (as in zlib).
+		[[nodiscard]] static std::uint32_t combine(std::uint32_t first, std::uint32_t second, std::uint64_t second_size) noexcept;
+	private:
+		std::uint32_t m_state = 0xffff'ffff;
+	};
+
+	//Layout (all integers little endian):
+	//	[0, 8) magic, [8, 12) version, [12, 16) header size, [16, 20) record size, [20, 24) crc32 of all records,
+	//	[24, 32) record count, [32, 40) seed, [40, 48) first record, [48, 56) block size,
+	//	[56, 72) engine name (nul padded), [72] operand distribution (zero: uniform), [73, 80) reserved (zero).
+	struct binary_battery_header final
+	{
+		static constexpr std::array<char, 8> magic = { 'C', 'J', 'M', 'I', '1', '2', '8', 'B' };
+		static constexpr std::uint32_t current_version = 1;
+		static constexpr size_t size = 80;
+		static constexpr size_t engine_name_size = 16;
+
+		std::uint32_t version = current_version;
+		std::uint32_t record_size = static_cast<std::uint32_t>(binary_record_size);
+		std::uint32_t crc = 0;
+		std::uint64_t count = 0;
+		std::uint64_t seed = 0;
+		std::uint64_t first_record = 0;
+		std::uint64_t block_size = 0;
+		std::array<char, engine_name_size> engine_name{};
+		operand_distribution distribution = operand_distribution::uniform;
+
+		void set_engine_name(fsv_t name) noexcept;
+		void write_to(unsigned char* dest) const noexcept;
+		static binary_battery_header read_from(const unsigned char* src);
+	};
+
+	//Writes records as they arrive; the record count and crc in the header are patched in by close().
+	class binary_battery_writer final
+	{
+	public:
+		binary_battery_writer(fsv_t file_name, const binary_battery_header& header);
+		binary_battery_writer(const binary_battery_writer& other) = delete;
+		binary_battery_writer(binary_battery_writer&& other) noexcept = delete;
+		binary_battery_writer& operator=(const binary_battery_writer& other) = delete;
+		binary_battery_writer& operator=(binary_battery_writer&& other) noexcept = delete;
+		~binary_battery_writer();
+
+		void write(const std::vector<binary_operation>& ops);
+		//writes the record count and crc into the header; a writer destroyed without close() leaves them zero.
+		void close();
+		[[nodiscard]] std::uint64_t count() const noexcept { return m_header.count; }
+		[[nodiscard]] std::uint32_t crc() const noexcept { return m_crc.value(); }
+
+	private:
+		std::ofstream m_stream;
+		binary_battery_header m_header;
+		crc32 m_crc;
+		std::vector<unsigned char> m_buffer;
+		bool m_closed;
+	};
+}
+#endif // CJM_BINARY_FORMAT_HPP_
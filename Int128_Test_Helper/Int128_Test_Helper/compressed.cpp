@@ -0,0 +1,515 @@
+#include "compressed.hpp"
+#include "binary_format.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	constexpr size_t min_match = 4;
+	//the compressor only takes matches of at least this many bytes: random hex digits repeat shorter sequences too often
+	//for their matches to pay for a sequence apiece.
+	constexpr size_t min_search_match = 6;
+	//the last sequence is literals only: a match may not start within mf_limit bytes of the end, nor reach into the
+	//last last_literals bytes.
+	constexpr size_t mf_limit = 12;
+	constexpr size_t last_literals = 5;
+	constexpr size_t max_offset = 65535;
+	constexpr int hash_log = 14;
+
+	void write_le(unsigned char* dest, std::uint64_t value, size_t bytes) noexcept
+	{
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			dest[i] = static_cast<unsigned char>(value >> (8 * i));
+		}
+	}
+
+	std::uint64_t read_le(const unsigned char* src, size_t bytes) noexcept
+	{
+		std::uint64_t ret = 0;
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			ret |= static_cast<std::uint64_t>(src[i]) << (8 * i);
+		}
+		return ret;
+	}
+
+	std::uint64_t read_u64(const unsigned char* src) noexcept
+	{
+		std::uint64_t ret = 0;
+		std::memcpy(&ret, src, sizeof(ret));
+		return ret;
+	}
+
+	bool same_prefix(const unsigned char* lhs, const unsigned char* rhs) noexcept
+	{
+		static_assert(min_search_match == 6, "same_prefix compares six bytes.");
+		std::uint32_t lhs_head = 0, rhs_head = 0;
+		std::uint16_t lhs_tail = 0, rhs_tail = 0;
+		std::memcpy(&lhs_head, lhs, sizeof(lhs_head));
+		std::memcpy(&rhs_head, rhs, sizeof(rhs_head));
+		std::memcpy(&lhs_tail, lhs + sizeof(lhs_head), sizeof(lhs_tail));
+		std::memcpy(&rhs_tail, rhs + sizeof(rhs_head), sizeof(rhs_tail));
+		return lhs_head == rhs_head && lhs_tail == rhs_tail;
+	}
+
+	//of (on little endian machines) the min_search_match bytes at src.
+	size_t hash_at(const unsigned char* src) noexcept
+	{
+		return static_cast<size_t>(((read_u64(src) << (64 - 8 * min_search_match)) * 0xcf1b'bcdc'bb5d'7c3dull) >> (64 - hash_log));
+	}
+
+	//the lengths that do not fit in a token nibble continue in bytes of 255 and a final byte of less.
+	unsigned char* write_length(unsigned char* dest, size_t length) noexcept
+	{
+		while (length >= 255)
+		{
+			*dest++ = 255;
+			length -= 255;
+		}
+		*dest++ = static_cast<unsigned char>(length);
+		return dest;
+	}
+
+	unsigned char* write_sequence(unsigned char* dest, const unsigned char* literals, size_t literal_length, size_t offset,
+		size_t match_length) noexcept
+	{
+		unsigned char* const token = dest++;
+		const size_t match_code = match_length - min_match;
+		*token = static_cast<unsigned char>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+		if (literal_length >= 15)
+			dest = write_length(dest, literal_length - 15);
+		std::memcpy(dest, literals, literal_length);
+		dest += literal_length;
+		write_le(dest, offset, 2);
+		dest += 2;
+		if (match_code >= 15)
+			dest = write_length(dest, match_code - 15);
+		return dest;
+	}
+
+	[[noreturn]] void throw_corrupt_block()
+	{
+		throw std::invalid_argument{ "The compressed frame is not a valid LZ4 block." };
+	}
+
+	size_t read_length(const unsigned char*& src, const unsigned char* end)
+	{
+		size_t ret = 0;
+		unsigned char next = 255;
+		while (next == 255)
+		{
+			if (src == end)
+				throw_corrupt_block();
+			next = *src++;
+			ret += next;
+		}
+		return ret;
+	}
+
+	//the end of the last line beginning in [begin, limit) that also ends there, or else of the first line ending after limit.
+	size_t frame_end(const char* text, size_t size, size_t begin, size_t limit, cjm::text_encoding encoding) noexcept
+	{
+		const size_t unit = encoding == cjm::text_encoding::utf16le ? 2 : 1;
+		const auto is_line_end = [&](size_t pos) -> bool
+		{
+			return text[pos] == '\n' && (unit == 1 || (pos % 2 == 0 && pos + 1 < size && text[pos + 1] == '\0'));
+		};
+		for (size_t pos = limit - unit + 1; pos-- > begin;)
+		{
+			if (is_line_end(pos))
+				return pos + unit;
+		}
+		for (size_t pos = limit; pos < size; ++pos)
+		{
+			if (is_line_end(pos))
+				return pos + unit;
+		}
+		return size;
+	}
+}
+
+size_t cjm::lz4::compress(const unsigned char* src, size_t size, unsigned char* dest)
+{
+	unsigned char* out = dest;
+	const unsigned char* anchor = src;
+	if (size > mf_limit)
+	{
+		auto table = std::vector<std::uint32_t>(size_t{ 1 } << hash_log, 0);
+		const unsigned char* const match_start_limit = src + size - mf_limit;
+		const unsigned char* const match_end_limit = src + size - last_literals;
+		const unsigned char* in = src + 1;
+		table[hash_at(src)] = 0;
+		while (in <= match_start_limit)
+		{
+			const size_t slot = hash_at(in);
+			const unsigned char* match = src + table[slot];
+			table[slot] = static_cast<std::uint32_t>(in - src);
+			if (match >= in || static_cast<size_t>(in - match) > max_offset || !same_prefix(match, in))
+			{
+				//skip ahead faster the longer nothing has matched.
+				in += 1 + (static_cast<size_t>(in - anchor) >> 6);
+				continue;
+			}
+			while (in > anchor && match > src && in[-1] == match[-1])
+			{
+				--in;
+				--match;
+			}
+			const unsigned char* match_end = in + min_search_match;
+			const unsigned char* from = match + min_search_match;
+			while (match_end + sizeof(std::uint64_t) <= match_end_limit && read_u64(match_end) == read_u64(from))
+			{
+				match_end += sizeof(std::uint64_t);
+				from += sizeof(std::uint64_t);
+			}
+			while (match_end < match_end_limit && *match_end == *from)
+			{
+				++match_end;
+				++from;
+			}
+			out = write_sequence(out, anchor, static_cast<size_t>(in - anchor), static_cast<size_t>(in - match),
+				static_cast<size_t>(match_end - in));
+			in = match_end;
+			anchor = in;
+			if (in <= match_start_limit)
+			{
+				table[hash_at(in - 2)] = static_cast<std::uint32_t>(in - 2 - src);
+			}
+		}
+	}
+	const auto literal_length = static_cast<size_t>(src + size - anchor);
+	*out++ = static_cast<unsigned char>(std::min<size_t>(literal_length, 15) << 4);
+	if (literal_length >= 15)
+		out = write_length(out, literal_length - 15);
+	std::memcpy(out, anchor, literal_length);
+	out += literal_length;
+	return static_cast<size_t>(out - dest);
+}
+
+void cjm::lz4::decompress(const unsigned char* src, size_t size, unsigned char* dest, size_t decompressed_size)
+{
+	const unsigned char* in = src;
+	const unsigned char* const in_end = src + size;
+	unsigned char* out = dest;
+	unsigned char* const out_end = dest + decompressed_size;
+	for (;;)
+	{
+		if (in == in_end)
+			throw_corrupt_block();
+		const unsigned char token = *in++;
+		size_t literal_length = token >> 4;
+		if (literal_length == 15)
+			literal_length += read_length(in, in_end);
+		if (literal_length > static_cast<size_t>(in_end - in) || literal_length > static_cast<size_t>(out_end - out))
+			throw_corrupt_block();
+		std::memcpy(out, in, literal_length);
+		in += literal_length;
+		out += literal_length;
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			throw_corrupt_block();
+		const auto offset = static_cast<size_t>(read_le(in, 2));
+		in += 2;
+		size_t match_length = token & 15u;
+		if (match_length == 15)
+			match_length += read_length(in, in_end);
+		match_length += min_match;
+		if (offset == 0 || offset > static_cast<size_t>(out - dest) || match_length > static_cast<size_t>(out_end - out))
+			throw_corrupt_block();
+		const unsigned char* match = out - offset;
+		if (offset >= match_length)
+		{
+			std::memcpy(out, match, match_length);
+			out += match_length;
+		}
+		else
+		{
+			//the match overlaps what it produces: it repeats the last offset bytes.
+			for (size_t i = 0; i < match_length; ++i)
+			{
+				*out++ = *match++;
+			}
+		}
+	}
+	if (out != out_end)
+		throw_corrupt_block();
+}
+
+void cjm::compress_text(const char* text, size_t size, text_encoding encoding, size_t frame_size, compressed_frames& frames)
+{
+	if (frame_size == 0 || frame_size > std::numeric_limits<std::uint32_t>::max() / 2)
+		throw std::invalid_argument{ "The frame size must be positive and fit comfortably in 32 bits." };
+	size_t begin = 0;
+	while (begin < size)
+	{
+		const size_t end = size - begin <= frame_size ? size : frame_end(text, size, begin, begin + frame_size, encoding);
+		const size_t length = end - begin;
+		if (length > std::numeric_limits<std::uint32_t>::max())
+			throw std::invalid_argument{ "A line of the text is too long to frame." };
+		const auto* const src = reinterpret_cast<const unsigned char*>(text + begin);
+		const size_t offset = frames.bytes.size();
+		frames.bytes.resize(offset + lz4::compress_bound(length));
+		const size_t compressed_size = lz4::compress(src, length, frames.bytes.data() + offset);
+		frames.bytes.resize(offset + compressed_size);
+		auto crc = crc32{};
+		crc.update(src, length);
+		frames.frames.push_back(compressed_frame{ offset, static_cast<std::uint32_t>(compressed_size),
+			static_cast<std::uint32_t>(length), crc.value() });
+		begin = end;
+	}
+}
+
+void cjm::write_compressed_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+	unsigned thread_count, std::uint64_t first_record, operand_distribution distribution, rgen_engine engine,
+	text_encoding encoding)
+{
+	auto writer = compressed_battery_writer{ file_name };
+	tstr_stream_t header;
+	header << battery_header{ test_battery_name, name(engine), seed, random_op_block_size, first_record, count,
+		distribution };
+	const std::string header_text = to_file_text(header.str(), encoding, true);
+	writer.write_text(header_text.data(), header_text.size(), encoding);
+
+	const size_t workers = block_worker_count(first_record, count, thread_count, random_op_block_size);
+	std::vector<std::unique_ptr<cjm_helper_rgen>> generators;
+	std::vector<std::vector<binary_operation>> ops(workers);
+	std::vector<std::vector<char>> text(workers);
+	generators.reserve(workers);
+	for (size_t i = 0; i < workers; ++i)
+	{
+		generators.emplace_back(cjm_helper_rgen::make_rgen(seed, distribution, engine));
+	}
+	generate_blocks<compressed_frames>(first_record, count, thread_count, random_op_block_size,
+		[&](size_t worker, std::uint64_t block_idx, size_t skip, size_t length, std::vector<compressed_frames>& block) -> void
+	{
+		generate_random_block(*generators[worker], seed, block_idx, skip, length, ops[worker]);
+		text[worker].clear();
+		append_file_text(text[worker], ops[worker], encoding);
+		block.resize(1);
+		block[0].clear();
+		compress_text(text[worker].data(), text[worker].size(), encoding, writer.frame_size(), block[0]);
+	}, [&](const std::vector<compressed_frames>& block) -> void
+	{
+		writer.write(block[0]);
+	});
+	writer.close();
+}
+
+void cjm::serialize_compressed_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+	unsigned thread_count, std::uint64_t first_record, operand_distribution distribution, rgen_engine engine,
+	text_encoding encoding)
+{
+	if (file_name.empty())
+	{
+		throw std::invalid_argument{ "File name supplied cannot be empty." };
+	}
+	if (count == 0)
+	{
+		throw std::invalid_argument{ "Count of operations must be positive." };
+	}
+	try
+	{
+		std::cout << "Saving " << count << " operations of " << test_battery_name << " compressed to file [" << file_name
+			<< "] using " << resolve_thread_count(thread_count) << " threads... ";
+		write_compressed_random_ops(test_battery_name, file_name, count, seed, thread_count, first_record, distribution, engine,
+			encoding);
+	}
+	catch (const std::exception& ex)
+	{
+		fstr_stream_t message;
+		message << "Unable to save "sv << test_battery_name << " to file "sv << file_name
+			<< " because of exception: ["sv << ex.what() << "]."sv;
+		throw std::runtime_error{ message.str() };
+	}
+	std::cout << " successfully saved battery " << test_battery_name << " to file: [" << file_name << "]." << newl;
+}
+
+bool cjm::compressed_battery_header::matches(const unsigned char* first_bytes, size_t available) noexcept
+{
+	return available >= magic.size() && std::memcmp(first_bytes, magic.data(), magic.size()) == 0;
+}
+
+void cjm::compressed_battery_header::write_to(unsigned char* dest) const noexcept
+{
+	std::memset(dest, 0, size);
+	std::memcpy(dest, magic.data(), magic.size());
+	write_le(dest + 8, version, 4);
+	write_le(dest + 12, codec, 4);
+	write_le(dest + 16, frame_size, 4);
+}
+
+cjm::compressed_battery_header cjm::compressed_battery_header::read_from(const unsigned char* src)
+{
+	if (!matches(src, size))
+		throw std::invalid_argument{ "The file is not a compressed battery." };
+	auto ret = compressed_battery_header{};
+	ret.version = static_cast<std::uint32_t>(read_le(src + 8, 4));
+	ret.codec = static_cast<std::uint32_t>(read_le(src + 12, 4));
+	ret.frame_size = static_cast<std::uint32_t>(read_le(src + 16, 4));
+	if (ret.version != current_version)
+		throw std::invalid_argument{ "Unsupported compressed battery version: " + std::to_string(ret.version) + "." };
+	if (ret.codec != lz4_block_codec)
+		throw std::invalid_argument{ "Unsupported compressed battery codec: " + std::to_string(ret.codec) + "." };
+	return ret;
+}
+
+cjm::compressed_battery_writer::compressed_battery_writer(fsv_t file_name, size_t frame_size)
+	: m_writer{ file_name }, m_frame_size{ frame_size }, m_size{ 0 }, m_index{}, m_scratch{}, m_closed{ false }
+{
+	auto header = compressed_battery_header{};
+	header.frame_size = static_cast<std::uint32_t>(frame_size);
+	auto header_bytes = std::array<unsigned char, compressed_battery_header::size>{};
+	header.write_to(header_bytes.data());
+	m_writer.write(reinterpret_cast<const char*>(header_bytes.data()), header_bytes.size());
+}
+
+void cjm::compressed_battery_writer::write_text(const char* text, size_t size, text_encoding encoding)
+{
+	m_scratch.clear();
+	compress_text(text, size, encoding, m_frame_size, m_scratch);
+	write(m_scratch);
+}
+
+void cjm::compressed_battery_writer::write(const compressed_frames& frames)
+{
+	assert(!m_closed);
+	const std::uint64_t base = m_writer.bytes_written();
+	for (const compressed_frame& frame : frames.frames)
+	{
+		m_index.push_back(compressed_frame{ base + frame.offset, frame.compressed_size, frame.size, frame.crc });
+		m_size += frame.size;
+	}
+	m_writer.write(reinterpret_cast<const char*>(frames.bytes.data()), frames.bytes.size());
+}
+
+void cjm::compressed_battery_writer::close()
+{
+	if (m_closed)
+		return;
+	m_closed = true;
+	const std::uint64_t index_offset = m_writer.bytes_written();
+	auto index = std::vector<unsigned char>(m_index.size() * compressed_battery_header::index_entry_size, 0);
+	unsigned char* entry = index.data();
+	for (const compressed_frame& frame : m_index)
+	{
+		write_le(entry, frame.offset, 8);
+		write_le(entry + 8, frame.compressed_size, 4);
+		write_le(entry + 12, frame.size, 4);
+		write_le(entry + 16, frame.crc, 4);
+		entry += compressed_battery_header::index_entry_size;
+	}
+	auto crc = crc32{};
+	crc.update(index.data(), index.size());
+	auto trailer = std::array<unsigned char, compressed_battery_header::trailer_size>{};
+	write_le(trailer.data(), index_offset, 8);
+	write_le(trailer.data() + 8, m_index.size(), 8);
+	write_le(trailer.data() + 16, m_size, 8);
+	write_le(trailer.data() + 24, crc.value(), 4);
+	m_writer.write(reinterpret_cast<const char*>(index.data()), index.size());
+	m_writer.write(reinterpret_cast<const char*>(trailer.data()), trailer.size());
+	m_writer.close();
+}
+
+cjm::compressed_battery::compressed_battery(const unsigned char* data, size_t size)
+	: m_data{ data }, m_header{}, m_frames{}, m_positions{}, m_size{ 0 }
+{
+	constexpr size_t header_size = compressed_battery_header::size;
+	constexpr size_t trailer_size = compressed_battery_header::trailer_size;
+	constexpr size_t entry_size = compressed_battery_header::index_entry_size;
+	if (size < header_size + trailer_size)
+		throw std::invalid_argument{ "The compressed battery is shorter than its header and trailer." };
+	m_header = compressed_battery_header::read_from(data);
+	const unsigned char* const trailer = data + size - trailer_size;
+	const std::uint64_t index_offset = read_le(trailer, 8);
+	const std::uint64_t frame_count = read_le(trailer + 8, 8);
+	const std::uint64_t total_size = read_le(trailer + 16, 8);
+	if (index_offset < header_size || index_offset > size - trailer_size
+		|| frame_count != (size - trailer_size - index_offset) / entry_size
+		|| (size - trailer_size - index_offset) % entry_size != 0)
+		throw std::invalid_argument{ "The index of the compressed battery is not where its trailer says." };
+	const unsigned char* entry = data + index_offset;
+	auto crc = crc32{};
+	crc.update(entry, static_cast<size_t>(frame_count * entry_size));
+	if (crc.value() != static_cast<std::uint32_t>(read_le(trailer + 24, 4)))
+		throw std::invalid_argument{ "The index of the compressed battery failed its crc check." };
+
+	m_frames.reserve(static_cast<size_t>(frame_count));
+	m_positions.reserve(static_cast<size_t>(frame_count));
+	for (std::uint64_t i = 0; i < frame_count; ++i, entry += entry_size)
+	{
+		const auto frame = compressed_frame{ read_le(entry, 8), static_cast<std::uint32_t>(read_le(entry + 8, 4)),
+			static_cast<std::uint32_t>(read_le(entry + 12, 4)), static_cast<std::uint32_t>(read_le(entry + 16, 4)) };
+		if (frame.offset < header_size || frame.offset > index_offset || frame.compressed_size > index_offset - frame.offset)
+			throw std::invalid_argument{ "A frame of the compressed battery lies outside its frame data." };
+		m_frames.push_back(frame);
+		m_positions.push_back(m_size);
+		m_size += frame.size;
+	}
+	if (m_size != total_size)
+		throw std::invalid_argument{ "The frames of the compressed battery do not add up to its size." };
+}
+
+void cjm::compressed_battery::decompress(size_t idx, std::vector<unsigned char>& text) const
+{
+	const compressed_frame& frame = m_frames.at(idx);
+	text.resize(frame.size);
+	lz4::decompress(m_data + frame.offset, frame.compressed_size, text.data(), text.size());
+	auto crc = crc32{};
+	crc.update(text.data(), text.size());
+	if (crc.value() != frame.crc)
+		throw std::invalid_argument{ "Frame " + std::to_string(idx) + " of the compressed battery failed its crc check." };
+}
+
+cjm::compressed_stream::compressed_stream(fsv_t file_name) : m_file{ file_name }, m_battery{ m_file.data(), m_file.size() },
+	m_frame{}, m_next_frame{ 0 }, m_pos{ 0 } {}
+
+size_t cjm::compressed_stream::read(unsigned char* dest, size_t size)
+{
+	size_t ret = 0;
+	while (ret < size)
+	{
+		if (m_pos == m_frame.size())
+		{
+			if (m_next_frame == m_battery.frame_count())
+				break;
+			m_battery.decompress(m_next_frame++, m_frame);
+			m_pos = 0;
+			continue;
+		}
+		const size_t copied = std::min(size - ret, m_frame.size() - m_pos);
+		std::memcpy(dest + ret, m_frame.data() + m_pos, copied);
+		m_pos += copied;
+		ret += copied;
+	}
+	return ret;
+}
+
+void cjm::compressed_stream::seek(std::uint64_t position)
+{
+	if (position > m_battery.size())
+		throw std::out_of_range{ "Cannot seek past the end of the compressed battery." };
+	m_frame.clear();
+	m_pos = 0;
+	m_next_frame = 0;
+	//the last frame starting at or before position.
+	size_t frame = 0;
+	while (frame + 1 < m_battery.frame_count() && m_battery.frame_position(frame + 1) <= position)
+	{
+		++frame;
+	}
+	if (frame < m_battery.frame_count() && position < m_battery.size())
+	{
+		m_battery.decompress(frame, m_frame);
+		m_next_frame = frame + 1;
+		m_pos = static_cast<size_t>(position - m_battery.frame_position(frame));
+	}
+	else
+	{
+		m_next_frame = m_battery.frame_count();
+	}
+}
@@ -0,0 +1,159 @@
+#ifndef CJM_COMPRESSED_HPP_
+#define CJM_COMPRESSED_HPP_
+#include "helper.hpp"
+#include "async_writer.hpp"
+#include "mapped_file.hpp"
+#include <array>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	//uncompressed bytes per frame (frames end at a line end, so they hold at most this much).
+	constexpr size_t default_compressed_frame_size = 1 << 20;
+
+	namespace lz4
+	{
+		//the most bytes compress can produce from size bytes.
+		constexpr size_t compress_bound(size_t size) noexcept { return size + size / 255 + 16; }
+		//compresses [src, src + size) as one block of the LZ4 block format (no LZ4 frame): returns the compressed size.
+		//dest must have room for compress_bound(size) bytes.
+		size_t compress(const unsigned char* src, size_t size, unsigned char* dest);
+		//throws std::invalid_argument unless [src, src + size) is an LZ4 block of exactly decompressed_size bytes.
+		void decompress(const unsigned char* src, size_t size, unsigned char* dest, size_t decompressed_size);
+	}
+
+	struct compressed_frame;
+	struct compressed_frames;
+	struct compressed_battery_header;
+	class compressed_battery_writer;
+	class compressed_battery;
+	class compressed_stream;
+
+	//appends text (whole lines in the given encoding) to frames as frames of at most frame_size uncompressed bytes.
+	void compress_text(const char* text, size_t size, text_encoding encoding, size_t frame_size, compressed_frames& frames);
+	//write_random_ops to a compressed battery: the generator workers format and compress their own blocks.
+	void write_compressed_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+		unsigned thread_count, std::uint64_t first_record, operand_distribution distribution,
+		rgen_engine engine = rgen_engine::mt19937_64, text_encoding encoding = text_encoding::utf8);
+	void serialize_compressed_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+		unsigned thread_count = 0, std::uint64_t first_record = 0,
+		operand_distribution distribution = operand_distribution::uniform, rgen_engine engine = rgen_engine::mt19937_64,
+		text_encoding encoding = text_encoding::utf8);
+
+	struct compressed_frame final
+	{
+		std::uint64_t offset; //of the compressed bytes
+		std::uint32_t compressed_size;
+		std::uint32_t size;
+		std::uint32_t crc; //of the uncompressed bytes
+	};
+
+	//frames compressed back to back: offsets are into bytes.
+	struct compressed_frames final
+	{
+		std::vector<unsigned char> bytes;
+		std::vector<compressed_frame> frames;
+
+		void clear() noexcept { bytes.clear(); frames.clear(); }
+	};
+
+	//A compressed battery is a text battery file cut at line ends into frames, each compressed on its own so that any
+	//frame can be decompressed (and its records checked) without the ones before it.
+	//Layout (all integers little endian):
+	//	header: [0, 8) magic, [8, 12) version, [12, 16) codec (1: LZ4 block), [16, 20) frame size, [20, 32) reserved (zero);
+	//	the compressed frames;
+	//	index: per frame [0, 8) offset, [8, 12) compressed size, [12, 16) size, [16, 20) crc32, [20, 24) reserved (zero);
+	//	trailer: [0, 8) index offset, [8, 16) frame count, [16, 24) uncompressed size, [24, 28) crc32 of the index,
+	//	[28, 32) reserved (zero).
+	struct compressed_battery_header final
+	{
+		static constexpr std::array<char, 8> magic = { 'C', 'J', 'M', 'I', '1', '2', '8', 'Z' };
+		static constexpr std::uint32_t current_version = 1;
+		static constexpr std::uint32_t lz4_block_codec = 1;
+		static constexpr size_t size = 32;
+		static constexpr size_t index_entry_size = 24;
+		static constexpr size_t trailer_size = 32;
+
+		std::uint32_t version = current_version;
+		std::uint32_t codec = lz4_block_codec;
+		std::uint32_t frame_size = static_cast<std::uint32_t>(default_compressed_frame_size);
+
+		static bool matches(const unsigned char* first_bytes, size_t available) noexcept;
+		void write_to(unsigned char* dest) const noexcept;
+		static compressed_battery_header read_from(const unsigned char* src);
+	};
+
+	//Writes frames as they arrive; the index and trailer are written by close().
+	class compressed_battery_writer final
+	{
+	public:
+		explicit compressed_battery_writer(fsv_t file_name, size_t frame_size = default_compressed_frame_size);
+		compressed_battery_writer(const compressed_battery_writer& other) = delete;
+		compressed_battery_writer(compressed_battery_writer&& other) noexcept = delete;
+		compressed_battery_writer& operator=(const compressed_battery_writer& other) = delete;
+		compressed_battery_writer& operator=(compressed_battery_writer&& other) noexcept = delete;
+		~compressed_battery_writer() = default;
+
+		//compresses text (whole lines) on the calling thread.
+		void write_text(const char* text, size_t size, text_encoding encoding);
+		void write(const compressed_frames& frames);
+		void close();
+		[[nodiscard]] size_t frame_size() const noexcept { return m_frame_size; }
+		[[nodiscard]] std::uint64_t size() const noexcept { return m_size; }
+		[[nodiscard]] std::uint64_t compressed_size() const noexcept { return m_writer.bytes_written(); }
+
+	private:
+		async_file_writer m_writer;
+		size_t m_frame_size;
+		std::uint64_t m_size;
+		std::vector<compressed_frame> m_index;
+		compressed_frames m_scratch;
+		bool m_closed;
+	};
+
+	//The frame index of a compressed battery held in memory (e.g. a mapped_file): frames decompress independently.
+	class compressed_battery final
+	{
+	public:
+		//throws std::invalid_argument if the header, trailer or index is malformed.
+		compressed_battery(const unsigned char* data, size_t size);
+
+		[[nodiscard]] const compressed_battery_header& header() const noexcept { return m_header; }
+		[[nodiscard]] size_t frame_count() const noexcept { return m_frames.size(); }
+		[[nodiscard]] const compressed_frame& frame(size_t idx) const { return m_frames.at(idx); }
+		//uncompressed size
+		[[nodiscard]] std::uint64_t size() const noexcept { return m_size; }
+		//the uncompressed offset of each frame.
+		[[nodiscard]] std::uint64_t frame_position(size_t idx) const { return m_positions.at(idx); }
+		//replaces the contents of text with frame idx; throws std::invalid_argument if it is corrupt.
+		void decompress(size_t idx, std::vector<unsigned char>& text) const;
+
+	private:
+		const unsigned char* m_data;
+		compressed_battery_header m_header;
+		std::vector<compressed_frame> m_frames;
+		std::vector<std::uint64_t> m_positions;
+		std::uint64_t m_size;
+	};
+
+	//Reads the uncompressed bytes of a compressed battery file one frame at a time.
+	class compressed_stream final
+	{
+	public:
+		explicit compressed_stream(fsv_t file_name);
+
+		//copies up to size bytes to dest: returns how many, fewer than size only at the end.
+		size_t read(unsigned char* dest, size_t size);
+		//continues reading from the given uncompressed offset, decompressing only the frame holding it.
+		void seek(std::uint64_t position);
+		[[nodiscard]] const compressed_battery& battery() const noexcept { return m_battery; }
+
+	private:
+		mapped_file m_file;
+		compressed_battery m_battery;
+		std::vector<unsigned char> m_frame;
+		size_t m_next_frame;
+		size_t m_pos;
+	};
+}
+#endif // CJM_COMPRESSED_HPP_
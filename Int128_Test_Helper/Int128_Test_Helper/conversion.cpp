@@ -0,0 +1,258 @@
+#include "conversion.hpp"
+#include "binary_format.hpp"
+#include "async_writer.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <numeric>
+
+std::pair<double, cjm::int128_t> cjm::calculate_percent_diff(int128_t left, int128_t right)
+{
+	if (left == right) return std::make_pair<double, int128_t>(0, 0);
+
+	if (left < 0 && right < 0)
+	{
+		if (left == std::numeric_limits<int128_t>::min())
+		{
+			left += 1; 
+			right -= 1; //since left does not equal right
+			if (right == std::numeric_limits<int128_t>::min()) //ok we switched places .... the difference is one and percent diff is 1 / min
+			{
+				return std::make_pair<double, int128_t>(static_cast<double>(1) / static_cast<double>(right == std::numeric_limits<int128_t>::min()), 1);
+			}
+		}
+		if (right == std::numeric_limits<int128_t>::min())
+		{
+			right += 1;
+			left -= 1; //since left does not equal right
+			if (left == std::numeric_limits<int128_t>::min()) //ok we switched places .... the difference is one and percent diff is 1 / min
+			{
+				return std::make_pair<double, int128_t>(static_cast<double>(1) / static_cast<double>(right == std::numeric_limits<int128_t>::min()), 1);
+			}			
+		}
+		//ok we know it's safe to make them both positive.
+		left = -left;
+		right = -right;		
+	}
+
+	auto throw_if_diff_too_big = [](int128_t bigger, int128_t smaller) -> int128_t
+	{
+		assert(bigger >= 0);
+		if (smaller < 0)
+		{
+			//bigger - smaller == bigger + |smaller|: representable only if it does not exceed max.
+			auto difference = static_cast<uint128_t>(bigger) - static_cast<uint128_t>(smaller);
+			if (difference > static_cast<uint128_t>(std::numeric_limits<int128_t>::max())) throw std::domain_error{ "The difference would cause signed integer overflow." };
+			return static_cast<int128_t>(difference);
+		}
+		auto temp = bigger - smaller;
+		if (temp == std::numeric_limits<int128_t>::min()) throw std::domain_error{ "Difference cannot be expressed as a positive signed int128." };
+		return temp < 0 ? -temp : temp;
+	};
+	
+	auto bigger = left > right ? left : right;
+	auto smaller = left < right ? left : right;
+	const auto difference = throw_if_diff_too_big(bigger, smaller);
+
+	if (difference == 0) return std::pair<double, int128_t>(0, 0);
+	//both are non-negative here unless their signs differ: then the difference is relative to the greater magnitude.
+	const double relative_to = std::max(static_cast<double>(bigger), -static_cast<double>(smaller));
+	return std::make_pair<double, int128_t>(static_cast<double>(difference) / relative_to, static_cast<int128_t>(difference < 0 ? -difference : difference));
+}
+
+cjm::tick_conversion cjm::tick_conversion::for_frequency(std::int64_t frequency)
+{
+	if (frequency <= 0)
+		throw std::invalid_argument{ "A stopwatch frequency must be positive." };
+	const std::int64_t common = std::gcd(frequency, timespan_ticks_per_second);
+	auto ret = tick_conversion{ frequency, frequency / common, timespan_ticks_per_second / common, 0 };
+	constexpr int128_t max_int64 = std::numeric_limits<std::int64_t>::max();
+	ret.max_ticks = std::min(max_int64, max_int64 * ret.divisor / ret.factor);
+	return ret;
+}
+
+void cjm::tick_conversion::append_round_trip(std::vector<binary_operation>& ops, int128_t timespan_ticks) const
+{
+	const int128_t to_product = timespan_ticks * factor;
+	const int128_t stopwatch_ticks = to_product / divisor;
+	const int128_t back_product = stopwatch_ticks * divisor;
+	ops.emplace_back(binary_op::multiply, timespan_ticks, factor, to_product);
+	ops.emplace_back(binary_op::divide, to_product, divisor, stopwatch_ticks);
+	ops.emplace_back(binary_op::multiply, stopwatch_ticks, divisor, back_product);
+	ops.emplace_back(binary_op::divide, back_product, factor, back_product / factor);
+}
+
+void cjm::round_trip_stats::add(int128_t original, int128_t round_tripped)
+{
+	auto [percent_diff, difference] = calculate_percent_diff(round_tripped, original);
+	++round_trips;
+	exact += static_cast<std::uint64_t>(difference == 0);
+	max_difference = std::max(max_difference, difference);
+	max_percent_diff = std::max(max_percent_diff, percent_diff);
+	total_percent_diff += percent_diff;
+}
+
+double cjm::round_trip_stats::mean_percent_diff() const noexcept
+{
+	return round_trips > 0 ? total_percent_diff / static_cast<double>(round_trips) : 0.0;
+}
+
+std::ostream& cjm::operator<<(std::ostream& ostr, const round_trip_stats& stats)
+{
+	ostr << "\t[" << stats.frequency << " Hz]: " << stats.round_trips << " round trips; exact: " << stats.exact
+		<< "; max difference: " << stats.max_difference << " ticks; max relative difference: " << stats.max_percent_diff
+		<< "; mean relative difference: " << stats.mean_percent_diff() << "." << newl;
+	return ostr;
+}
+
+std::vector<cjm::tick_conversion> cjm::make_tick_conversions(const std::vector<std::int64_t>& frequencies)
+{
+	if (frequencies.empty())
+		throw std::invalid_argument{ "At least one stopwatch frequency is required." };
+	auto ret = std::vector<tick_conversion>{};
+	ret.reserve(frequencies.size());
+	std::transform(frequencies.cbegin(), frequencies.cend(), std::back_inserter(ret), &tick_conversion::for_frequency);
+	return ret;
+}
+
+cjm::int128_t cjm::random_timespan_ticks(std::mt19937_64& engine, int128_t max_ticks)
+{
+	assert(max_ticks > 0 && max_ticks <= std::numeric_limits<std::int64_t>::max());
+	const auto max = static_cast<std::uint64_t>(max_ticks);
+	std::uint64_t magnitude;
+	if ((engine() & 1u) != 0)
+	{
+		magnitude = std::uniform_int_distribution<std::uint64_t>{ 0, max }(engine);
+	}
+	else
+	{
+		const int bit_length = 1 + static_cast<int>(engine() % 63);
+		magnitude = (engine() >> (64 - bit_length)) | (std::uint64_t{ 1 } << (bit_length - 1));
+		if (magnitude > max)
+			magnitude %= max + 1;
+	}
+	const auto value = static_cast<int128_t>(magnitude);
+	return (engine() & 1u) != 0 ? -value : value;
+}
+
+void cjm::generate_conversion_block(const std::vector<tick_conversion>& conversions, std::uint64_t base_seed,
+	std::uint64_t block_idx, size_t skip, size_t count, std::vector<binary_operation>& fill_me)
+{
+	static_assert(random_op_block_size % conversion_records_per_round_trip == 0, "A block must hold whole round trips.");
+	assert(!conversions.empty());
+	constexpr size_t round_trips_per_block = random_op_block_size / conversion_records_per_round_trip;
+	auto engine = std::mt19937_64{ derive_block_seed(base_seed, block_idx) };
+	const size_t first_round_trip = skip / conversion_records_per_round_trip;
+	const size_t end_round_trip = (skip + count + conversion_records_per_round_trip - 1) / conversion_records_per_round_trip;
+	//every round trip draws the same number of values, so the ones before the slice are drawn and discarded.
+	for (size_t i = 0; i < first_round_trip; ++i)
+	{
+		const tick_conversion& conversion = conversions[(block_idx * round_trips_per_block + i) % conversions.size()];
+		(void) random_timespan_ticks(engine, conversion.max_ticks);
+	}
+	fill_me.clear();
+	fill_me.reserve((end_round_trip - first_round_trip) * conversion_records_per_round_trip);
+	for (size_t i = first_round_trip; i < end_round_trip; ++i)
+	{
+		const tick_conversion& conversion = conversions[(block_idx * round_trips_per_block + i) % conversions.size()];
+		conversion.append_round_trip(fill_me, random_timespan_ticks(engine, conversion.max_ticks));
+	}
+	const size_t leading = skip - first_round_trip * conversion_records_per_round_trip;
+	fill_me.erase(fill_me.begin(), fill_me.begin() + static_cast<std::ptrdiff_t>(leading));
+	fill_me.resize(count);
+}
+
+void cjm::add_round_trips(std::vector<round_trip_stats>& stats, std::uint64_t first_record, const std::vector<binary_operation>& ops)
+{
+	assert(!stats.empty());
+	//only round trips wholly inside ops are counted.
+	size_t i = static_cast<size_t>((conversion_records_per_round_trip - first_record % conversion_records_per_round_trip) % conversion_records_per_round_trip);
+	for (; i + conversion_records_per_round_trip <= ops.size(); i += conversion_records_per_round_trip)
+	{
+		const std::uint64_t round_trip = (first_record + i) / conversion_records_per_round_trip;
+		stats[static_cast<size_t>(round_trip % stats.size())].add(ops[i].left_operand(), ops[i + 3].result().value());
+	}
+}
+
+std::vector<cjm::round_trip_stats> cjm::serialize_conversion_ops(fsv_t test_battery_name, fsv_t file_name, size_t count,
+	std::uint64_t seed, const std::vector<std::int64_t>& frequencies, battery_format format, unsigned thread_count,
+	std::uint64_t first_record, text_encoding encoding)
+{
+	if (file_name.empty())
+	{
+		throw std::invalid_argument{ "File name supplied cannot be empty." };
+	}
+	if (count == 0 || count % conversion_records_per_round_trip != 0 || first_record % conversion_records_per_round_trip != 0)
+	{
+		throw std::invalid_argument{ "A conversion battery holds four records per round trip: the count and first record must be multiples of four." };
+	}
+	const std::vector<tick_conversion> conversions = make_tick_conversions(frequencies);
+	auto stats = std::vector<round_trip_stats>(conversions.size());
+	for (size_t i = 0; i < conversions.size(); ++i)
+	{
+		stats[i].frequency = conversions[i].frequency;
+	}
+
+	//the frequencies (in round trip order) are part of the battery name so the text header identifies the battery.
+	fstr_stream_t name;
+	name << test_battery_name << " (Hz:";
+	for (const std::int64_t frequency : frequencies)
+	{
+		name << ' ' << frequency;
+	}
+	name << ')';
+	const fstr_t battery_name = name.str();
+	const auto fill = [&](size_t, std::uint64_t block_idx, size_t skip, size_t length, std::vector<binary_operation>& block) -> void
+	{
+		generate_conversion_block(conversions, seed, block_idx, skip, length, block);
+	};
+	try
+	{
+		std::cout << "Saving " << count << " operations of " << battery_name << " to file [" << file_name << "] using "
+			<< resolve_thread_count(thread_count) << " threads... ";
+		std::uint64_t next_record = first_record;
+		if (format == battery_format::binary)
+		{
+			auto header = binary_battery_header{};
+			header.seed = seed;
+			header.first_record = first_record;
+			header.block_size = random_op_block_size;
+			header.set_engine_name("mt19937_64"sv);
+			auto writer = binary_battery_writer{ file_name, header };
+			generate_blocks(first_record, count, thread_count, random_op_block_size, fill, [&](const std::vector<binary_operation>& block) -> void
+			{
+				writer.write(block);
+				add_round_trips(stats, next_record, block);
+				next_record += block.size();
+			});
+			writer.close();
+		}
+		else
+		{
+			auto writer = async_file_writer{ file_name };
+			tstr_stream_t header;
+			header << battery_header{ battery_name, "mt19937_64"sv, seed, random_op_block_size, first_record, count };
+			writer.write(to_file_text(header.str(), encoding, true));
+			auto text = std::vector<char>{};
+			generate_blocks(first_record, count, thread_count, random_op_block_size, fill, [&](const std::vector<binary_operation>& block) -> void
+			{
+				text.clear();
+				append_file_text(text, block, encoding);
+				writer.write(text);
+				add_round_trips(stats, next_record, block);
+				next_record += block.size();
+			});
+			writer.close();
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		fstr_stream_t message;
+		message << "Unable to save "sv << battery_name << " to file "sv << file_name
+			<< " because of exception: ["sv << ex.what() << "]."sv;
+		throw std::runtime_error{ message.str() };
+	}
+	std::cout << " successfully saved battery " << battery_name << " to file: [" << file_name << "]." << newl;
+	return stats;
+}
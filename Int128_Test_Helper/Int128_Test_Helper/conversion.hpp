@@ -0,0 +1,71 @@
+#ifndef CJM_CONVERSION_HPP_
+#define CJM_CONVERSION_HPP_
+#include "helper.hpp"
+#include <array>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	//TimeSpan ticks are 100ns.
+	constexpr std::int64_t timespan_ticks_per_second = 10'000'000;
+	//Stopwatch frequencies seen in production: 10MHz (Windows 10+ QPC), 1GHz (Linux), the 2.44MHz QPC of
+	//run_mult_div_test_case_1, the ACPI PM timer, the HPET and a 24MHz ARM generic timer.
+	constexpr std::array<std::int64_t, 6> default_stopwatch_frequencies = { 10'000'000, 1'000'000'000, 2'441'418,
+		3'579'545, 14'318'180, 24'000'000 };
+	//a conversion battery records each round trip as multiply, divide (to stopwatch ticks), multiply, divide (back).
+	constexpr size_t conversion_records_per_round_trip = 4;
+
+	struct tick_conversion;
+	struct round_trip_stats;
+
+	//the difference between two values relative to the one with the greater magnitude, and the absolute difference.
+	std::pair<double, int128_t> calculate_percent_diff(int128_t left, int128_t right);
+	std::vector<tick_conversion> make_tick_conversions(const std::vector<std::int64_t>& frequencies);
+	//half uniform in [-max_ticks, max_ticks] (absolute stamps), half of a uniformly drawn bit length (durations).
+	int128_t random_timespan_ticks(std::mt19937_64& engine, int128_t max_ticks);
+	//records [skip, skip + count) of conversion battery block block_idx: round trip r of the battery converts
+	//ticks drawn from derive_block_seed(base_seed, block_idx) at conversions[r % conversions.size()].
+	void generate_conversion_block(const std::vector<tick_conversion>& conversions, std::uint64_t base_seed,
+		std::uint64_t block_idx, size_t skip, size_t count, std::vector<binary_operation>& fill_me);
+	//accumulates the round trips among records [first_record, first_record + ops.size()) of a conversion battery.
+	void add_round_trips(std::vector<round_trip_stats>& stats, std::uint64_t first_record,
+		const std::vector<binary_operation>& ops);
+	std::vector<round_trip_stats> serialize_conversion_ops(fsv_t test_battery_name, fsv_t file_name, size_t count,
+		std::uint64_t seed, const std::vector<std::int64_t>& frequencies, battery_format format,
+		unsigned thread_count = 0, std::uint64_t first_record = 0, text_encoding encoding = text_encoding::utf8);
+	std::ostream& operator<<(std::ostream& ostr, const round_trip_stats& stats);
+
+	//TimeSpan ticks <-> Stopwatch ticks at one frequency as ticks * factor / divisor, the ratio reduced to lowest
+	//terms as MonotonicStampContext does.
+	struct tick_conversion final
+	{
+		std::int64_t frequency;
+		int128_t factor; //to stopwatch ticks: ticks * factor / divisor
+		int128_t divisor;
+		//the largest magnitude of TimeSpan ticks whose conversion still fits in a (signed 64 bit) Stopwatch tick count.
+		int128_t max_ticks;
+
+		static tick_conversion for_frequency(std::int64_t frequency);
+
+		[[nodiscard]] int128_t to_stopwatch_ticks(int128_t timespan_ticks) const noexcept { return timespan_ticks * factor / divisor; }
+		[[nodiscard]] int128_t to_timespan_ticks(int128_t stopwatch_ticks) const noexcept { return stopwatch_ticks * divisor / factor; }
+		//appends the four records of the round trip of timespan_ticks.
+		void append_round_trip(std::vector<binary_operation>& ops, int128_t timespan_ticks) const;
+	};
+
+	struct round_trip_stats final
+	{
+		std::int64_t frequency = 0;
+		std::uint64_t round_trips = 0;
+		std::uint64_t exact = 0;
+		int128_t max_difference = 0;
+		double max_percent_diff = 0.0;
+		double total_percent_diff = 0.0;
+
+		void add(int128_t original, int128_t round_tripped);
+		[[nodiscard]] double mean_percent_diff() const noexcept;
+	};
+}
+#endif // CJM_CONVERSION_HPP_
@@ -0,0 +1,123 @@
+#include "coverage.hpp"
+#include <algorithm>
+
+namespace
+{
+	using namespace std::string_view_literals;
+
+	constexpr std::array<cjm::fsv_t, cjm::operand_stratum_count> stratum_names = { "zero"sv, "unit"sv, "extreme"sv,
+		"limb_boundary"sv, "carry_pattern"sv, "small"sv, "low_limb"sv, "high_limb"sv, "full_width"sv };
+
+	int bit_length(cjm::uint128_t value) noexcept
+	{
+		int ret = 0;
+		std::uint64_t high = absl::Uint128High64(value);
+		std::uint64_t low = absl::Uint128Low64(value);
+		if (high != 0)
+		{
+			ret = 64;
+			low = high;
+		}
+		while (low != 0)
+		{
+			++ret;
+			low >>= 1;
+		}
+		return ret;
+	}
+
+	bool is_boundary_shift(cjm::int128_t amount) noexcept
+	{
+		return amount == 0 || amount == 1 || amount == 63 || amount == 64 || amount == 65 || amount == 126 || amount == 127;
+	}
+}
+
+cjm::operand_stratum cjm::classify_operand(int128_t value) noexcept
+{
+	constexpr int128_t max = std::numeric_limits<int128_t>::max();
+	constexpr int128_t min = std::numeric_limits<int128_t>::min();
+	if (value == 0)
+		return operand_stratum::zero;
+	if (value == min || value == min + 1 || value == max - 1 || value == max)
+		return operand_stratum::extreme;
+	const uint128_t magnitude = value < 0 ? -static_cast<uint128_t>(value) : static_cast<uint128_t>(value);
+	if (magnitude == 1)
+		return operand_stratum::unit;
+	const uint128_t two_63 = uint128_t{ 1 } << 63;
+	const uint128_t two_64 = uint128_t{ 1 } << 64;
+	if ((magnitude >= two_63 - 1 && magnitude <= two_63 + 1) || (magnitude >= two_64 - 1 && magnitude <= two_64 + 1))
+		return operand_stratum::limb_boundary;
+	const std::uint64_t low = absl::Uint128Low64(magnitude);
+	if (absl::Uint128High64(magnitude) != 0 && (low == 0 || low == std::numeric_limits<std::uint64_t>::max()))
+		return operand_stratum::carry_pattern;
+	const int bits = bit_length(magnitude);
+	if (bits <= 32)
+		return operand_stratum::small;
+	if (bits <= 64)
+		return operand_stratum::low_limb;
+	if (bits <= 126)
+		return operand_stratum::high_limb;
+	return operand_stratum::full_width;
+}
+
+size_t cjm::operand_bucket(int128_t value) noexcept
+{
+	return 2 * static_cast<size_t>(classify_operand(value)) + static_cast<size_t>(value < 0);
+}
+
+cjm::fstr_t cjm::bucket_name(size_t bucket)
+{
+	if (bucket >= operand_bucket_count)
+		throw std::invalid_argument{ "There is no such operand bucket." };
+	return fstr_t{ stratum_names[bucket / 2] } + (bucket % 2 == 0 ? "+" : "-");
+}
+
+cjm::operand_coverage::operand_coverage() : m_operations{ 0 }, m_left_hits{}, m_right_hits{}, m_boundary_shifts{ 0 },
+	m_combinations(combination_count, false), m_combinations_hit{ 0 } {}
+
+void cjm::operand_coverage::add(const binary_operation& op) noexcept
+{
+	++m_operations;
+	const size_t left = operand_bucket(op.left_operand());
+	++m_left_hits[left];
+	size_t right = 0;
+	if (op.op_code() == binary_op::left_shift || op.op_code() == binary_op::right_shift)
+	{
+		right = static_cast<size_t>(is_boundary_shift(op.right_operand()));
+		m_boundary_shifts += right;
+	}
+	else
+	{
+		right = operand_bucket(op.right_operand());
+		++m_right_hits[right];
+	}
+	const size_t combination = (static_cast<size_t>(op.op_code()) * operand_bucket_count + left) * operand_bucket_count + right;
+	if (!m_combinations[combination])
+	{
+		m_combinations[combination] = true;
+		++m_combinations_hit;
+	}
+}
+
+void cjm::operand_coverage::add(const std::vector<binary_operation>& ops) noexcept
+{
+	for (const binary_operation& op : ops)
+	{
+		add(op);
+	}
+}
+
+std::ostream& cjm::operator<<(std::ostream& ostr, const operand_coverage& coverage)
+{
+	ostr << "\tOperations: " << coverage.operations() << "; (op, left bucket, right bucket) combinations hit: "
+		<< coverage.combinations_hit() << "; shifts by a boundary amount: " << coverage.boundary_shifts() << "." << newl;
+	for (size_t bucket = 0; bucket < operand_bucket_count; ++bucket)
+	{
+		if (coverage.left_hits(bucket) == 0 && coverage.right_hits(bucket) == 0)
+			continue;
+		ostr << "\t\t" << std::left << std::setw(16) << bucket_name(bucket) << std::right
+			<< " left: " << std::setw(12) << coverage.left_hits(bucket)
+			<< " right: " << std::setw(12) << coverage.right_hits(bucket) << newl;
+	}
+	return ostr;
+}
@@ -0,0 +1,48 @@
+#ifndef CJM_COVERAGE_HPP_
+#define CJM_COVERAGE_HPP_
+#include "helper.hpp"
+#include <array>
+#include <ostream>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	//an operand_stratum and sign: bucket = 2 * stratum + (value < 0)
+	constexpr size_t operand_bucket_count = 2 * operand_stratum_count;
+
+	class operand_coverage;
+
+	operand_stratum classify_operand(int128_t value) noexcept;
+	size_t operand_bucket(int128_t value) noexcept;
+	fstr_t bucket_name(size_t bucket);
+	std::ostream& operator<<(std::ostream& ostr, const operand_coverage& coverage);
+
+	//Per bucket hit counts of the operands of a battery, the number of distinct (op, left bucket, right bucket)
+	//combinations hit and the number of shifts by an amount at a limb or width boundary (0, 1, 63, 64, 65, 126, 127).
+	class operand_coverage final
+	{
+	public:
+		static constexpr size_t combination_count = binary_op_count * operand_bucket_count * operand_bucket_count;
+
+		operand_coverage();
+
+		void add(const binary_operation& op) noexcept;
+		void add(const std::vector<binary_operation>& ops) noexcept;
+
+		[[nodiscard]] std::uint64_t operations() const noexcept { return m_operations; }
+		[[nodiscard]] std::uint64_t left_hits(size_t bucket) const noexcept { return m_left_hits[bucket]; }
+		//right operands of shifts are shift amounts: they are not counted here
+		[[nodiscard]] std::uint64_t right_hits(size_t bucket) const noexcept { return m_right_hits[bucket]; }
+		[[nodiscard]] std::uint64_t boundary_shifts() const noexcept { return m_boundary_shifts; }
+		[[nodiscard]] size_t combinations_hit() const noexcept { return m_combinations_hit; }
+
+	private:
+		std::uint64_t m_operations;
+		std::array<std::uint64_t, operand_bucket_count> m_left_hits;
+		std::array<std::uint64_t, operand_bucket_count> m_right_hits;
+		std::uint64_t m_boundary_shifts;
+		std::vector<bool> m_combinations;
+		size_t m_combinations_hit;
+	};
+}
+#endif // CJM_COVERAGE_HPP_
@@ -0,0 +1,322 @@
+#include "differential.hpp"
+#include "parallel.hpp"
+#include "hex.hpp"
+#include <boost/multiprecision/cpp_int.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+
+namespace
+{
+	using cjm::binary_op;
+	using cjm::int128_t;
+	using cjm::uint128_t;
+
+#ifdef ABSL_HAVE_INTRINSIC_INT128
+	//__int128 has no standard conversions from absl: move the limbs by hand so that nothing here relies on absl::int128
+	//being implemented with __int128.
+	__extension__ using native_uint128_t = unsigned __int128;
+	__extension__ using native_int128_t = __int128;
+
+	native_uint128_t to_native(int128_t value) noexcept
+	{
+		return (static_cast<native_uint128_t>(static_cast<std::uint64_t>(absl::Int128High64(value))) << 64)
+			| absl::Int128Low64(value);
+	}
+
+	int128_t from_native(native_uint128_t value) noexcept
+	{
+		return absl::MakeInt128(static_cast<std::int64_t>(static_cast<std::uint64_t>(value >> 64)),
+			static_cast<std::uint64_t>(value));
+	}
+
+	int128_t evaluate_native(binary_op op, int128_t lhs, int128_t rhs) noexcept
+	{
+		const native_uint128_t ul = to_native(lhs);
+		const native_uint128_t ur = to_native(rhs);
+		const auto sl = static_cast<native_int128_t>(ul);
+		const auto sr = static_cast<native_int128_t>(ur);
+		switch (op)
+		{
+		case binary_op::left_shift:
+			return from_native(ul << static_cast<int>(ur));
+		case binary_op::right_shift:
+			return from_native(static_cast<native_uint128_t>(sl >> static_cast<int>(ur)));
+		case binary_op::bw_and:
+			return from_native(ul & ur);
+		case binary_op::bw_or:
+			return from_native(ul | ur);
+		case binary_op::bw_xor:
+			return from_native(ul ^ ur);
+		case binary_op::divide:
+			return from_native(static_cast<native_uint128_t>(sl / sr));
+		case binary_op::modulus:
+			return from_native(static_cast<native_uint128_t>(sl % sr));
+		case binary_op::add:
+			return from_native(ul + ur);
+		case binary_op::subtract:
+			return from_native(ul - ur);
+		case binary_op::multiply:
+			return from_native(ul * ur);
+		case binary_op::compare:
+		default:
+			return int128_t{ static_cast<int>(sl > sr) - static_cast<int>(sl < sr) };
+		}
+	}
+#endif
+
+	//boost's fixed width signed type is signed magnitude (its range is +/-(2^128 - 1)); bitwise operators and right
+	//shifts emulate two's complement.  Wrapping add, subtract, multiply and left shift are done with the unsigned type.
+	using boost_uint128_t = boost::multiprecision::uint128_t;
+	using boost_int128_t = boost::multiprecision::int128_t;
+
+	boost_uint128_t to_boost_unsigned(int128_t value) noexcept
+	{
+		return (boost_uint128_t{ static_cast<std::uint64_t>(absl::Int128High64(value)) } << 64) | absl::Int128Low64(value);
+	}
+
+	boost_int128_t to_boost_signed(int128_t value) noexcept
+	{
+		const bool negative = value < 0;
+		const uint128_t magnitude = negative ? -static_cast<uint128_t>(value) : static_cast<uint128_t>(value);
+		const auto ret = boost_int128_t{ (boost_uint128_t{ absl::Uint128High64(magnitude) } << 64) | absl::Uint128Low64(magnitude) };
+		return negative ? boost_int128_t{ -ret } : ret;
+	}
+
+	int128_t from_boost(const boost_uint128_t& value) noexcept
+	{
+		return absl::MakeInt128(static_cast<std::int64_t>(static_cast<std::uint64_t>(value >> 64)),
+			static_cast<std::uint64_t>(value & std::numeric_limits<std::uint64_t>::max()));
+	}
+
+	int128_t from_boost(const boost_int128_t& value) noexcept
+	{
+		const auto magnitude = static_cast<boost_uint128_t>(boost::multiprecision::abs(value));
+		const int128_t ret = from_boost(magnitude);
+		return value < 0 ? static_cast<int128_t>(-static_cast<uint128_t>(ret)) : ret;
+	}
+
+	int128_t evaluate_boost(binary_op op, int128_t lhs, int128_t rhs) noexcept
+	{
+		switch (op)
+		{
+		case binary_op::left_shift:
+			return from_boost(boost_uint128_t{ to_boost_unsigned(lhs) << static_cast<unsigned>(rhs) });
+		case binary_op::right_shift:
+			return from_boost(boost_int128_t{ to_boost_signed(lhs) >> static_cast<unsigned>(rhs) });
+		case binary_op::bw_and:
+			return from_boost(boost_int128_t{ to_boost_signed(lhs) & to_boost_signed(rhs) });
+		case binary_op::bw_or:
+			return from_boost(boost_int128_t{ to_boost_signed(lhs) | to_boost_signed(rhs) });
+		case binary_op::bw_xor:
+			return from_boost(boost_int128_t{ to_boost_signed(lhs) ^ to_boost_signed(rhs) });
+		case binary_op::divide:
+			return from_boost(boost_int128_t{ to_boost_signed(lhs) / to_boost_signed(rhs) });
+		case binary_op::modulus:
+			return from_boost(boost_int128_t{ to_boost_signed(lhs) % to_boost_signed(rhs) });
+		case binary_op::add:
+			return from_boost(boost_uint128_t{ to_boost_unsigned(lhs) + to_boost_unsigned(rhs) });
+		case binary_op::subtract:
+			return from_boost(boost_uint128_t{ to_boost_unsigned(lhs) - to_boost_unsigned(rhs) });
+		case binary_op::multiply:
+			return from_boost(boost_uint128_t{ to_boost_unsigned(lhs) * to_boost_unsigned(rhs) });
+		case binary_op::compare:
+		default:
+		{
+			const boost_int128_t sl = to_boost_signed(lhs);
+			const boost_int128_t sr = to_boost_signed(rhs);
+			return int128_t{ static_cast<int>(sl > sr) - static_cast<int>(sl < sr) };
+		}
+		}
+	}
+
+	int128_t evaluate_abseil(binary_op op, int128_t lhs, int128_t rhs) noexcept
+	{
+		switch (op)
+		{
+		case binary_op::left_shift:
+			return cjm::apply_op<binary_op::left_shift>(lhs, rhs);
+		case binary_op::right_shift:
+			return cjm::apply_op<binary_op::right_shift>(lhs, rhs);
+		case binary_op::bw_and:
+			return cjm::apply_op<binary_op::bw_and>(lhs, rhs);
+		case binary_op::bw_or:
+			return cjm::apply_op<binary_op::bw_or>(lhs, rhs);
+		case binary_op::bw_xor:
+			return cjm::apply_op<binary_op::bw_xor>(lhs, rhs);
+		case binary_op::divide:
+			return cjm::apply_op<binary_op::divide>(lhs, rhs);
+		case binary_op::modulus:
+			return cjm::apply_op<binary_op::modulus>(lhs, rhs);
+		case binary_op::add:
+			return cjm::apply_op<binary_op::add>(lhs, rhs);
+		case binary_op::subtract:
+			return cjm::apply_op<binary_op::subtract>(lhs, rhs);
+		case binary_op::multiply:
+			return cjm::apply_op<binary_op::multiply>(lhs, rhs);
+		case binary_op::compare:
+		default:
+			return cjm::apply_op<binary_op::compare>(lhs, rhs);
+		}
+	}
+
+	template<typename Evaluate>
+	void evaluate_each(const std::vector<cjm::binary_operation>& ops, std::vector<int128_t>& results, Evaluate evaluate)
+	{
+		results.resize(ops.size());
+		for (size_t i = 0; i < ops.size(); ++i)
+		{
+			const cjm::binary_operation& op = ops[i];
+			results[i] = cjm::is_defined(op.op_code(), op.left_operand(), op.right_operand())
+				? evaluate(op.op_code(), op.left_operand(), op.right_operand())
+				: int128_t{ 0 };
+		}
+	}
+}
+
+bool cjm::is_available(int128_backend backend) noexcept
+{
+	switch (backend)
+	{
+	case int128_backend::abseil:
+	case int128_backend::boost_multiprecision:
+		return true;
+	case int128_backend::native:
+#ifdef ABSL_HAVE_INTRINSIC_INT128
+		return true;
+#else
+		return false;
+#endif
+	default:
+		return false;
+	}
+}
+
+std::optional<cjm::int128_t> cjm::evaluate(int128_backend backend, binary_op op, int128_t lhs, int128_t rhs) noexcept
+{
+	if (!is_available(backend) || !is_defined(op, lhs, rhs))
+		return std::nullopt;
+	switch (backend)
+	{
+	case int128_backend::abseil:
+		return evaluate_abseil(op, lhs, rhs);
+#ifdef ABSL_HAVE_INTRINSIC_INT128
+	case int128_backend::native:
+		return evaluate_native(op, lhs, rhs);
+#endif
+	case int128_backend::boost_multiprecision:
+		return evaluate_boost(op, lhs, rhs);
+	default:
+		return std::nullopt;
+	}
+}
+
+bool cjm::evaluate_block(int128_backend backend, const std::vector<binary_operation>& ops, std::vector<int128_t>& results)
+{
+	results.clear();
+	switch (backend)
+	{
+	case int128_backend::abseil:
+		evaluate_each(ops, results, &evaluate_abseil);
+		return true;
+#ifdef ABSL_HAVE_INTRINSIC_INT128
+	case int128_backend::native:
+		evaluate_each(ops, results, &evaluate_native);
+		return true;
+#endif
+	case int128_backend::boost_multiprecision:
+		evaluate_each(ops, results, &evaluate_boost);
+		return true;
+	default:
+		return false;
+	}
+}
+
+cjm::int128_backend cjm::differential_summary::fastest() const noexcept
+{
+	auto ret = int128_backend::abseil;
+	double best = -1.0;
+	for (const backend_timing& timing : timings)
+	{
+		if (timing.available && timing.operations > 0 && (best < 0.0 || timing.ns_per_op() < best))
+		{
+			best = timing.ns_per_op();
+			ret = timing.backend;
+		}
+	}
+	return ret;
+}
+
+cjm::differential_summary cjm::run_differential(size_t count, std::uint64_t seed, unsigned thread_count,
+	std::uint64_t first_record, operand_distribution distribution)
+{
+	using clock_t = std::chrono::steady_clock;
+	auto summary = differential_summary{};
+	for (size_t i = 0; i < int128_backend_count; ++i)
+	{
+		summary.timings[i].backend = static_cast<int128_backend>(i);
+		summary.timings[i].available = is_available(summary.timings[i].backend);
+	}
+	auto results = std::array<std::vector<int128_t>, int128_backend_count>{};
+	generate_random_blocks(seed, first_record, count, thread_count, [&](const std::vector<binary_operation>& block) -> void
+	{
+		for (size_t i = 0; i < int128_backend_count; ++i)
+		{
+			backend_timing& timing = summary.timings[i];
+			if (!timing.available)
+				continue;
+			const auto start = clock_t::now();
+			evaluate_block(timing.backend, block, results[i]);
+			timing.seconds += std::chrono::duration<double>(clock_t::now() - start).count();
+			timing.operations += block.size();
+		}
+		const std::vector<int128_t>& reference = results[static_cast<size_t>(int128_backend::abseil)];
+		for (size_t record = 0; record < block.size(); ++record)
+		{
+			bool disagrees = false;
+			for (size_t i = 1; i < int128_backend_count; ++i)
+			{
+				backend_timing& timing = summary.timings[i];
+				if (!timing.available || results[i][record] == reference[record])
+					continue;
+				disagrees = true;
+				++timing.disagreements;
+				if (summary.first_disagreements.size() < differential_summary::max_reported_disagreements)
+				{
+					summary.first_disagreements.push_back(backend_disagreement{ first_record + summary.records + record,
+						timing.backend, block[record], results[i][record] });
+				}
+			}
+			summary.disagreements += static_cast<std::uint64_t>(disagrees);
+		}
+		summary.records += block.size();
+	}, random_op_block_size, distribution);
+	return summary;
+}
+
+std::ostream& cjm::operator<<(std::ostream& ostr, const differential_summary& summary)
+{
+	ostr << "Evaluated " << summary.records << " records under " << int128_backend_count << " backends: "
+		<< summary.disagreements << " disagreements." << newl;
+	for (const backend_timing& timing : summary.timings)
+	{
+		ostr << '\t' << name(timing.backend) << ": ";
+		if (!timing.available)
+		{
+			ostr << "not available." << newl;
+			continue;
+		}
+		ostr << timing.ns_per_op() << " ns/op; " << timing.disagreements << " disagreements." << newl;
+	}
+	ostr << "Fastest backend: [" << name(summary.fastest()) << "]." << newl;
+	auto buffer = std::array<char, max_serialized_record_size>{};
+	for (const backend_disagreement& disagreement : summary.first_disagreements)
+	{
+		const binary_operation& op = disagreement.op;
+		const char* const end = format_record(buffer.data(), op.op_code(), op.left_operand(), op.right_operand(),
+			op.result().value_or(0));
+		ostr << "\tRecord " << disagreement.record << ": [" << fsv_t{ buffer.data(), static_cast<size_t>(end - buffer.data()) }
+			<< "]; " << name(disagreement.backend) << " gives [" << disagreement.value << "]." << newl;
+	}
+	return ostr;
+}
@@ -0,0 +1,83 @@
+#ifndef CJM_DIFFERENTIAL_HPP_
+#define CJM_DIFFERENTIAL_HPP_
+#include "helper.hpp"
+#include <array>
+#include <optional>
+#include <ostream>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	//independent implementations of int128 arithmetic a binary_operation can be evaluated with.
+	enum class int128_backend : unsigned int
+	{
+		abseil = 0, //absl::int128 (apply_op): the reference
+		native, //the compiler's __int128 / unsigned __int128 (gcc and clang on 64 bit targets only)
+		boost_multiprecision //boost::multiprecision::int128_t (signed magnitude) and uint128_t
+	};
+	constexpr size_t int128_backend_count = 3;
+	constexpr std::array<fsv_t, int128_backend_count> backend_name_lookup = { "absl::int128"sv, "__int128"sv,
+		"boost::multiprecision"sv };
+
+	struct backend_disagreement;
+	struct backend_timing;
+	struct differential_summary;
+
+	constexpr fsv_t name(int128_backend backend) noexcept
+	{
+		const auto idx = static_cast<size_t>(backend);
+		return idx < backend_name_lookup.size() ? backend_name_lookup[idx] : fsv_t{};
+	}
+
+	//false if the backend was not compiled in (native needs ABSL_HAVE_INTRINSIC_INT128).
+	bool is_available(int128_backend backend) noexcept;
+	//the result of op under backend; nullopt if the backend is unavailable or the operation is not defined (is_defined).
+	std::optional<int128_t> evaluate(int128_backend backend, binary_op op, int128_t lhs, int128_t rhs) noexcept;
+	//evaluates every operation of ops under backend into results (zero for undefined operations); returns false (leaving
+	//results empty) if the backend is unavailable.
+	bool evaluate_block(int128_backend backend, const std::vector<binary_operation>& ops, std::vector<int128_t>& results);
+	//evaluates records [first_record, first_record + count) of the random battery for seed under every available backend,
+	//timing each backend over the same blocks on the calling thread (generation uses thread_count workers).
+	differential_summary run_differential(size_t count, std::uint64_t seed, unsigned thread_count = 0,
+		std::uint64_t first_record = 0, operand_distribution distribution = operand_distribution::uniform);
+	std::ostream& operator<<(std::ostream& ostr, const differential_summary& summary);
+
+	//a record on which a backend's result differs from the reference (abseil) result.
+	struct backend_disagreement final
+	{
+		std::uint64_t record;
+		int128_backend backend;
+		binary_operation op; //as generated: with the reference result
+		int128_t value; //the backend's result
+	};
+
+	struct backend_timing final
+	{
+		int128_backend backend = int128_backend::abseil;
+		bool available = false;
+		std::uint64_t operations = 0;
+		double seconds = 0.0;
+		std::uint64_t disagreements = 0;
+
+		[[nodiscard]] double ns_per_op() const noexcept
+		{
+			return operations > 0 ? seconds * 1e9 / static_cast<double>(operations) : 0.0;
+		}
+	};
+
+	struct differential_summary final
+	{
+		static constexpr size_t max_reported_disagreements = 10;
+
+		std::uint64_t records = 0;
+		std::uint64_t disagreements = 0; //records on which any backend differs from the reference
+		std::array<backend_timing, int128_backend_count> timings{};
+		//the first max_reported_disagreements, in record order
+		std::vector<backend_disagreement> first_disagreements;
+
+		[[nodiscard]] bool passed() const noexcept { return disagreements == 0; }
+		//the available backend with the lowest ns/op
+		[[nodiscard]] int128_backend fastest() const noexcept;
+	};
+}
+#endif // CJM_DIFFERENTIAL_HPP_
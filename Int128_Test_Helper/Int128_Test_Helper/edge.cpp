@@ -0,0 +1,214 @@
+#include "edge.hpp"
+#include "parallel.hpp"
+#include "binary_format.hpp"
+#include "async_writer.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	using cjm::binary_op;
+
+	constexpr bool is_shift(binary_op op) noexcept
+	{
+		return op == binary_op::left_shift || op == binary_op::right_shift;
+	}
+
+	constexpr bool is_division(binary_op op) noexcept
+	{
+		return op == binary_op::divide || op == binary_op::modulus;
+	}
+}
+
+std::vector<cjm::int128_t> cjm::make_edge_values(const edge_value_set& set)
+{
+	auto ret = std::vector<int128_t>{};
+	if (set.boundaries)
+	{
+		ret.assign(edge_comparison_values.cbegin(), edge_comparison_values.cend());
+	}
+	if (set.powers_of_two)
+	{
+		for (int bit = 0; bit < 128; ++bit)
+		{
+			const uint128_t power = uint128_t{ 1 } << bit;
+			for (unsigned distance = 0; distance <= set.neighbours; ++distance)
+			{
+				for (const uint128_t value : { power + distance, power - distance })
+				{
+					ret.push_back(static_cast<int128_t>(value));
+					if (set.negations)
+						ret.push_back(static_cast<int128_t>(-value));
+				}
+			}
+		}
+	}
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
+}
+
+cjm::edge_cross_product::edge_cross_product(std::vector<int128_t> values) : m_values{ std::move(values) }, m_shift_amounts{},
+	m_divisors{}, m_op_offsets{}, m_undefined_slots{}
+{
+	if (m_values.empty())
+		throw std::invalid_argument{ "The edge cross product requires at least one value." };
+	std::sort(m_values.begin(), m_values.end());
+	m_values.erase(std::unique(m_values.begin(), m_values.end()), m_values.end());
+	for (const int128_t value : m_values)
+	{
+		m_shift_amounts.push_back(std::clamp(value, int128_t{ 0 }, int128_t{ 127 }));
+		if (value != 0)
+			m_divisors.push_back(value);
+	}
+	m_shift_amounts.erase(std::unique(m_shift_amounts.begin(), m_shift_amounts.end()), m_shift_amounts.end());
+
+	const bool has_min = std::binary_search(m_values.cbegin(), m_values.cend(), std::numeric_limits<int128_t>::min());
+	const bool has_minus_one = std::binary_search(m_values.cbegin(), m_values.cend(), int128_t{ -1 });
+	for (size_t op_idx = 0; op_idx < binary_op_count; ++op_idx)
+	{
+		const auto op = static_cast<binary_op>(op_idx);
+		m_op_offsets[op_idx + 1] = m_op_offsets[op_idx] + m_values.size() * right_operands(op).size();
+		//min is the first left operand
+		if (is_division(op) && has_min && has_minus_one)
+		{
+			const auto divisor_idx = static_cast<std::uint64_t>(std::lower_bound(m_divisors.cbegin(), m_divisors.cend(), int128_t{ -1 })
+				- m_divisors.cbegin());
+			m_undefined_slots.push_back(m_op_offsets[op_idx] + divisor_idx);
+		}
+	}
+}
+
+std::uint64_t cjm::edge_cross_product::size(std::uint64_t first_slot, size_t count) const noexcept
+{
+	const std::uint64_t end_slot = std::min(first_slot + count, slot_count());
+	if (first_slot >= end_slot)
+		return 0;
+	const auto undefined = std::count_if(m_undefined_slots.cbegin(), m_undefined_slots.cend(), [=](std::uint64_t slot) -> bool
+	{
+		return slot >= first_slot && slot < end_slot;
+	});
+	return end_slot - first_slot - static_cast<std::uint64_t>(undefined);
+}
+
+const std::vector<cjm::int128_t>& cjm::edge_cross_product::right_operands(binary_op op) const noexcept
+{
+	if (is_shift(op))
+		return m_shift_amounts;
+	return is_division(op) ? m_divisors : m_values;
+}
+
+void cjm::edge_cross_product::fill(std::uint64_t first_slot, size_t count, std::vector<binary_operation>& fill_me) const
+{
+	fill_me.clear();
+	const std::uint64_t end_slot = std::min(first_slot + count, slot_count());
+	if (first_slot >= end_slot)
+		return;
+	fill_me.reserve(static_cast<size_t>(end_slot - first_slot));
+	auto op_idx = static_cast<size_t>(std::upper_bound(m_op_offsets.cbegin(), m_op_offsets.cend(), first_slot)
+		- m_op_offsets.cbegin() - 1);
+	std::uint64_t slot = first_slot;
+	while (slot < end_slot)
+	{
+		assert(op_idx < binary_op_count);
+		const auto op = static_cast<binary_op>(op_idx);
+		const std::vector<int128_t>& rhs = right_operands(op);
+		const std::uint64_t offset = slot - m_op_offsets[op_idx];
+		auto left_idx = static_cast<size_t>(offset / rhs.size());
+		auto right_idx = static_cast<size_t>(offset % rhs.size());
+		const std::uint64_t op_end = std::min(end_slot, m_op_offsets[op_idx + 1]);
+		for (; slot < op_end; ++slot)
+		{
+			const int128_t lhs = m_values[left_idx];
+			if (is_defined(op, lhs, rhs[right_idx]))
+			{
+				fill_me.emplace_back(op, lhs, rhs[right_idx], true);
+			}
+			if (++right_idx == rhs.size())
+			{
+				right_idx = 0;
+				++left_idx;
+			}
+		}
+		++op_idx;
+	}
+}
+
+std::uint64_t cjm::write_edge_ops(fsv_t test_battery_name, fsv_t file_name, const edge_cross_product& edges,
+	std::uint64_t first_slot, size_t count, battery_format format, unsigned thread_count, text_encoding encoding)
+{
+	count = static_cast<size_t>(std::min<std::uint64_t>(count, first_slot < edges.slot_count() ? edges.slot_count() - first_slot : 0));
+	std::uint64_t written = 0;
+	if (format == battery_format::binary)
+	{
+		auto header = binary_battery_header{};
+		header.first_record = first_slot;
+		header.block_size = random_op_block_size;
+		header.set_engine_name(edge_engine_name);
+		auto writer = binary_battery_writer{ file_name, header };
+		generate_blocks(first_slot, count, thread_count, random_op_block_size,
+			[&](size_t, std::uint64_t block_idx, size_t skip, size_t length, std::vector<binary_operation>& block) -> void
+		{
+			edges.fill(block_idx * random_op_block_size + skip, length, block);
+		}, [&](const std::vector<binary_operation>& block) -> void
+		{
+			writer.write(block);
+		});
+		writer.close();
+		written = writer.count();
+	}
+	else
+	{
+		//workers format their blocks as well as computing them, as write_random_ops does.
+		written = edges.size(first_slot, count);
+		std::vector<std::vector<binary_operation>> ops(block_worker_count(first_slot, count, thread_count, random_op_block_size));
+		auto writer = async_file_writer{ file_name };
+		tstr_stream_t header;
+		header << battery_header{ test_battery_name, edge_engine_name, 0, random_op_block_size, first_slot, written };
+		writer.write(to_file_text(header.str(), encoding, true));
+		generate_blocks<char>(first_slot, count, thread_count, random_op_block_size,
+			[&](size_t worker, std::uint64_t block_idx, size_t skip, size_t length, std::vector<char>& text) -> void
+		{
+			edges.fill(block_idx * random_op_block_size + skip, length, ops[worker]);
+			text.clear();
+			append_file_text(text, ops[worker], encoding);
+		}, [&](const std::vector<char>& text) -> void
+		{
+			writer.write(text);
+		});
+		writer.close();
+	}
+	return written;
+}
+
+std::uint64_t cjm::serialize_edge_ops(fsv_t test_battery_name, fsv_t file_name, const edge_cross_product& edges,
+	std::uint64_t first_slot, size_t count, battery_format format, unsigned thread_count, text_encoding encoding)
+{
+	if (file_name.empty())
+	{
+		throw std::invalid_argument{ "File name supplied cannot be empty." };
+	}
+	if (count == 0 || first_slot >= edges.slot_count())
+	{
+		throw std::invalid_argument{ "The slice of the edge cross product must not be empty." };
+	}
+	std::uint64_t written = 0;
+	try
+	{
+		std::cout << "Saving " << std::min<std::uint64_t>(count, edges.slot_count() - first_slot) << " of the "
+			<< edges.slot_count() << " slots (" << edges.values().size() << " values crossed with " << binary_op_count
+			<< " ops) of " << test_battery_name << " to file [" << file_name << "] using " << resolve_thread_count(thread_count)
+			<< " threads... ";
+		written = write_edge_ops(test_battery_name, file_name, edges, first_slot, count, format, thread_count, encoding);
+	}
+	catch (const std::exception& ex)
+	{
+		fstr_stream_t message;
+		message << "Unable to save "sv << test_battery_name << " to file "sv << file_name
+			<< " because of exception: ["sv << ex.what() << "]."sv;
+		throw std::runtime_error{ message.str() };
+	}
+	std::cout << " successfully saved " << written << " operations of battery " << test_battery_name << " to file: ["
+		<< file_name << "]." << newl;
+	return written;
+}
@@ -0,0 +1,66 @@
+#ifndef CJM_EDGE_HPP_
+#define CJM_EDGE_HPP_
+#include "helper.hpp"
+#include <array>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	constexpr fsv_t edge_engine_name = "edges"sv;
+
+	struct edge_value_set;
+	class edge_cross_product;
+
+	//the distinct values of set, in ascending order.
+	std::vector<int128_t> make_edge_values(const edge_value_set& set);
+	//writes slots [first_slot, first_slot + count) of edges (undefined operations skipped) as a text or binary battery:
+	//workers compute (and, for text, format) their blocks; returns the number of records written.
+	std::uint64_t write_edge_ops(fsv_t test_battery_name, fsv_t file_name, const edge_cross_product& edges,
+		std::uint64_t first_slot, size_t count, battery_format format, unsigned thread_count,
+		text_encoding encoding = text_encoding::utf8);
+	//write_edge_ops with progress messages; count is clamped to the slots remaining after first_slot.
+	std::uint64_t serialize_edge_ops(fsv_t test_battery_name, fsv_t file_name, const edge_cross_product& edges,
+		std::uint64_t first_slot, size_t count, battery_format format, unsigned thread_count = 0,
+		text_encoding encoding = text_encoding::utf8);
+
+	//Boundary values for the edge cross product: with the defaults (boundaries, every power of two, its neighbours at
+	//distance one and all their negations) there are 760 distinct values.
+	struct edge_value_set final
+	{
+		bool boundaries = true; //edge_comparison_values
+		bool powers_of_two = true; //2^k for every k in [0, 128) (2^127 wraps to the minimum)
+		unsigned neighbours = 1; //2^k - neighbours ... 2^k + neighbours (requires powers_of_two)
+		bool negations = true; //the two's complement negation of every power of two and neighbour
+	};
+
+	//Every binary_op crossed with every (left, right) pair of a set of edge values, as an indexed sequence of slots so
+	//that any block of it can be computed independently: slots are ordered by op code, then left operand, then right
+	//operand.  Shift amounts are the values clamped to [0, 127] (without duplicates) and divisors exclude zero; the
+	//slots of min / -1 and min % -1 are undefined and skipped by fill.
+	class edge_cross_product final
+	{
+	public:
+		explicit edge_cross_product(std::vector<int128_t> values);
+
+		[[nodiscard]] const std::vector<int128_t>& values() const noexcept { return m_values; }
+		[[nodiscard]] const std::vector<int128_t>& right_operands(binary_op op) const noexcept;
+		[[nodiscard]] std::uint64_t slot_count() const noexcept { return m_op_offsets.back(); }
+		//the number of defined operations: slot_count less the undefined slots.
+		[[nodiscard]] std::uint64_t size() const noexcept { return slot_count() - m_undefined_slots.size(); }
+		//the number of defined operations among slots [first_slot, first_slot + count).
+		[[nodiscard]] std::uint64_t size(std::uint64_t first_slot, size_t count) const noexcept;
+
+		//replaces the contents of fill_me with the defined operations (with results) of slots
+		//[first_slot, first_slot + count).
+		void fill(std::uint64_t first_slot, size_t count, std::vector<binary_operation>& fill_me) const;
+
+	private:
+		std::vector<int128_t> m_values;
+		std::vector<int128_t> m_shift_amounts;
+		std::vector<int128_t> m_divisors;
+		//the first slot of each op code; the last element is slot_count
+		std::array<std::uint64_t, binary_op_count + 1> m_op_offsets;
+		std::vector<std::uint64_t> m_undefined_slots;
+	};
+}
+#endif // CJM_EDGE_HPP_
@@ -1,18 +1,58 @@
 #include "helper.hpp"
+#include "parallel.hpp"
+#include "binary_format.hpp"
+#include "hex.hpp"
+#include "benchmarks.hpp"
+#include "reader.hpp"
+#include "operation_table.hpp"
+#include "conversion.hpp"
+#include "mul_div.hpp"
+#include "shard.hpp"
+#include "async_writer.hpp"
+#include "compressed.hpp"
+#include "edge.hpp"
+#include "monitor.hpp"
 #include <vector>
 #include <cassert>
 #include <algorithm>
 #include <cstring>
-
-std::unique_ptr<cjm::cjm_helper_rgen> s_ptr = cjm::cjm_helper_rgen::make_rgen();  // NOLINT(clang-diagnostic-exit-time-destructors) YES ... I Know
+#include <charconv>
+#include <atomic>
 
 std::pair<bool, int> parse_int(cjm::fsv_t str) noexcept;
 
-std::uint64_t parse_u(cjm::tsv_t parse);
 
-std::int64_t parse_s(cjm::tsv_t parse);
+std::pair<cjm::fstr_arr_t, int> extract_positional(int argc, char* argv[]);
+
+std::pair<bool, std::uint64_t> parse_uint64(cjm::fsv_t str) noexcept;
+
+template<typename TOperations>
+void save_operations(cjm::fsv_t test_battery_name, cjm::fsv_t file_name, const TOperations& ops);
+
+//the time spent in each stage: as json if the json option is present (on summary_stream if it has no file name).
+void write_generation_summary(const cjm::generation_monitor& monitor, cjm::fsv_t battery_name, const cjm::cmd_args& files,
+	std::ostream& summary_stream);
+
+//points a stream at another buffer (if not null) until destroyed.
+class rdbuf_redirect final
+{
+public:
+	rdbuf_redirect(std::ios& stream, std::streambuf* buffer) noexcept
+		: m_stream{ stream }, m_saved{ buffer ? stream.rdbuf(buffer) : nullptr } {}
+	rdbuf_redirect(const rdbuf_redirect& other) = delete;
+	rdbuf_redirect(rdbuf_redirect&& other) noexcept = delete;
+	rdbuf_redirect& operator=(const rdbuf_redirect& other) = delete;
+	rdbuf_redirect& operator=(rdbuf_redirect&& other) noexcept = delete;
+	~rdbuf_redirect()
+	{
+		if (m_saved)
+			m_stream.rdbuf(m_saved);
+	}
 
-cjm::fstr_t to_fstr_t(cjm::tsv_t convert);
+private:
+	std::ios& m_stream;
+	std::streambuf* m_saved;
+};
 
 
 cjm::tstr_t cjm::to_tstr_t(fsv_t convert)
@@ -31,25 +71,21 @@ cjm::tstr_t cjm::to_tstr_t(fsv_t convert)
 
 cjm::tstr_t cjm::serialize(int128_t value)
 {
-	fstr_stream_t stream;
-	std::int64_t high = absl::Int128High64(value);
-	std::uint64_t low = absl::Int128Low64(value);
-	stream << std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill('0')
-		<< low << '\t'
-		<< std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill('0')
-		<< high << '\t';
-	auto temp = stream.str();
-	return to_tstr_t(temp);
+	auto ret = tstr_t(serialized_int128_size, tchar_t{});
+	format_int128(ret.data(), value);
+	return ret;
 }
 
 void cjm::serialize(tostrm_t& ostr, int128_t value)
 {
-	std::int64_t high = absl::Int128High64(value);
-	std::uint64_t low = absl::Int128Low64(value);
-	ostr << std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill(u'0')
-		<< low << u'\t'
-		<< std::hex << std::setw(sizeof(int64_t) * 2) << std::setfill(u'0')
-		<< high << u'\t';
+	auto buffer = std::array<tchar_t, serialized_int128_size>{};
+	format_int128(buffer.data(), value);
+	ostr.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+cjm::tchar_t* cjm::serialize(tchar_t* dest, int128_t value) noexcept
+{
+	return format_int128(dest, value);
 }
 
 bool cjm::operator==(binary_operation_serdeser lhs, binary_operation_serdeser rhs) noexcept
@@ -68,97 +104,116 @@ cjm::binary_operation_serdeser& cjm::operator<<(binary_operation_serdeser& bosds
 	return bosds;
 }
 
+cjm::tostrm_t& cjm::operator<<(tostrm_t& ostr, const battery_header& header)
+{
+	fstr_stream_t stream;
+	stream << "battery="sv << header.battery_name << "; format="sv << battery_header::format_version
+		<< "; engine="sv << header.engine_name << "; seed=0x"sv << std::hex << std::setw(sizeof(std::uint64_t) * 2)
+		<< std::setfill('0') << header.seed << std::dec << "; block_size="sv << header.block_size
+		<< "; first_record="sv << header.first_record << "; count="sv << header.count << "; dist="sv << name(header.distribution);
+	ostr << battery_header::comment_marker << u' ' << to_tstr_t(stream.str()) << binary_operation_serdeser::item_delimiter;
+	return ostr;
+}
+
 cjm::tostrm_t& cjm::operator<<(tostrm_t& ostr, const binary_operation_serdeser& other)
 {
-	constexpr auto field_delim = binary_operation_serdeser::item_field_delimiter;
 	if (other.has_value())
 	{
 		auto x = *other;
-		ostr << text(x.op_code()).value() << field_delim;
-		serialize(ostr, x.left_operand());
-		ostr << field_delim;
-		serialize(ostr, x.right_operand());
-		ostr << field_delim;
-		if (!x.has_correct_result())
+		//results computed up front (e.g. by generator worker threads) are not recomputed here.
+		if (!x.has_result())
 		{
 			x.calculate_result();
-			assert(x.has_correct_result());			
 		}
-		serialize(ostr, x.result().value());
-		ostr << field_delim;		
+		assert(x.has_correct_result());
+		auto buffer = std::array<tchar_t, max_serialized_record_size>{};
+		const tchar_t* const end = format_record(buffer.data(), x.op_code(), x.left_operand(), x.right_operand(), x.result().value());
+		ostr.write(buffer.data(), end - buffer.data());
 	}
 	return ostr;
 }
 
 cjm::int128_t cjm::deserialize(tsv_t deser_me)
 {
-	auto split = cjm::split(deser_me, u'\t');
-	if (split.empty())
+	if (deser_me.find_first_not_of(u'\t') == tsv_t::npos)
 	{
 		throw std::invalid_argument{ "string does not contain any text." };
 	}
-	tsv_t low;
-	tsv_t high;
-	size_t found = 0;
-	for (auto sv : split)
+	int128_t ret;
+	if (!try_parse_int128(deser_me, ret))
 	{
-		if (!sv.empty())
-		{
-			switch (found)
-			{
-			case 0:
-				low = sv;
-				++found;
-				break;
-			case 1:
-				high = sv;
-				++found;
-				break;
-			default:
-				throw std::invalid_argument{ "Too much data in string." };
-			}			
-		}
-		if (found >= 2)
-			break;
+		throw std::invalid_argument{ "Unable to parse supplied text as int128: expected low then high 64 bits as tab delimited hex." };
 	}
-	if (found < 2)
-	{
-		throw std::invalid_argument{ "Not enough data in string." };
-	}
-	try
+	return ret;
+}
+
+std::vector<cjm::binary_operation> cjm::edge_tests_comparison()
+{
+	auto ret = std::vector<binary_operation>{};
+	ret.reserve(edge_comparisons_v.size());
+	for (const edge_comparison& comparison : edge_comparisons_v)
 	{
-		std::uint64_t low_v = parse_u(low);
-		std::int64_t high_v = parse_s(high);
-		return absl::MakeInt128(high_v, low_v);
+		ret.emplace_back(binary_op::compare, comparison.lhs, comparison.rhs, comparison.result);
 	}
-	catch (const std::exception& ex)
+	return ret;
+}
+
+cjm::operation_table cjm::edge_comparison_table()
+{
+	auto ret = operation_table{};
+	ret.reserve(edge_comparisons_v.size());
+	for (const edge_comparison& comparison : edge_comparisons_v)
 	{
-		throw std::invalid_argument{ "Unable to parse supplied text as int128: "s + fstr_t{ex.what()} };
+		ret.push_back(binary_op::compare, comparison.lhs, comparison.rhs, comparison.result);
 	}
+	return ret;
 }
 
 std::vector<cjm::binary_operation> cjm::create_random_ops(size_t count)
 {
-	assert(s_ptr != nullptr);
 	auto ret = std::vector<cjm::binary_operation>();
 	ret.reserve(count);
+	cjm_helper_rgen& gen = thread_rgen();
 	while (ret.size() < count)
 	{
-		ret.emplace_back(s_ptr->random_operation());
+		ret.emplace_back(gen.random_operation());
 	}
 	return ret;
 }
 std::vector<cjm::binary_operation> cjm::create_random_ops(size_t count, binary_op op_code)
 {
-	assert(s_ptr != nullptr);
 	auto ret = std::vector<cjm::binary_operation>();
 	ret.reserve(count);
+	cjm_helper_rgen& gen = thread_rgen();
 	while (ret.size() < count)
 	{
-		ret.emplace_back(s_ptr->random_operation(op_code));
+		ret.emplace_back(gen.random_operation(op_code));
 	}
 	return ret;
 }
+
+void cjm::create_random_ops(std::vector<binary_operation>& fill_me, size_t count)
+{
+	fill_me.clear();
+	fill_me.reserve(count);
+	cjm_helper_rgen& gen = thread_rgen();
+	while (fill_me.size() < count)
+	{
+		fill_me.emplace_back(gen.random_operation());
+	}
+}
+
+void cjm::create_random_ops(operation_table& fill_me, size_t count)
+{
+	fill_me.clear();
+	fill_me.reserve(count);
+	cjm_helper_rgen& gen = thread_rgen();
+	while (fill_me.size() < count)
+	{
+		fill_me.push_back(gen.random_operation());
+	}
+}
+
 cjm::binary_operation::binary_operation() noexcept : m_op{ binary_op::left_shift }, m_lhs{}, m_rhs{} {}
 
 cjm::binary_operation::binary_operation(binary_op op, int128_t first_operand, int128_t second_operand,
@@ -200,44 +255,37 @@ cjm::int128_t cjm::binary_operation::perform_calculate_result(int128_t lhs, int1
 	switch (op)
 	{
 	case binary_op::left_shift:
-		ret = lhs << static_cast<int>(rhs);
+		ret = apply_op<binary_op::left_shift>(lhs, rhs);
 		break;
 	case binary_op::right_shift:
-		ret = lhs >> static_cast<int>(rhs);
+		ret = apply_op<binary_op::right_shift>(lhs, rhs);
 		break;
 	case binary_op::bw_and:
-		ret = lhs & rhs;
+		ret = apply_op<binary_op::bw_and>(lhs, rhs);
 		break;
 	case binary_op::bw_or:
-		ret = lhs | rhs;
+		ret = apply_op<binary_op::bw_or>(lhs, rhs);
 		break;
 	case binary_op::bw_xor:
-		ret = lhs ^ rhs;
+		ret = apply_op<binary_op::bw_xor>(lhs, rhs);
 		break;
 	case binary_op::divide:
-		ret = lhs / rhs;
+		ret = apply_op<binary_op::divide>(lhs, rhs);
 		break;
 	case binary_op::modulus:
-		ret = lhs % rhs;
+		ret = apply_op<binary_op::modulus>(lhs, rhs);
 		break;
 	case binary_op::add:
-		ret = lhs + rhs;
+		ret = apply_op<binary_op::add>(lhs, rhs);
 		break;
 	case binary_op::subtract:
-		ret = lhs - rhs;
+		ret = apply_op<binary_op::subtract>(lhs, rhs);
 		break;
 	case binary_op::multiply:
-		ret = lhs * rhs;
+		ret = apply_op<binary_op::multiply>(lhs, rhs);
 		break;
 	case binary_op::compare: 
-		if (lhs == rhs)
-		{
-			ret = 0;
-		}
-		else
-		{
-			ret = lhs > rhs ? 1 : -1;
-		}
+		ret = apply_op<binary_op::compare>(lhs, rhs);
 		break;
 	
 	}
@@ -304,19 +352,66 @@ int cjm::cmd_args::op_count() const noexcept
 
 bool cjm::cmd_args::good() const noexcept
 {
-	return !first_file().empty() && op_count() > 0;
+	return (!first_file().empty() || !m_options.requires_file()) && (op_count() > 0 || !m_options.requires_op_count());
 }
 
-cjm::cmd_args::cmd_args(const fstr_arr_t& arr, int num_ops): m_num_ops{num_ops}
+const cjm::cmd_options& cjm::cmd_args::options() const noexcept
 {
-	if (num_ops < 1)
+	return m_options;
+}
+
+unsigned cjm::cmd_args::thread_count() const noexcept
+{
+	return m_options.thread_count;
+}
+
+std::optional<std::uint64_t> cjm::cmd_args::seed() const noexcept
+{
+	return m_options.seed;
+}
+
+std::uint64_t cjm::cmd_args::first_record() const noexcept
+{
+	return m_options.first_record;
+}
+
+cjm::battery_format cjm::cmd_args::format() const noexcept
+{
+	return m_options.format;
+}
+
+cjm::fsv_t cjm::cmd_args::benchmark() const noexcept
+{
+	return m_options.benchmark;
+}
+
+bool cjm::cmd_args::verify() const noexcept
+{
+	return m_options.verify;
+}
+
+cjm::operand_distribution cjm::cmd_args::distribution() const noexcept
+{
+	return m_options.distribution;
+}
+
+cjm::rgen_engine cjm::cmd_args::engine() const noexcept
+{
+	return m_options.engine;
+}
+
+cjm::cmd_args::cmd_args(const fstr_arr_t& arr, int num_ops) : cmd_args{arr, num_ops, cmd_options{}} {}
+
+cjm::cmd_args::cmd_args(const fstr_arr_t& arr, int num_ops, const cmd_options& options): m_num_ops{num_ops}, m_options{options}
+{
+	if (num_ops < 1 && m_options.requires_op_count())
 		throw std::domain_error{"At least one operation must be specified."};
-	if (arr[0].empty())
+	if (arr[0].empty() && m_options.requires_file())
 		throw std::domain_error{"At least one file name must be specified."};
 	m_arr = arr;
 }
 
-cjm::cmd_args::cmd_args(cmd_args&& other) noexcept: m_num_ops(other.op_count()), m_arr{}
+cjm::cmd_args::cmd_args(cmd_args&& other) noexcept: m_num_ops(other.op_count()), m_arr{}, m_options{other.m_options}
 {
 	std::swap(m_arr[0], other.m_arr[0]);
 	std::swap(m_arr[1], other.m_arr[1]);
@@ -327,47 +422,266 @@ cjm::cmd_args& cjm::cmd_args::operator=(cmd_args&& other) noexcept
 	if (this != &other)
 	{
 		m_num_ops = other.m_num_ops;
+		m_options = other.m_options;
 		std::swap(m_arr[0], other.m_arr[0]);
 		std::swap(m_arr[1], other.m_arr[1]);
 	}
 	return *this;
 }
 
+bool cjm::cmd_options::is_option(fsv_t arg) noexcept
+{
+	return arg.size() > 2 && arg[0] == '-' && arg[1] == '-';
+}
+
+bool cjm::cmd_options::requires_file() const noexcept
+{
+	return benchmark.empty();
+}
+
+bool cjm::cmd_options::requires_op_count() const noexcept
+{
+	return !verify;
+}
+
+void cjm::cmd_options::apply(fsv_t option)
+{
+	assert(is_option(option));
+	const size_t equals_at = option.find('=');
+	const fsv_t name = option.substr(2, equals_at == fsv_t::npos ? fsv_t::npos : equals_at - 2);
+	const fsv_t value = equals_at == fsv_t::npos ? fsv_t{} : option.substr(equals_at + 1);
+	if (name == "threads"sv)
+	{
+		auto [is_number, threads] = parse_int(value);
+		if (!is_number || threads < 0)
+			throw std::domain_error{ "The threads option requires a non-negative integer (0 uses all cores)." };
+		thread_count = static_cast<unsigned>(threads);
+	}
+	else if (name == "seed"sv)
+	{
+		auto [is_number, parsed] = parse_uint64(value);
+		if (!is_number)
+			throw std::domain_error{ "The seed option requires an unsigned 64-bit integer (decimal or 0x-prefixed hex)." };
+		seed = parsed;
+	}
+	else if (name == "offset"sv)
+	{
+		auto [is_number, parsed] = parse_uint64(value);
+		if (!is_number)
+			throw std::domain_error{ "The offset option requires an unsigned 64-bit integer (decimal or 0x-prefixed hex)." };
+		first_record = parsed;
+	}
+	else if (name == "format"sv)
+	{
+		if (value == "text"sv)
+			format = battery_format::text;
+		else if (value == "binary"sv)
+			format = battery_format::binary;
+		else
+			throw std::domain_error{ "The format option must be either text or binary." };
+	}
+	else if (name == "encoding"sv)
+	{
+		if (value == "utf8"sv)
+			encoding = text_encoding::utf8;
+		else if (value == "utf16"sv)
+			encoding = text_encoding::utf16le;
+		else
+			throw std::domain_error{ "The encoding option must be either utf8 or utf16." };
+	}
+	else if (name == "bench"sv)
+	{
+		if (value.empty())
+			throw std::domain_error{ "The bench option requires the name of a benchmark." };
+		benchmark = fstr_t{ value };
+	}
+	else if (name == "verify"sv)
+	{
+		if (!value.empty())
+			throw std::domain_error{ "The verify option does not take a value." };
+		verify = true;
+	}
+	else if (name == "dist"sv)
+	{
+		const std::optional<operand_distribution> parsed = parse_distribution(value);
+		if (!parsed.has_value())
+			throw std::domain_error{ "The dist option must be uniform, stratified or wide." };
+		distribution = *parsed;
+	}
+	else if (name == "engine"sv)
+	{
+		const std::optional<rgen_engine> parsed = parse_engine(value);
+		if (!parsed.has_value())
+			throw std::domain_error{ "The engine option must be mt19937_64 or xoshiro256** (or xoshiro256ss)." };
+		engine = *parsed;
+	}
+	else if (name == "json"sv)
+	{
+		json = fstr_t{ value };
+	}
+	else if (name == "shards"sv)
+	{
+		auto [is_number, parsed] = parse_uint64(value);
+		if (!is_number || parsed == 0)
+			throw std::domain_error{ "The shards option requires a positive integer." };
+		shards = static_cast<size_t>(parsed);
+	}
+	else if (name == "compress"sv)
+	{
+		if (!value.empty())
+			throw std::domain_error{ "The compress option does not take a value." };
+		compress = true;
+	}
+	else if (name == "self_test"sv || name == "no_tests"sv)
+	{
+		//read by main (self_tests_requested); no_tests, now the default, is still accepted.
+		if (!value.empty())
+			throw std::domain_error{ "The " + fstr_t{ name } + " option does not take a value." };
+	}
+	else if (name == "progress"sv)
+	{
+		auto [is_number, parsed] = parse_uint64(value);
+		if (!is_number || parsed > std::numeric_limits<unsigned>::max())
+			throw std::domain_error{ "The progress option requires the number of seconds between progress lines (0 for none)." };
+		progress_seconds = static_cast<unsigned>(parsed);
+	}
+	else if (name == "edges"sv)
+	{
+		auto [is_number, parsed] = parse_uint64(value);
+		if (!value.empty() && (!is_number || parsed > 64))
+			throw std::domain_error{ "The edges option takes the distance (at most 64) of the neighbours of each power of two." };
+		edges = value.empty() ? edge_value_set{}.neighbours : static_cast<unsigned>(parsed);
+	}
+	else if (name == "mul_div"sv)
+	{
+		if (!value.empty())
+			throw std::domain_error{ "The mul_div option does not take a value." };
+		mul_div = true;
+	}
+	else if (name == "conversions"sv)
+	{
+		auto frequencies = std::vector<std::int64_t>{};
+		if (value.empty())
+		{
+			frequencies.assign(default_stopwatch_frequencies.cbegin(), default_stopwatch_frequencies.cend());
+		}
+		for (fsv_t rest = value; !rest.empty();)
+		{
+			const size_t comma = rest.find(',');
+			auto [is_number, frequency] = parse_uint64(rest.substr(0, comma));
+			if (!is_number || frequency == 0 || frequency > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+				throw std::domain_error{ "The conversions option takes a comma separated list of positive stopwatch frequencies (Hz)." };
+			frequencies.push_back(static_cast<std::int64_t>(frequency));
+			rest = comma == fsv_t::npos ? fsv_t{} : rest.substr(comma + 1);
+		}
+		conversions = std::move(frequencies);
+	}
+	else
+	{
+		throw std::domain_error{ "Unrecognized option: ["s + fstr_t{ option } + "]."s };
+	}
+}
+
 std::unique_ptr<cjm::cjm_helper_rgen> cjm::cjm_helper_rgen::make_rgen()
 {
 	auto* tmp = new cjm_helper_rgen();
 	return std::unique_ptr<cjm_helper_rgen>{tmp};
 }
 
+std::unique_ptr<cjm::cjm_helper_rgen> cjm::cjm_helper_rgen::make_rgen(std::uint64_t seed, operand_distribution distribution,
+	rgen_engine engine)
+{
+	auto* tmp = new cjm_helper_rgen(seed, distribution, engine);
+	return std::unique_ptr<cjm_helper_rgen>{tmp};
+}
+
+void cjm::cjm_helper_rgen::reseed(std::uint64_t seed)
+{
+	m_seed = seed;
+	if (m_engine == rgen_engine::xoshiro256ss)
+	{
+		m_xoshiro.seed(m_seed);
+		m_block_origin = m_xoshiro;
+		m_block_idx = 0;
+		return;
+	}
+	m_twister.seed(m_seed);
+	m_op_distrib.reset();
+	m_shift_distrib.reset();
+	m_operand_distrib.reset();
+	m_stratum_distrib.reset();
+}
+
+void cjm::cjm_helper_rgen::seek_block(std::uint64_t base_seed, std::uint64_t block_idx)
+{
+	if (m_engine == rgen_engine::mt19937_64)
+	{
+		reseed(derive_block_seed(base_seed, block_idx));
+		return;
+	}
+	if (base_seed != m_seed || block_idx < m_block_idx)
+	{
+		reseed(base_seed);
+	}
+	m_block_origin.jump(block_idx - m_block_idx);
+	m_block_idx = block_idx;
+	m_xoshiro = m_block_origin;
+}
+
+inline std::uint64_t cjm::cjm_helper_rgen::next_bits()
+{
+	return m_engine == rgen_engine::xoshiro256ss ? m_xoshiro() : m_twister();
+}
+
+inline std::uint64_t cjm::cjm_helper_rgen::next_below(std::uint64_t range)
+{
+	return m_engine == rgen_engine::xoshiro256ss ? bounded_uniform(m_xoshiro, range) : m_twister() % range;
+}
+
+template<typename TInt>
+TInt cjm::cjm_helper_rgen::next_in(std::uniform_int_distribution<TInt>& distrib)
+{
+	if (m_engine == rgen_engine::mt19937_64)
+		return distrib(m_twister);
+	using unsigned_t = std::make_unsigned_t<TInt>;
+	const auto range = static_cast<std::uint64_t>(static_cast<unsigned_t>(distrib.b()) - static_cast<unsigned_t>(distrib.a())) + 1;
+	return static_cast<TInt>(static_cast<unsigned_t>(distrib.a()) + static_cast<unsigned_t>(bounded_uniform(m_xoshiro, range)));
+}
+
 cjm::binary_op cjm::cjm_helper_rgen::random_binary_op()
 {
-	const auto value = m_op_distrib(m_twister);
+	const auto value = next_in(m_op_distrib);
 	return static_cast<binary_op>(value);
 }
 
 cjm::int128_t cjm::cjm_helper_rgen::random_shift_arg()
 {
-	const auto value = m_shift_distrib(m_twister);
+	const auto value = next_in(m_shift_distrib);
 	assert(value > -1 && value < 128);
 	return value;
 }
 
 cjm::int128_t cjm::cjm_helper_rgen::random_operand_arg()
 {
-	const auto value = m_operand_distrib(m_twister);
+	const auto value = next_in(m_operand_distrib);
 	assert(value > std::numeric_limits<std::int64_t>::min() && value <= std::numeric_limits<std::int64_t>::max());
 	return value;
 }
 
 cjm::binary_operation cjm::cjm_helper_rgen::random_operation(binary_op op)
 {
+	if (m_distribution == operand_distribution::stratified)
+		return random_stratified_operation(op);
+	if (m_distribution == operand_distribution::wide &&
+		(op == binary_op::multiply || op == binary_op::divide || op == binary_op::modulus))
+		return random_wide_operation(op);
 	int128_t l_op;
 	int128_t r_op;
 
 	const auto make_full_range = [&]() -> int128_t
 	{
-		std::uint64_t high = m_operand_distrib(m_twister);
-		std::uint64_t low = m_operand_distrib(m_twister);
+		std::uint64_t high = next_in(m_operand_distrib);
+		std::uint64_t low = next_in(m_operand_distrib);
 		uint128_t temp = high;
 		temp <<= 64;
 		temp |= low;
@@ -378,8 +692,8 @@ cjm::binary_operation cjm::cjm_helper_rgen::random_operation(binary_op op)
 	{
 	case binary_op::left_shift: 		
 	case binary_op::right_shift:
-		l_op = m_operand_distrib(m_twister);
-		r_op = m_shift_distrib(m_twister);
+		l_op = next_in(m_operand_distrib);
+		r_op = next_in(m_shift_distrib);
 		break;
 	case binary_op::compare:
 	case binary_op::add:
@@ -398,11 +712,11 @@ cjm::binary_operation cjm::cjm_helper_rgen::random_operation(binary_op op)
 		//temp <<= 64;
 		//temp |= low;
 		l_op = make_full_range();
-		r_op = m_operand_distrib(m_twister);		
+		r_op = next_in(m_operand_distrib);		
 		break;
 	case binary_op::multiply:
-		l_op = m_operand_distrib(m_twister);
-		r_op = m_operand_distrib(m_twister);
+		l_op = next_in(m_operand_distrib);
+		r_op = next_in(m_operand_distrib);
 		break;
 	default:  // NOLINT(clang-diagnostic-covered-switch-default)
 		l_op = 0;
@@ -419,48 +733,346 @@ cjm::binary_operation cjm::cjm_helper_rgen::random_operation()
 	return random_operation(op);
 }
 
+cjm::binary_operation cjm::cjm_helper_rgen::random_stratified_operation(binary_op op)
+{
+	const int128_t l_op = random_stratified_operand();
+	int128_t r_op;
+	switch (op)
+	{
+	case binary_op::left_shift:
+	case binary_op::right_shift:
+		r_op = random_stratified_shift_arg();
+		break;
+	default:
+		do
+		{
+			r_op = random_stratified_operand();
+		} while (!is_defined(op, l_op, r_op));
+		break;
+	}
+	return binary_operation{ op, l_op, r_op };
+}
 
-cjm::cjm_helper_rgen::cjm_helper_rgen() :  m_seed{ static_cast<std::mt19937_64::result_type>(std::chrono::duration_cast<std::chrono::microseconds>(
-	                                           std::chrono::system_clock::now().time_since_epoch()
-                                           ).count()) }, m_twister{ m_seed }, m_op_distrib{ std::uniform_int_distribution<int>(std::int64_t{0}, static_cast<std::int64_t>(op_name_lookup.size()) - std::int64_t{1}) },
-                                           m_shift_distrib{ std::uniform_int_distribution<int>(0, 127)},
-                                           m_operand_distrib{ std::uniform_int_distribution<std::int64_t>(std::numeric_limits<std::int64_t>::min() + std::int64_t{1},
-	                                           std::numeric_limits<std::int64_t>::max()) }
+cjm::int128_t cjm::cjm_helper_rgen::random_stratified_operand()
 {
-	std::cout << "Hi mom!" << newl;
+	constexpr int128_t max = std::numeric_limits<int128_t>::max();
+	constexpr int128_t min = std::numeric_limits<int128_t>::min();
+	constexpr auto extremes = std::array<int128_t, 4>{ min, min + 1, max - 1, max };
+	const auto limb_boundaries = std::array<uint128_t, 6>{ (uint128_t{ 1 } << 63) - 1, uint128_t{ 1 } << 63,
+		(uint128_t{ 1 } << 63) + 1, (uint128_t{ 1 } << 64) - 1, uint128_t{ 1 } << 64, (uint128_t{ 1 } << 64) + 1 };
+	const auto pick = [this](size_t count) -> size_t
+	{
+		return static_cast<size_t>(next_below(count));
+	};
+	const auto bit_length_between = [this](int min_bits, int max_bits) -> int
+	{
+		return min_bits + static_cast<int>(next_below(static_cast<std::uint64_t>(max_bits - min_bits + 1)));
+	};
+
+	const auto stratum = static_cast<operand_stratum>(next_in(m_stratum_distrib));
+	const bool negative = (next_bits() & 1u) != 0;
+	uint128_t magnitude;
+	switch (stratum)
+	{
+	case operand_stratum::zero:
+		return 0;
+	case operand_stratum::extreme:
+		return extremes[pick(extremes.size())];
+	case operand_stratum::unit:
+		magnitude = 1;
+		break;
+	case operand_stratum::limb_boundary:
+		magnitude = limb_boundaries[pick(limb_boundaries.size())];
+		break;
+	case operand_stratum::carry_pattern:
+		magnitude = absl::MakeUint128(absl::Uint128Low64(random_magnitude(bit_length_between(1, 62))),
+			(next_bits() & 1u) != 0 ? std::numeric_limits<std::uint64_t>::max() : 0);
+		break;
+	case operand_stratum::small:
+		magnitude = random_magnitude(bit_length_between(2, 32));
+		break;
+	case operand_stratum::low_limb:
+		magnitude = random_magnitude(bit_length_between(33, 64));
+		break;
+	case operand_stratum::high_limb:
+		magnitude = random_magnitude(bit_length_between(65, 126));
+		break;
+	default:  // NOLINT(clang-diagnostic-covered-switch-default)
+	case operand_stratum::full_width:
+		magnitude = random_magnitude(127);
+		break;
+	}
+	const auto value = static_cast<int128_t>(magnitude);
+	return negative ? -value : value;
+}
+
+cjm::int128_t cjm::cjm_helper_rgen::random_stratified_shift_arg()
+{
+	//half of all shifts are by an amount at a limb or width boundary.
+	constexpr auto boundary_shifts = std::array<int, 7>{ 0, 1, 63, 64, 65, 126, 127 };
+	if ((next_bits() & 1u) != 0)
+		return boundary_shifts[static_cast<size_t>(next_below(boundary_shifts.size()))];
+	return next_in(m_shift_distrib);
 }
 
+//Divisors have a non-zero high limb (65 to 127 bits), so every division takes the 128 / 128 bit path.  Half of all
+//multiplications have operand bit lengths summing to 127 - 130, so the product is within a few bits of overflowing
+//(and overflows roughly half the time); the rest multiply two operands of 65 to 127 bits and always truncate.
+cjm::binary_operation cjm::cjm_helper_rgen::random_wide_operation(binary_op op)
+{
+	assert(op == binary_op::multiply || op == binary_op::divide || op == binary_op::modulus);
+	const auto bit_length_between = [this](int min_bits, int max_bits) -> int
+	{
+		return min_bits + static_cast<int>(next_below(static_cast<std::uint64_t>(max_bits - min_bits + 1)));
+	};
+	const auto signed_value = [this](uint128_t magnitude) -> int128_t
+	{
+		const auto value = static_cast<int128_t>(magnitude);
+		return (next_bits() & 1u) != 0 ? -value : value;
+	};
+
+	int128_t l_op;
+	int128_t r_op;
+	if (op == binary_op::multiply)
+	{
+		int l_bits;
+		int r_bits;
+		if ((next_bits() & 1u) != 0)
+		{
+			l_bits = bit_length_between(1, 127);
+			r_bits = std::clamp(bit_length_between(127, 130) - l_bits, 1, 127);
+		}
+		else
+		{
+			l_bits = bit_length_between(65, 127);
+			r_bits = bit_length_between(65, 127);
+		}
+		l_op = signed_value(random_magnitude(l_bits));
+		r_op = signed_value(random_magnitude(r_bits));
+	}
+	else
+	{
+		const std::uint64_t high = next_bits();
+		l_op = static_cast<int128_t>(absl::MakeUint128(high, next_bits()));
+		r_op = signed_value(random_magnitude(bit_length_between(65, 127)));
+	}
+	assert(is_defined(op, l_op, r_op));
+	return binary_operation{ op, l_op, r_op };
+}
+
+//uniformly distributed among the values whose highest set bit is bit_length - 1.
+cjm::uint128_t cjm::cjm_helper_rgen::random_magnitude(int bit_length)
+{
+	assert(bit_length > 0 && bit_length <= 128);
+	const std::uint64_t high = next_bits();
+	const uint128_t bits = absl::MakeUint128(high, next_bits());
+	const uint128_t top = uint128_t{ 1 } << (bit_length - 1);
+	return (bits & (top - 1)) | top;
+}
+
+
+cjm::cjm_helper_rgen::cjm_helper_rgen() : cjm_helper_rgen{random_seed(), operand_distribution::uniform, rgen_engine::mt19937_64} {}
+
+cjm::cjm_helper_rgen::cjm_helper_rgen(std::uint64_t seed, operand_distribution distribution, rgen_engine engine) :  m_seed{ seed }, m_distribution{ distribution }, m_engine{ engine }, m_twister{ m_seed },
+                                           m_xoshiro{ m_seed }, m_block_origin{ m_seed }, m_block_idx{ 0 }, m_op_distrib{ std::uniform_int_distribution<int>(std::int64_t{0}, static_cast<std::int64_t>(op_name_lookup.size()) - std::int64_t{1}) },
+                                           m_shift_distrib{ std::uniform_int_distribution<int>(0, 127)},
+                                           m_operand_distrib{ std::uniform_int_distribution<std::int64_t>(std::numeric_limits<std::int64_t>::min() + std::int64_t{1},
+	                                           std::numeric_limits<std::int64_t>::max()) },
+                                           m_stratum_distrib{ std::uniform_int_distribution<int>(0, static_cast<int>(operand_stratum_count) - 1) }
+{}
+
 int cjm::execute(int argc, char* argv[])
 {
 	try
 	{
 		cmd_args files = extract_arr(argc, argv);
-		assert(files.good() && !files.first_file().empty() && files.op_count() > 0);
+		assert(files.good());
+		if (!files.benchmark().empty())
+		{
+			if (!files.options().json.has_value())
+			{
+				std::cout << "Benchmark: [" << files.benchmark() << "]; number of ops: [" << files.op_count()
+					<< "]; operand distribution: [" << name(files.distribution()) << "]." << newl;
+			}
+			bench::run_benchmark(files.benchmark(), static_cast<size_t>(files.op_count()), files.seed().value_or(random_seed()),
+				files.thread_count(), files.distribution(), files.options().json);
+			return 0;
+		}
+		if (files.verify())
+		{
+			bool passed = true;
+			for (const fsv_t file : { files.first_file(), files.second_file() })
+			{
+				if (file.empty())
+					continue;
+				const verify_summary summary = verify_battery(file, files.thread_count());
+				std::cout << summary;
+				passed = passed && summary.passed();
+			}
+			return passed ? 0 : 1;
+		}
+		assert(!files.first_file().empty());
+		//with a bare json option the generation summary is all that goes to stdout: status and progress lines go to stderr.
+		const std::optional<fstr_t>& json_file = files.options().json;
+		std::ostream summary_stream{ std::cout.rdbuf() };
+		const auto status_redirect = rdbuf_redirect{ std::cout,
+			json_file.has_value() && json_file->empty() ? std::cerr.rdbuf() : nullptr };
 		std::cout << "First file name: [" << files.first_file() << "]." << newl;
 		std::cout << "Second file name: [" << files.second_file() << "]." << newl;
 		std::cout << "Number of ops: [" << files.op_count() << "]." << newl;
 
 		constexpr fsv_t comp_edge_batter = "Comparison Edge Case Test Battery";
 		constexpr fsv_t comp_edge_case_file = "comp_edge_ops.txt"sv;
+		constexpr fsv_t random_battery = "Random Operation Test Battery"sv;
+		constexpr fsv_t conversion_battery = "Tick Conversion Test Battery"sv;
+		constexpr fsv_t mul_div_battery = "MulDiv Test Battery"sv;
+		constexpr fsv_t edge_battery = "Edge Cross Product Test Battery"sv;
 
+		const std::uint64_t seed = files.seed().value_or(random_seed());
+		std::cout << "Seed: [0x" << std::hex << seed << std::dec << "]; first record: [" << files.first_record()
+			<< "]; operand distribution: [" << name(files.distribution()) << "]; engine: [" << name(files.engine()) << "]." << newl;
+		if (files.engine() != rgen_engine::mt19937_64 && (files.options().mul_div || files.options().conversions.has_value()
+			|| files.options().edges.has_value()))
+			throw std::domain_error{ "The engine option only applies to random batteries." };
+		if (files.options().shards > 0 && (files.options().mul_div || files.options().conversions.has_value()))
+			throw std::domain_error{ "Only random batteries can be sharded." };
+		if (files.options().encoding != text_encoding::utf8 && (files.format() == battery_format::binary || files.options().mul_div))
+			throw std::domain_error{ "Only random and conversion text batteries can be written as UTF-16." };
+		if (files.options().compress && (files.options().shards > 0 || files.options().mul_div
+			|| files.options().conversions.has_value() || files.format() == battery_format::binary))
+			throw std::domain_error{ "Only single file random text batteries can be compressed." };
+		if (files.options().edges.has_value() && (files.options().shards > 0 || files.options().mul_div
+			|| files.options().conversions.has_value() || files.options().compress))
+			throw std::domain_error{ "The edge cross product cannot be combined with the shards, mul_div, conversions or compress options." };
+		if (files.options().edges.has_value())
+		{
+			auto set = edge_value_set{};
+			set.neighbours = *files.options().edges;
+			serialize_edge_ops(edge_battery, files.first_file(), edge_cross_product{ make_edge_values(set) }, files.first_record(),
+				static_cast<size_t>(files.op_count()), files.format(), files.thread_count(), files.options().encoding);
+		}
+		else if (files.options().shards > 0)
+		{
+			std::cout << "Saving " << files.op_count() << " operations of " << random_battery << " as " << files.options().shards
+				<< " shards of [" << files.first_file() << "] using " << resolve_thread_count(files.thread_count()) << " threads..." << newl;
+			std::cout << write_sharded_battery(random_battery, files.first_file(), static_cast<size_t>(files.op_count()), seed,
+				files.options().shards, files.format(), files.thread_count(), files.first_record(), files.distribution(),
+				files.engine(), files.options().encoding);
+			std::cout << "Manifest: [" << manifest_file_name(files.first_file()) << "]." << newl;
+		}
+		else if (files.options().mul_div)
+		{
+			if (files.format() == battery_format::binary)
+				throw std::domain_error{ "MulDiv batteries are only written in the text format." };
+			serialize_mul_div_ops(mul_div_battery, files.first_file(), static_cast<size_t>(files.op_count()), seed,
+				files.thread_count(), files.first_record());
+		}
+		else if (files.options().conversions.has_value())
+		{
+			const std::vector<round_trip_stats> stats = serialize_conversion_ops(conversion_battery, files.first_file(),
+				static_cast<size_t>(files.op_count()), seed, *files.options().conversions, files.format(), files.thread_count(),
+				files.first_record(), files.options().encoding);
+			std::cout << "Round trips of TimeSpan ticks through Stopwatch ticks:" << newl;
+			for (const round_trip_stats& frequency_stats : stats)
+			{
+				std::cout << frequency_stats;
+			}
+		}
+		else if (files.options().compress)
+		{
+			serialize_compressed_random_ops(random_battery, files.first_file(), static_cast<size_t>(files.op_count()), seed,
+				files.thread_count(), files.first_record(), files.distribution(), files.engine(), files.options().encoding);
+		}
+		else
+		{
+			auto monitor = generation_monitor{ static_cast<std::uint64_t>(files.op_count()), &std::cout,
+				std::chrono::seconds{ files.options().progress_seconds } };
+			if (files.format() == battery_format::binary)
+			{
+				serialize_random_ops_binary(random_battery, files.first_file(), static_cast<size_t>(files.op_count()), seed,
+					files.thread_count(), files.first_record(), files.distribution(), files.engine(), &monitor);
+			}
+			else
+			{
+				serialize_random_ops(random_battery, files.first_file(), static_cast<size_t>(files.op_count()), seed,
+					files.thread_count(), files.first_record(), files.distribution(), files.engine(), files.options().encoding,
+					&monitor);
+			}
+			write_generation_summary(monitor, random_battery, files, summary_stream);
+		}
 
-		fsv_t this_battery = comp_edge_batter;
-		fsv_t this_file = comp_edge_case_file;
-		const std::vector<binary_operation>* this_vector = &edge_tests_comparison_v;
-		
-		serialize_binary_ops(this_battery, this_file, *this_vector);
-		//std::cout << "Going to write comparison edge case"
+		fsv_t edge_file = files.second_file().empty() ? comp_edge_case_file : files.second_file();
+		serialize_binary_ops(comp_edge_batter, edge_file, edge_comparison_table());
 	}
 	catch (const std::domain_error& ex)
 	{
 		std::cerr << "Error: [" << ex.what()  << "]." << newl;
 		return -1;
 	}
+	catch (const std::runtime_error& ex)
+	{
+		std::cerr << "Error: [" << ex.what() << "]." << newl;
+		return -1;
+	}
+	catch (const std::invalid_argument& ex)
+	{
+		std::cerr << "Error: [" << ex.what() << "]." << newl;
+		return -1;
+	}
 	return 0;
 }
 
+bool cjm::self_tests_requested(int argc, char* argv[]) noexcept
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (fsv_t{ argv[i] } == "--self_test"sv)
+			return true;
+	}
+	return false;
+}
+
 cjm::cmd_args cjm::extract_arr(int argc, char* argv[])
 {
+	cmd_options options{};
+	std::vector<char*> positional;
+	positional.reserve(argc > 0 ? static_cast<size_t>(argc) : size_t{ 0 });
+	for (int i = 0; i < argc; ++i)
+	{
+		if (i > 0 && cmd_options::is_option(argv[i]))
+		{
+			options.apply(argv[i]);
+		}
+		else
+		{
+			positional.push_back(argv[i]);
+		}
+	}
+	if (options.verify)
+	{
+		if (!options.benchmark.empty())
+			throw std::domain_error{ "The verify and bench options cannot be combined." };
+		if (positional.size() < 2 || positional.size() > 3)
+			throw std::domain_error{ "The verify option requires one or two battery file names." };
+		fstr_arr_t arr;
+		arr[0] = positional[1];
+		arr[1] = positional.size() == 3 ? fstr_t{ positional[2] } : fstr_t{};
+		return cmd_args{ arr, 0, options };
+	}
+	if (!options.requires_file() && positional.size() == 2)
+	{
+		auto [is_number, num_ops] = parse_int(positional[1]);
+		if (!is_number || num_ops <= 0)
+			throw std::domain_error{ "Number of operations specified must be positive." };
+		return cmd_args{ fstr_arr_t{}, num_ops, options };
+	}
+	auto [arr, num_ops] = extract_positional(static_cast<int>(positional.size()), positional.data());
+	return cmd_args{ arr, num_ops, options };
+}
+
+std::pair<cjm::fstr_arr_t, int> extract_positional(int argc, char* argv[])
+{
+	using namespace cjm;
 	fstr_arr_t arr;
 	if (argc > 0)
 	{
@@ -548,13 +1160,25 @@ cjm::cmd_args cjm::extract_arr(int argc, char* argv[])
 		}
 		arr[0] = first_file_name;
 		arr[1] = second_file_name;
-		return cmd_args{ arr, int_val };
+		return std::make_pair(arr, int_val);
 	}
 	throw std::domain_error{ "Two arguments needed: file name and positive integer.  Third file name optional." };
 }
 
 void cjm::serialize_binary_ops(fsv_t test_battery_name, fsv_t file_name, const std::vector<binary_operation>& ops)
 {
+	save_operations(test_battery_name, file_name, ops);
+}
+
+void cjm::serialize_binary_ops(fsv_t test_battery_name, fsv_t file_name, const operation_table& ops)
+{
+	save_operations(test_battery_name, file_name, ops);
+}
+
+template<typename TOperations>
+void save_operations(cjm::fsv_t test_battery_name, cjm::fsv_t file_name, const TOperations& ops)
+{
+	using namespace cjm;
 	if (file_name.empty())
 	{
 		throw std::invalid_argument{ "File name supplied cannot be empty." };
@@ -580,7 +1204,140 @@ void cjm::serialize_binary_ops(fsv_t test_battery_name, fsv_t file_name, const s
 		throw std::runtime_error{ message.str() };
 	}
 	std::cout << " successfully saved battery " << test_battery_name << " to file: [" << file_name << "]." << newl;
- }
+}
+
+void cjm::serialize_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+	unsigned thread_count, std::uint64_t first_record, operand_distribution distribution, rgen_engine engine,
+	text_encoding encoding, generation_monitor* monitor)
+{
+	if (file_name.empty())
+	{
+		throw std::invalid_argument{ "File name supplied cannot be empty." };
+	}
+	if (count == 0)
+	{
+		throw std::invalid_argument{ "Count of operations must be positive." };
+	}
+	try
+	{
+		std::cout << "Saving " << count << " operations of " << test_battery_name << " to file [" << file_name << "] using "
+			<< resolve_thread_count(thread_count) << " threads... ";
+		write_random_ops(test_battery_name, file_name, count, seed, thread_count, first_record, distribution, engine, encoding,
+			monitor);
+	}
+	catch (const std::exception& ex)
+	{
+		fstr_stream_t message;
+		message << "Unable to save "sv << test_battery_name << " to file "sv << file_name
+			<< " because of exception: ["sv << ex.what() << "]."sv;
+		throw std::runtime_error{ message.str() };
+	}
+	std::cout << " successfully saved battery " << test_battery_name << " to file: [" << file_name << "]." << newl;
+}
+
+void cjm::write_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+	unsigned thread_count, std::uint64_t first_record, operand_distribution distribution, rgen_engine engine,
+	text_encoding encoding, generation_monitor* monitor)
+{
+	//workers format their blocks as well as generating them; this thread only copies them to the writer's buffers.
+	auto writer = async_file_writer{ file_name };
+	tstr_stream_t header;
+	header << battery_header{ test_battery_name, name(engine), seed, random_op_block_size, first_record, count,
+		distribution };
+	writer.write(to_file_text(header.str(), encoding, true));
+	const size_t workers = block_worker_count(first_record, count, thread_count, random_op_block_size);
+	std::vector<std::unique_ptr<cjm_helper_rgen>> generators;
+	std::vector<std::vector<binary_operation>> ops(workers);
+	generators.reserve(workers);
+	for (size_t i = 0; i < workers; ++i)
+	{
+		generators.emplace_back(cjm_helper_rgen::make_rgen(seed, distribution, engine));
+	}
+	std::uint64_t next_record = first_record;
+	generate_blocks<char>(first_record, count, thread_count, random_op_block_size,
+		[&](size_t worker, std::uint64_t block_idx, size_t skip, size_t length, std::vector<char>& text) -> void
+	{
+		generate_random_block(*generators[worker], seed, block_idx, skip, length, ops[worker], monitor);
+		const auto timer = stage_timer{ monitor, generation_stage::format, length };
+		text.clear();
+		append_file_text(text, ops[worker], encoding);
+	}, [&](const std::vector<char>& text) -> void
+	{
+		writer.write(text);
+		//blocks arrive in order: each runs to the end of its block or of the slice.
+		const std::uint64_t block_end = std::min((next_record / random_op_block_size + 1) * random_op_block_size,
+			first_record + count);
+		if (monitor)
+			monitor->complete(block_end - next_record);
+		next_record = block_end;
+	});
+	writer.close();
+	if (monitor)
+		monitor->add(generation_stage::io_wait, writer.bytes_written(), writer.wait_time());
+}
+
+cjm::cjm_helper_rgen& cjm::thread_rgen()
+{
+	static std::atomic<std::uint64_t> s_next_stream{ 0 };
+	thread_local const std::unique_ptr<cjm_helper_rgen> t_ptr =  // NOLINT(clang-diagnostic-exit-time-destructors)
+		cjm_helper_rgen::make_rgen(derive_block_seed(thread_rgen_base_seed(), s_next_stream.fetch_add(1, std::memory_order_relaxed)));
+	return *t_ptr;
+}
+
+std::uint64_t cjm::thread_rgen_base_seed()
+{
+	static const std::uint64_t s_base_seed = random_seed();
+	return s_base_seed;
+}
+
+cjm::fstr_t cjm::json_escape(fsv_t text)
+{
+	constexpr std::array<char, 16> hex_digits = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+	auto ret = fstr_t{};
+	ret.reserve(text.size());
+	for (const char c : text)
+	{
+		switch (c)
+		{
+		case '"':
+			ret += "\\\"";
+			break;
+		case '\\':
+			ret += "\\\\";
+			break;
+		case '\n':
+			ret += "\\n";
+			break;
+		case '\r':
+			ret += "\\r";
+			break;
+		case '\t':
+			ret += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+			{
+				ret += "\\u00";
+				ret += hex_digits[static_cast<unsigned char>(c) >> 4];
+				ret += hex_digits[static_cast<unsigned char>(c) & 0xf];
+			}
+			else
+			{
+				ret += c;
+			}
+			break;
+		}
+	}
+	return ret;
+}
+
+std::uint64_t cjm::random_seed()
+{
+	std::random_device rnd;
+	const auto high = static_cast<std::uint64_t>(rnd());
+	const auto low = static_cast<std::uint64_t>(rnd());
+	return (high << 32) ^ low;
+}
 
 std::pair<bool, int> parse_int(cjm::fsv_t str) noexcept
 {
@@ -599,92 +1356,52 @@ std::pair<bool, int> parse_int(cjm::fsv_t str) noexcept
 	}	
 }
 
-std::uint64_t parse_u(cjm::tsv_t parse)
+std::pair<bool, std::uint64_t> parse_uint64(cjm::fsv_t str) noexcept
 {
-	std::uint64_t ret = 0;
-	cjm::fstr_t converted = to_fstr_t(parse);
-	cjm::fstr_stream_t stream;
-	stream.exceptions(std::ios::failbit | std::ios::badbit);
-	stream << std::hex << converted;
-	stream >> ret;
-	return ret;
-}
-
-std::int64_t parse_s(cjm::tsv_t parse)
-{
-	std::int64_t ret = 0;
-	std::uint64_t temp = 0;
-	cjm::fstr_t converted = to_fstr_t(parse);
-	cjm::fstr_stream_t stream;
-	stream.exceptions(std::ios::failbit | std::ios::badbit);
-	stream << std::hex << converted;
-	stream >> temp;
-	std::memcpy(&ret, &temp, sizeof(uint64_t));
-	return ret;
+	int base = 10;
+	if (str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+	{
+		str.remove_prefix(2);
+		base = 16;
+	}
+	std::uint64_t value = 0;
+	const char* const end = str.data() + str.size();
+	auto [ptr, ec] = std::from_chars(str.data(), end, value, base);
+	if (ec != std::errc{} || ptr != end || str.empty())
+		return std::make_pair(false, std::uint64_t{ 0 });
+	return std::make_pair(true, value);
 }
 
-cjm::fstr_t to_fstr_t(cjm::tsv_t convert)
+void write_generation_summary(const cjm::generation_monitor& monitor, cjm::fsv_t battery_name, const cjm::cmd_args& files,
+	std::ostream& summary_stream)
 {
-	constexpr auto f_size = sizeof(cjm::fchar_t);
-	constexpr auto t_size = sizeof(cjm::tchar_t);
-	constexpr bool is_fsigned = std::numeric_limits<cjm::fchar_t>::is_signed;
-	constexpr bool is_tsigned = std::numeric_limits<cjm::tchar_t>::is_signed;
-	static_assert(f_size <= t_size, "fchar must be less than tchar");
-
-	if constexpr (is_fsigned == is_tsigned)
+	using namespace cjm;
+	const std::optional<fstr_t>& json_file = files.options().json;
+	const unsigned thread_count = resolve_thread_count(files.thread_count());
+	if (!json_file.has_value())
 	{
-		constexpr cjm::tchar_t max_fchar = static_cast<cjm::tchar_t>(std::numeric_limits<cjm::fchar_t>::max());
-		constexpr cjm::tchar_t min_fchar = static_cast<cjm::tchar_t>(std::numeric_limits<cjm::fchar_t>::min());
-		cjm::fstr_t ret;
-		if (!convert.empty())
+		const auto precision = std::cout.precision();
+		std::cout << std::fixed << std::setprecision(2) << "Wrote " << monitor.records() << " records in "
+			<< monitor.elapsed_seconds() << " seconds (" << static_cast<std::uint64_t>(monitor.records_per_second())
+			<< " records/sec); worker seconds by stage:";
+		for (size_t i = 0; i < generation_stage_count; ++i)
 		{
-			ret.reserve(convert.size());
-			std::transform(convert.cbegin(), convert.cend(), std::back_inserter(ret), [=](cjm::tchar_t c) -> cjm::fchar_t
-				{
-					if (c > max_fchar || c < min_fchar) throw std::invalid_argument{ "character out of range for conversion." };  // NOLINT(misc-redundant-expression) -- only redundant with current aliases
-					return static_cast<cjm::fchar_t>(c);
-				});
+			const auto stage = static_cast<generation_stage>(i);
+			std::cout << (i == 0 ? " " : ", ") << name(stage) << " " << monitor.stage_seconds(stage);
 		}
-		return ret;
+		std::cout << "." << newl << std::defaultfloat << std::setprecision(precision);
 	}
-	else if constexpr (is_fsigned)
+	else if (json_file->empty())
 	{
-		using ufchar_t = std::make_unsigned_t<cjm::fchar_t>;
-
-		constexpr auto umax = static_cast<ufchar_t>(std::numeric_limits<cjm::fchar_t>::max());
-		constexpr auto umin = static_cast<ufchar_t>(std::numeric_limits<cjm::fchar_t>::min());
-		constexpr auto max_fchar = static_cast<std::int32_t>(umax);
-		constexpr auto min_fchar = -static_cast<std::int32_t>(umin);
-		cjm::fstr_t ret;
-		if (!convert.empty())
-		{
-			ret.reserve(convert.size());
-			std::transform(convert.cbegin(), convert.cend(), std::back_inserter(ret), [=](cjm::tchar_t c) -> cjm::fchar_t
-				{
-					if (static_cast<std::int32_t>(c) > max_fchar || static_cast<std::int32_t>(c) < min_fchar) throw std::invalid_argument{ "character out of range for conversion." };  // NOLINT(misc-redundant-expression) -- only redundant with current aliases
-					return static_cast<cjm::fchar_t>(c);
-				});
-		}
-		return ret;
+		monitor.print_json(summary_stream, battery_name, files.first_file(), thread_count);
 	}
 	else
 	{
-		constexpr auto max_fchar = static_cast<std::uint32_t>(static_cast<cjm::tchar_t>(std::numeric_limits<cjm::fchar_t>::max()));
-		constexpr auto min_fchar = static_cast<std::uint32_t>(static_cast<cjm::tchar_t>(std::numeric_limits<cjm::fchar_t>::min()));
-		cjm::fstr_t ret;
-		if (!convert.empty())
-		{
-			ret.reserve(convert.size());
-			std::transform(convert.cbegin(), convert.cend(), std::back_inserter(ret), [=](cjm::tchar_t c) -> cjm::fchar_t
-				{
-					if (static_cast<uint32_t>(c) > max_fchar || static_cast<uint32_t>(c) < min_fchar) throw std::invalid_argument{ "character out of range for conversion." };  // NOLINT(misc-redundant-expression) -- only redundant with current aliases
-					return static_cast<cjm::fchar_t>(c);
-				});
-		}
-		return ret;
+		auto stream = std::ofstream{};
+		stream.exceptions(std::ios::badbit | std::ios::failbit);
+		stream.open(*json_file, std::ios::trunc);
+		monitor.print_json(stream, battery_name, files.first_file(), thread_count);
+		std::cout << "Wrote the generation summary to [" << *json_file << "]." << newl;
 	}
-
-	
-	
-	
 }
+
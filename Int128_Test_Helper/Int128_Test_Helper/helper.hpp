@@ -17,6 +17,7 @@
 #include <functional>
 #include <absl/hash/hash.h>
 #include <absl/numeric/int128.h>
+#include "xoshiro.hpp"
 #include <boost/functional/hash.hpp>
 #include <random>
 #include <chrono>
@@ -49,6 +50,7 @@ namespace cjm
 	
 	
 	constexpr size_t binary_op_count = 11;
+	constexpr size_t random_op_block_size = 65'536;
 	enum class binary_op : unsigned int
 	{
 		left_shift = 0,
@@ -66,6 +68,56 @@ namespace cjm
 		compare		
 	};
 
+	enum class battery_format : unsigned int
+	{
+		text = 0,
+		binary
+	};
+
+	//of a text battery file: utf8 has no BOM, utf16le starts with one.
+	enum class text_encoding
+	{
+		utf8 = 0,
+		utf16le
+	};
+
+	enum class operand_distribution : unsigned int
+	{
+		uniform = 0, //int64 or full range values drawn uniformly (by op kind)
+		stratified, //operands drawn by operand_stratum and sign, then uniformly within the stratum
+		wide //as uniform, but multiply, divide and modulus draw full width operands (128 x 128 bit, 128 / 128 bit)
+	};
+	constexpr size_t operand_distribution_count = 3;
+
+	//the engine behind cjm_helper_rgen.  Both are seeded per block of a battery; the name of the engine is recorded in
+	//the battery's header.
+	enum class rgen_engine : unsigned int
+	{
+		//std::mt19937_64 and std::uniform_int_distribution.  The default, and how every earlier battery was drawn, but
+		//the distribution is implementation defined, so a seed's battery depends on the standard library.
+		mt19937_64 = 0,
+		//xoshiro256** and bounded_uniform.  Faster, and a seed's battery is the same on every toolchain.  Block k is
+		//drawn from the seed's stream jumped k times, so the blocks never overlap.
+		xoshiro256ss
+	};
+	constexpr size_t rgen_engine_count = 2;
+
+	//strata of int128 values by magnitude bit length and limb structure: classify_operand assigns each value the first
+	//one that applies.
+	enum class operand_stratum : unsigned int
+	{
+		zero = 0,
+		unit, //magnitude 1
+		extreme, //min, min + 1, max - 1, max
+		limb_boundary, //magnitude within one of 2^63 or 2^64
+		carry_pattern, //high limb of the magnitude non-zero, low limb all zeros or all ones
+		small, //magnitude of at most 32 bits
+		low_limb, //magnitude of at most 64 bits
+		high_limb, //magnitude of at most 126 bits
+		full_width //magnitude of 127 or 128 bits
+	};
+	constexpr size_t operand_stratum_count = 9;
+
 
 	
 	template<typename Char, typename CharTraits = std::char_traits<Char>>
@@ -77,9 +129,16 @@ namespace cjm
 	struct binary_operation_serdeser;
 	class cjm_helper_rgen;
 	struct cmd_args;
+	struct cmd_options;
+	struct battery_header;
+	class operation_table;
+	class generation_monitor;
 	tstr_t to_tstr_t(fsv_t convert);
+	//text as the contents of a json string: quotes, backslashes and control characters escaped.
+	fstr_t json_escape(fsv_t text);
 	tstr_t serialize(int128_t value);
 	void serialize(tostrm_t& ostr, int128_t value);
+	tchar_t* serialize(tchar_t* dest, int128_t value) noexcept;
 
 	template<typename TSerDeser = binary_operation_serdeser>
 	tostrm_t& operator<<(tostrm_t& ost, const std::vector<binary_operation>& col);
@@ -90,17 +149,55 @@ namespace cjm
 	binary_operation_serdeser& operator
 		<<(binary_operation_serdeser& bosds, const binary_operation& bin_op);
 	tostrm_t& operator<<(tostrm_t& ostr, const binary_operation_serdeser& other);
+	tostrm_t& operator<<(tostrm_t& ostr, const battery_header& header);
 	int128_t deserialize(tsv_t deser_me);
 	std::vector<binary_operation> create_random_ops(size_t count);
 	std::vector<binary_operation> create_random_ops(size_t count, binary_op op_code);
+	void create_random_ops(std::vector<binary_operation>& fill_me, size_t count);
+	void create_random_ops(operation_table& fill_me, size_t count);
+	//the calling thread's generator, used by create_random_ops (so they may be called from any number of threads
+	//without locks): the n-th thread to ask gets its own, seeded with derive_block_seed(thread_rgen_base_seed(), n).
+	cjm_helper_rgen& thread_rgen();
+	//the seed the thread generators derive theirs from: drawn from std::random_device once per process.
+	std::uint64_t thread_rgen_base_seed();
 	int execute(int argc, char* argv[]);
+	//true if the command line has the self_test option: only then does main run the self tests (before execute), so
+	//scripted generation and verify runs start at once.
+	bool self_tests_requested(int argc, char* argv[]) noexcept;
 	cmd_args extract_arr(int argc, char* argv[]);
 	constexpr std::optional<tsv_t> text(binary_op op) noexcept;
 	constexpr std::optional<binary_op> parse_op(tsv_t parse_me) noexcept;
-
-	static std::vector<binary_operation> init_edge_comparisons();
-	inline const std::vector<binary_operation> edge_tests_comparison_v = init_edge_comparisons();
+	template<binary_op Op>
+	constexpr int128_t apply_op(int128_t lhs, int128_t rhs) noexcept;
+	constexpr bool is_defined(binary_op op, int128_t lhs, int128_t rhs) noexcept;
+	constexpr fsv_t name(operand_distribution distribution) noexcept;
+	constexpr std::optional<operand_distribution> parse_distribution(fsv_t parse_me) noexcept;
+	constexpr fsv_t name(rgen_engine engine) noexcept;
+	//a name in engine_name_lookup, or xoshiro256ss (no asterisks for the shell to expand).
+	constexpr std::optional<rgen_engine> parse_engine(fsv_t parse_me) noexcept;
+
+	struct edge_comparison;
+	constexpr size_t edge_comparison_value_count = 11;
+	constexpr size_t edge_comparison_count = edge_comparison_value_count * edge_comparison_value_count;
+	constexpr std::array<edge_comparison, edge_comparison_count> make_edge_comparisons() noexcept;
+	//the comparison edge battery (edge_comparisons_v) as binary_operations: built on each call, not at startup.
+	std::vector<binary_operation> edge_tests_comparison();
+	//the comparison edge battery as an operation_table: what execute writes to the edge case file.
+	operation_table edge_comparison_table();
 	void serialize_binary_ops(fsv_t test_battery_name, fsv_t file_name, const std::vector<binary_operation>& ops);
+	void serialize_binary_ops(fsv_t test_battery_name, fsv_t file_name, const operation_table& ops);
+	void serialize_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed, 
+		unsigned thread_count = 0, std::uint64_t first_record = 0,
+		operand_distribution distribution = operand_distribution::uniform, rgen_engine engine = rgen_engine::mt19937_64,
+		text_encoding encoding = text_encoding::utf8, generation_monitor* monitor = nullptr);
+	//serialize_random_ops without the progress messages: failures propagate as thrown.  monitor (if not null) gets the
+	//time spent in each stage and the records as they are written.
+	void write_random_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+		unsigned thread_count, std::uint64_t first_record, operand_distribution distribution,
+		rgen_engine engine = rgen_engine::mt19937_64, text_encoding encoding = text_encoding::utf8,
+		generation_monitor* monitor = nullptr);
+	std::uint64_t random_seed();
+	constexpr std::uint64_t derive_block_seed(std::uint64_t base_seed, std::uint64_t block_idx) noexcept;
 	
 	constexpr std::array<tsv_t, binary_op_count> op_name_lookup =
 		std::array<tsv_t, binary_op_count>{
@@ -157,9 +254,11 @@ namespace cjm
 		[[nodiscard]] int128_t right_operand() const noexcept { return m_rhs; }
 		[[nodiscard]] std::optional<int128_t> result() const noexcept { return m_result; }
 		[[nodiscard]] bool has_result() const noexcept{ return m_result.has_value(); }
+		//false if the operation has no defined int128 result (cjm::is_defined): it must not be evaluated.
+		[[nodiscard]] bool is_defined() const noexcept { return cjm::is_defined(m_op, m_lhs, m_rhs); }
 		[[nodiscard]] bool has_correct_result() const
 		{
-			return m_result.has_value() && binary_operation::perform_calculate_result(m_lhs, m_rhs, m_op) == m_result.value();
+			return m_result.has_value() && is_defined() && binary_operation::perform_calculate_result(m_lhs, m_rhs, m_op) == m_result.value();
 		}
 		
 		binary_operation() noexcept;
@@ -215,12 +314,76 @@ namespace cjm
 	};
 	
 	
+	struct cmd_options final
+	{
+		friend bool operator==(const cmd_options& lhs, const cmd_options& rhs) noexcept
+		{
+			return lhs.thread_count == rhs.thread_count
+				&& lhs.seed == rhs.seed
+				&& lhs.first_record == rhs.first_record
+				&& lhs.format == rhs.format
+				&& lhs.benchmark == rhs.benchmark
+				&& lhs.verify == rhs.verify
+				&& lhs.json == rhs.json
+				&& lhs.distribution == rhs.distribution
+				&& lhs.engine == rhs.engine
+				&& lhs.conversions == rhs.conversions
+				&& lhs.mul_div == rhs.mul_div
+				&& lhs.shards == rhs.shards
+				&& lhs.encoding == rhs.encoding
+				&& lhs.compress == rhs.compress
+				&& lhs.edges == rhs.edges
+				&& lhs.progress_seconds == rhs.progress_seconds;
+		}
+
+		friend bool operator!=(const cmd_options& lhs, const cmd_options& rhs) noexcept { return !(lhs == rhs); }
+
+		static bool is_option(fsv_t arg) noexcept;
+		void apply(fsv_t option);
+		[[nodiscard]] bool requires_file() const noexcept;
+		[[nodiscard]] bool requires_op_count() const noexcept;
+
+		unsigned thread_count = 0; //0 -> std::thread::hardware_concurrency
+		std::optional<std::uint64_t> seed; //nullopt -> drawn from std::random_device
+		std::uint64_t first_record = 0; //regenerate a slice of the battery starting at this record
+		battery_format format = battery_format::text;
+		fstr_t benchmark; //empty -> generate batteries rather than run the named benchmark
+		bool verify = false; //re-verify the named battery files rather than generate batteries
+		//nullopt -> human readable results; empty -> json on stdout (generation status lines then go to stderr); else json file name
+		std::optional<fstr_t> json;
+		operand_distribution distribution = operand_distribution::uniform;
+		rgen_engine engine = rgen_engine::mt19937_64; //of random batteries
+		std::optional<std::vector<std::int64_t>> conversions; //stopwatch frequencies: generate a tick conversion battery instead
+		bool mul_div = false; //generate a battery of fused multiply-divide (MulDiv) operations instead
+		size_t shards = 0; //0 -> one file; else the random battery is written as this many shards plus a manifest
+		text_encoding encoding = text_encoding::utf8; //of random and conversion text batteries
+		bool compress = false; //write the random text battery as a compressed battery
+		std::optional<unsigned> edges; //neighbours of each power of two: generate the edge cross product instead
+		unsigned progress_seconds = 10; //between progress lines while a random battery is written; 0 -> none
+	};
+
+	//written as the first line of a generated battery: everything needed to regenerate it (or any slice of it).
+	struct battery_header final
+	{
+		static constexpr tchar_t comment_marker = u'#';
+		static constexpr int format_version = 1;
+
+		fsv_t battery_name;
+		fsv_t engine_name;
+		std::uint64_t seed;
+		std::uint64_t block_size;
+		std::uint64_t first_record;
+		std::uint64_t count;
+		operand_distribution distribution = operand_distribution::uniform;
+	};
+	
 	struct cmd_args final
 	{
 		friend bool operator==(const cmd_args& lhs, const cmd_args& rhs)
 		{
 			return lhs.m_num_ops == rhs.m_num_ops
-				&& lhs.m_arr == rhs.m_arr;
+				&& lhs.m_arr == rhs.m_arr
+				&& lhs.m_options == rhs.m_options;
 		}
 
 		friend bool operator!=(const cmd_args& lhs, const cmd_args& rhs) { return !(lhs == rhs); }
@@ -228,24 +391,45 @@ namespace cjm
 		[[nodiscard]] fsv_t second_file() const noexcept;
 		[[nodiscard]] int op_count() const noexcept;
 		[[nodiscard]] bool good() const noexcept;
+		[[nodiscard]] const cmd_options& options() const noexcept;
+		[[nodiscard]] unsigned thread_count() const noexcept;
+		[[nodiscard]] std::optional<std::uint64_t> seed() const noexcept;
+		[[nodiscard]] std::uint64_t first_record() const noexcept;
+		[[nodiscard]] battery_format format() const noexcept;
+		[[nodiscard]] fsv_t benchmark() const noexcept;
+		[[nodiscard]] bool verify() const noexcept;
+		[[nodiscard]] operand_distribution distribution() const noexcept;
+		[[nodiscard]] rgen_engine engine() const noexcept;
 
 		cmd_args(const fstr_arr_t& arr, int num_ops);
+		cmd_args(const fstr_arr_t& arr, int num_ops, const cmd_options& options);
 		~cmd_args() = default;
 		cmd_args(const cmd_args& other) = default;
 		cmd_args(cmd_args&& other) noexcept;
 		cmd_args& operator=(const cmd_args& other) = default;
 		cmd_args& operator=(cmd_args&& other) noexcept;
 	private:
-		cmd_args() noexcept : m_num_ops{}, m_arr{} {}
+		cmd_args() noexcept : m_num_ops{}, m_arr{}, m_options{} {}
 		int m_num_ops;
 		fstr_arr_t m_arr;
+		cmd_options m_options;
 	};
 
 	class cjm_helper_rgen final
 	{
 	public:
-
 		static std::unique_ptr<cjm_helper_rgen> make_rgen();
+		static std::unique_ptr<cjm_helper_rgen> make_rgen(std::uint64_t seed,
+			operand_distribution distribution = operand_distribution::uniform, rgen_engine engine = rgen_engine::mt19937_64);
+
+		[[nodiscard]] std::uint64_t seed() const noexcept { return m_seed; }
+		[[nodiscard]] operand_distribution distribution() const noexcept { return m_distribution; }
+		[[nodiscard]] rgen_engine engine() const noexcept { return m_engine; }
+		void reseed(std::uint64_t seed);
+		//positions the generator at the start of block block_idx of the battery identified by base_seed.  mt19937_64
+		//reseeds with derive_block_seed(base_seed, block_idx).  xoshiro256** jumps the distance from the start of the last
+		//block sought (or from base_seed) with xoshiro256ss::jump(count): at most 64 jumps for any block.
+		void seek_block(std::uint64_t base_seed, std::uint64_t block_idx);
 
 		binary_op random_binary_op();
 		int128_t random_shift_arg();
@@ -264,12 +448,31 @@ namespace cjm
 		
 	private:
 		cjm_helper_rgen();
-		std::mt19937_64::result_type m_seed;
-		std::random_device m_rnd;
+		cjm_helper_rgen(std::uint64_t seed, operand_distribution distribution, rgen_engine engine);
+		//the engine's next 64 bits, a value in [0, range) and a value of distrib.  mt19937_64 keeps the reductions it
+		//always used (% and std::uniform_int_distribution); xoshiro256** uses bounded_uniform for both.
+		std::uint64_t next_bits();
+		std::uint64_t next_below(std::uint64_t range);
+		template<typename TInt>
+		TInt next_in(std::uniform_int_distribution<TInt>& distrib);
+		binary_operation random_stratified_operation(binary_op op);
+		int128_t random_stratified_operand();
+		int128_t random_stratified_shift_arg();
+		binary_operation random_wide_operation(binary_op op);
+		uint128_t random_magnitude(int bit_length);
+
+		std::uint64_t m_seed;
+		operand_distribution m_distribution;
+		rgen_engine m_engine;
 		std::mt19937_64 m_twister;
+		xoshiro256ss m_xoshiro;
+		//xoshiro256**: the state at the start of block m_block_idx of the battery m_seed
+		xoshiro256ss m_block_origin;
+		std::uint64_t m_block_idx;
 		std::uniform_int_distribution<int> m_op_distrib;
 		std::uniform_int_distribution<int> m_shift_distrib;
 		std::uniform_int_distribution<std::int64_t> m_operand_distrib;
+		std::uniform_int_distribution<int> m_stratum_distrib;
 		
 		
 	};
@@ -371,29 +574,140 @@ namespace cjm
 		return std::nullopt;
 	}
 
+	//each block of a random battery gets its own seed (splitmix64 finalizer of battery seed and block index)
+	//so a battery's contents depend only on its seed, never on how many threads generated it.
+	constexpr std::uint64_t derive_block_seed(std::uint64_t base_seed, std::uint64_t block_idx) noexcept
+	{
+		std::uint64_t z = base_seed + (block_idx + 1) * 0x9e37'79b9'7f4a'7c15;
+		z = (z ^ (z >> 30)) * 0xbf58'476d'1ce4'e5b9;
+		z = (z ^ (z >> 27)) * 0x94d0'49bb'1331'11eb;
+		return z ^ (z >> 31);
+	}
+
+	//the result binary_operation expects for one op kind: shift amounts must be in [0, 128), divisors non-zero.
+	template<binary_op Op>
+	constexpr int128_t apply_op(int128_t lhs, int128_t rhs) noexcept
+	{
+		if constexpr (Op == binary_op::left_shift)
+			return lhs << static_cast<int>(rhs);
+		else if constexpr (Op == binary_op::right_shift)
+			return lhs >> static_cast<int>(rhs);
+		else if constexpr (Op == binary_op::bw_and)
+			return lhs & rhs;
+		else if constexpr (Op == binary_op::bw_or)
+			return lhs | rhs;
+		else if constexpr (Op == binary_op::bw_xor)
+			return lhs ^ rhs;
+		else if constexpr (Op == binary_op::divide)
+			return lhs / rhs;
+		else if constexpr (Op == binary_op::modulus)
+			return lhs % rhs;
+		//add, subtract and multiply truncate to 128 bits (two's complement wrap), as the C# Int128 does.
+		else if constexpr (Op == binary_op::add)
+			return static_cast<int128_t>(static_cast<uint128_t>(lhs) + static_cast<uint128_t>(rhs));
+		else if constexpr (Op == binary_op::subtract)
+			return static_cast<int128_t>(static_cast<uint128_t>(lhs) - static_cast<uint128_t>(rhs));
+		else if constexpr (Op == binary_op::multiply)
+			return static_cast<int128_t>(static_cast<uint128_t>(lhs) * static_cast<uint128_t>(rhs));
+		else
+		{
+			static_assert(Op == binary_op::compare, "Unhandled binary_op.");
+			return static_cast<int128_t>(static_cast<int>(lhs > rhs) - static_cast<int>(lhs < rhs));
+		}
+	}
+
+	//false for operations without a defined int128 result: shifts by amounts outside [0, 128), division or
+	//modulus by zero and min / -1 (min % -1).
+	constexpr bool is_defined(binary_op op, int128_t lhs, int128_t rhs) noexcept
+	{
+		switch (op)
+		{
+		case binary_op::left_shift:
+		case binary_op::right_shift:
+			return rhs >= 0 && rhs < 128;
+		case binary_op::divide:
+		case binary_op::modulus:
+			return rhs != 0 && !(rhs == -1 && lhs == std::numeric_limits<int128_t>::min());
+		default:
+			return true;
+		}
+	}
+
+	constexpr std::array<fsv_t, operand_distribution_count> distribution_name_lookup = { "uniform"sv, "stratified"sv, "wide"sv };
+
+	constexpr fsv_t name(operand_distribution distribution) noexcept
+	{
+		const auto idx = static_cast<size_t>(distribution);
+		return idx < distribution_name_lookup.size() ? distribution_name_lookup[idx] : fsv_t{};
+	}
+
+	constexpr std::optional<operand_distribution> parse_distribution(fsv_t parse_me) noexcept
+	{
+		for (size_t i = 0; i < distribution_name_lookup.size(); ++i)
+		{
+			if (distribution_name_lookup[i] == parse_me)
+				return static_cast<operand_distribution>(i);
+		}
+		return std::nullopt;
+	}
+
+	constexpr std::array<fsv_t, rgen_engine_count> engine_name_lookup = { "mt19937_64"sv, "xoshiro256**"sv };
+
+	constexpr fsv_t name(rgen_engine engine) noexcept
+	{
+		const auto idx = static_cast<size_t>(engine);
+		return idx < engine_name_lookup.size() ? engine_name_lookup[idx] : fsv_t{};
+	}
+
+	constexpr std::optional<rgen_engine> parse_engine(fsv_t parse_me) noexcept
+	{
+		for (size_t i = 0; i < engine_name_lookup.size(); ++i)
+		{
+			if (engine_name_lookup[i] == parse_me)
+				return static_cast<rgen_engine>(i);
+		}
+		if (parse_me == "xoshiro256ss"sv)
+			return rgen_engine::xoshiro256ss;
+		return std::nullopt;
+	}
 		
-	static std::vector<binary_operation> init_edge_comparisons()
+	//boundary values of int128 and int64, zero and +/-1
+	constexpr std::array<int128_t, edge_comparison_value_count> edge_comparison_values =
+		{	std::numeric_limits<int128_t>::max(),					std::numeric_limits<int128_t>::max() - 1,
+			std::numeric_limits<int128_t>::min(),					std::numeric_limits<int128_t>::min() + 1,
+			int128_t{std::numeric_limits<std::int64_t>::max()},	int128_t{std::numeric_limits<std::int64_t>::max() - 1},
+			int128_t{std::numeric_limits<std::int64_t>::min()},	int128_t{std::numeric_limits<std::int64_t>::min() + 1},
+			int128_t{0}, int128_t{1},
+			int128_t{-1} };
+
+	//a compare record of the comparison edge battery
+	struct edge_comparison final
 	{
-		auto temp = std::array<int128_t, 11> 
-			{	std::numeric_limits<int128_t>::max(),					std::numeric_limits<int128_t>::max() - 1,
-				std::numeric_limits<int128_t>::min(),					std::numeric_limits<int128_t>::min() + 1,
-				int128_t{std::numeric_limits<std::int64_t>::max()},	int128_t{std::numeric_limits<std::int64_t>::max() - 1},
-				int128_t{std::numeric_limits<std::int64_t>::min()},	int128_t{std::numeric_limits<std::int64_t>::min() + 1},
-				int128_t{0}, int128_t{1},
-				int128_t{-1} };
-		std::vector<binary_operation> store_permutations;
-		store_permutations.reserve(11 * 11);
-		for (size_t left_idx = 0; left_idx < temp.size(); ++left_idx)
+		int128_t lhs;
+		int128_t rhs;
+		int128_t result;
+	};
+
+	//every ordered pair of edge_comparison_values compared, left value major.
+	constexpr std::array<edge_comparison, edge_comparison_count> make_edge_comparisons() noexcept
+	{
+		auto ret = std::array<edge_comparison, edge_comparison_count>{};
+		for (size_t left_idx = 0; left_idx < edge_comparison_values.size(); ++left_idx)
 		{
-			for (size_t right_idx = 0; right_idx < temp.size(); ++right_idx)
+			for (size_t right_idx = 0; right_idx < edge_comparison_values.size(); ++right_idx)
 			{
-				auto op = binary_operation{ binary_op::compare, temp[left_idx], temp[right_idx], true };
-				op.calculate_result();
-				store_permutations.emplace_back(op);
+				const int128_t lhs = edge_comparison_values[left_idx];
+				const int128_t rhs = edge_comparison_values[right_idx];
+				ret[left_idx * edge_comparison_values.size() + right_idx] =
+					edge_comparison{ lhs, rhs, apply_op<binary_op::compare>(lhs, rhs) };
 			}
 		}
-		return store_permutations;
+		return ret;
 	}
+
+	constexpr std::array<edge_comparison, edge_comparison_count> edge_comparisons_v = make_edge_comparisons();
+	static_assert(edge_comparisons_v[0].result == 0 && edge_comparisons_v[1].result == 1
+		&& edge_comparisons_v[edge_comparison_value_count].result == -1, "The edge comparisons must be computed at compile time.");
 }
 
 namespace std
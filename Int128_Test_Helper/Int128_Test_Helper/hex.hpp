@@ -0,0 +1,284 @@
+#ifndef CJM_HEX_HPP_
+#define CJM_HEX_HPP_
+#include "helper.hpp"
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <stdexcept>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CJM_HEX_SSE2 1
+#include <emmintrin.h>
+#endif
+namespace cjm
+{
+	constexpr size_t hex_u64_digits = sizeof(std::uint64_t) * 2;
+	//"lo\thi\t"
+	constexpr size_t serialized_int128_size = 2 * (hex_u64_digits + 1);
+	constexpr size_t max_op_name_size = 10;
+	//"OpName;lo\thi\t;lo\thi\t;lo\thi\t;"
+	constexpr size_t max_serialized_record_size = max_op_name_size + 1 + 3 * (serialized_int128_size + 1);
+
+	template<typename Char>
+	constexpr Char* format_hex_u64(Char* dest, std::uint64_t value) noexcept;
+
+	template<typename Char>
+	constexpr Char* format_int128(Char* dest, int128_t value) noexcept;
+
+	template<typename Char>
+	constexpr Char* format_record(Char* dest, binary_op op, int128_t lhs, int128_t rhs, int128_t result) noexcept;
+
+	template<typename Char>
+	bool try_parse_hex_u64(std::basic_string_view<Char> text, std::uint64_t& value) noexcept;
+
+	template<typename Char>
+	std::uint64_t parse_hex_u64(std::basic_string_view<Char> text);
+
+	template<typename Char>
+	bool try_parse_int128(std::basic_string_view<Char> text, int128_t& value) noexcept;
+
+	template<typename Char>
+	bool try_parse_record(std::basic_string_view<Char> line, binary_operation& op);
+
+	namespace internal
+	{
+		//two lowercase hex digits per byte value
+		constexpr std::array<std::array<char, 2>, 256> init_hex_pair_table() noexcept
+		{
+			constexpr auto digits = std::array<char, 16>{ '0', '1', '2', '3', '4', '5', '6', '7',
+				'8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+			std::array<std::array<char, 2>, 256> table{};
+			for (size_t i = 0; i < table.size(); ++i)
+			{
+				table[i][0] = digits[i >> 4];
+				table[i][1] = digits[i & 0x0f];
+			}
+			return table;
+		}
+		inline constexpr std::array<std::array<char, 2>, 256> hex_pair_table = init_hex_pair_table();
+
+		constexpr std::uint8_t invalid_hex_digit = 0xff;
+		//value of each hex digit (either case) by character; invalid_hex_digit for everything else
+		constexpr std::array<std::uint8_t, 256> init_hex_value_table() noexcept
+		{
+			std::array<std::uint8_t, 256> table{};
+			for (size_t i = 0; i < table.size(); ++i)
+			{
+				if (i >= '0' && i <= '9')
+					table[i] = static_cast<std::uint8_t>(i - '0');
+				else if (i >= 'a' && i <= 'f')
+					table[i] = static_cast<std::uint8_t>(i - 'a' + 10);
+				else if (i >= 'A' && i <= 'F')
+					table[i] = static_cast<std::uint8_t>(i - 'A' + 10);
+				else
+					table[i] = invalid_hex_digit;
+			}
+			return table;
+		}
+		inline constexpr std::array<std::uint8_t, 256> hex_value_table = init_hex_value_table();
+
+		template<typename Char>
+		constexpr std::uint8_t hex_value(Char c) noexcept
+		{
+			using uchar_t = std::make_unsigned_t<Char>;
+			const auto code = static_cast<uchar_t>(c);
+			return code < hex_value_table.size() ? hex_value_table[code] : invalid_hex_digit;
+		}
+
+		//branch free: any invalid digit poisons the accumulated validity mask.
+		template<typename Char>
+		constexpr bool parse_hex_digits_scalar(const Char* src, size_t count, std::uint64_t& value) noexcept
+		{
+			std::uint64_t ret = 0;
+			std::uint8_t invalid = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const std::uint8_t nibble = hex_value(src[i]);
+				invalid |= static_cast<std::uint8_t>(nibble & 0xf0);
+				ret = (ret << 4) | (nibble & 0x0f);
+			}
+			value = ret;
+			return invalid == 0;
+		}
+
+#ifdef CJM_HEX_SSE2
+		//validates and converts 16 digits (already narrowed to bytes, saturating) with SSE2.
+		inline bool parse_16_hex_bytes_sse2(__m128i chars, std::uint64_t& value) noexcept
+		{
+			const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+			const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+			const __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+			const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+			if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff)
+				return false;
+			const __m128i nibbles = _mm_or_si128(_mm_and_si128(is_digit, digit),
+				_mm_andnot_si128(is_digit, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+			alignas(16) std::uint8_t bytes[16];
+			_mm_store_si128(reinterpret_cast<__m128i*>(bytes), nibbles);
+			std::uint64_t ret = 0;
+			for (const std::uint8_t nibble : bytes)
+			{
+				ret = (ret << 4) | nibble;
+			}
+			value = ret;
+			return true;
+		}
+
+		template<typename Char>
+		bool parse_16_hex_digits_sse2(const Char* src, std::uint64_t& value) noexcept
+		{
+			if constexpr (sizeof(Char) == 1)
+			{
+				return parse_16_hex_bytes_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), value);
+			}
+			else if constexpr (sizeof(Char) == 2)
+			{
+				//the pack saturates signed 16-bit values: code units 0x0100 to 0x7fff become 0xff and 0x8000 up (negative)
+				//become 0x00.  Neither is a hex digit, so both are still rejected.
+				const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+				return parse_16_hex_bytes_sse2(_mm_packus_epi16(first, second), value);
+			}
+			else
+			{
+				return parse_hex_digits_scalar(src, hex_u64_digits, value);
+			}
+		}
+#endif
+
+		constexpr size_t longest_op_name() noexcept
+		{
+			size_t ret = 0;
+			for (const auto name : op_name_lookup)
+			{
+				ret = name.size() > ret ? name.size() : ret;
+			}
+			return ret;
+		}
+	}
+
+	static_assert(internal::longest_op_name() <= max_op_name_size, "max_op_name_size must accommodate every op name.");
+
+	//writes exactly hex_u64_digits lowercase, zero-padded digits; returns one past the last digit written.
+	template<typename Char>
+	constexpr Char* format_hex_u64(Char* dest, std::uint64_t value) noexcept
+	{
+		for (int byte = static_cast<int>(sizeof(std::uint64_t)) - 1; byte > -1; --byte)
+		{
+			const auto& pair = internal::hex_pair_table[(value >> (byte * 8)) & 0xff];
+			*dest++ = static_cast<Char>(pair[0]);
+			*dest++ = static_cast<Char>(pair[1]);
+		}
+		return dest;
+	}
+
+	//writes exactly serialized_int128_size characters in the same format as serialize(int128_t).
+	template<typename Char>
+	constexpr Char* format_int128(Char* dest, int128_t value) noexcept
+	{
+		dest = format_hex_u64(dest, absl::Int128Low64(value));
+		*dest++ = static_cast<Char>('\t');
+		dest = format_hex_u64(dest, static_cast<std::uint64_t>(absl::Int128High64(value)));
+		*dest++ = static_cast<Char>('\t');
+		return dest;
+	}
+
+	//writes at most max_serialized_record_size characters: one record of the binary_operation_serdeser
+	//text format without the trailing item delimiter.
+	template<typename Char>
+	constexpr Char* format_record(Char* dest, binary_op op, int128_t lhs, int128_t rhs, int128_t result) noexcept
+	{
+		constexpr auto field_delim = static_cast<Char>(binary_operation_serdeser::item_field_delimiter);
+		for (const tchar_t c : op_name_lookup[static_cast<size_t>(op)])
+		{
+			*dest++ = static_cast<Char>(c);
+		}
+		*dest++ = field_delim;
+		dest = format_int128(dest, lhs);
+		*dest++ = field_delim;
+		dest = format_int128(dest, rhs);
+		*dest++ = field_delim;
+		dest = format_int128(dest, result);
+		*dest++ = field_delim;
+		return dest;
+	}
+
+	//parses 1 to hex_u64_digits hex digits (either case) with no prefix, sign or whitespace.
+	template<typename Char>
+	bool try_parse_hex_u64(std::basic_string_view<Char> text, std::uint64_t& value) noexcept
+	{
+		if (text.empty() || text.size() > hex_u64_digits)
+			return false;
+#ifdef CJM_HEX_SSE2
+		if (text.size() == hex_u64_digits)
+			return internal::parse_16_hex_digits_sse2(text.data(), value);
+#endif
+		return internal::parse_hex_digits_scalar(text.data(), text.size(), value);
+	}
+
+	template<typename Char>
+	std::uint64_t parse_hex_u64(std::basic_string_view<Char> text)
+	{
+		std::uint64_t ret = 0;
+		if (!try_parse_hex_u64(text, ret))
+			throw std::invalid_argument{ "Text is not 1 to 16 hexadecimal digits." };
+		return ret;
+	}
+
+	//parses the serialize(int128_t) format: low and high 64 bits as hex, each followed by (runs of) tabs.
+	template<typename Char>
+	bool try_parse_int128(std::basic_string_view<Char> text, int128_t& value) noexcept
+	{
+		constexpr auto tab = static_cast<Char>('\t');
+		std::array<std::uint64_t, 2> halves{};
+		size_t pos = 0;
+		for (auto& half : halves)
+		{
+			while (pos < text.size() && text[pos] == tab)
+				++pos;
+			const size_t field_end = std::min(text.find(tab, pos), text.size());
+			if (!try_parse_hex_u64(text.substr(pos, field_end - pos), half))
+				return false;
+			pos = field_end;
+		}
+		while (pos < text.size() && text[pos] == tab)
+			++pos;
+		if (pos != text.size())
+			return false;
+		value = absl::MakeInt128(static_cast<std::int64_t>(halves[1]), halves[0]);
+		return true;
+	}
+
+	//parses one record written by format_record (without its item delimiter); the op name is resolved by parse_op.
+	template<typename Char>
+	bool try_parse_record(std::basic_string_view<Char> line, binary_operation& op)
+	{
+		using sv_t = std::basic_string_view<Char>;
+		constexpr auto field_delim = static_cast<Char>(binary_operation_serdeser::item_field_delimiter);
+		size_t delim_at = line.find(field_delim);
+		if (delim_at == sv_t::npos || delim_at > max_op_name_size)
+			return false;
+		auto name = std::array<tchar_t, max_op_name_size>{};
+		for (size_t i = 0; i < delim_at; ++i)
+		{
+			name[i] = static_cast<tchar_t>(line[i]);
+		}
+		const std::optional<binary_op> code = parse_op(tsv_t{ name.data(), delim_at });
+		if (!code.has_value())
+			return false;
+
+		auto operands = std::array<int128_t, 3>{};
+		size_t pos = delim_at + 1;
+		for (auto& operand : operands)
+		{
+			delim_at = line.find(field_delim, pos);
+			if (delim_at == sv_t::npos || !try_parse_int128(line.substr(pos, delim_at - pos), operand))
+				return false;
+			pos = delim_at + 1;
+		}
+		if (pos != line.size())
+			return false;
+		op = binary_operation{ *code, operands[0], operands[1], operands[2] };
+		return true;
+	}
+}
+#endif // CJM_HEX_HPP_
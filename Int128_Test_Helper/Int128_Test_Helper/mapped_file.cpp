@@ -0,0 +1,118 @@
+#include "mapped_file.hpp"
+#include <utility>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	[[noreturn]] void throw_map_failure(cjm::fsv_t file_name, cjm::fsv_t step)
+	{
+		throw std::runtime_error{ "Unable to map file [" + cjm::fstr_t{ file_name } + "]: " + cjm::fstr_t{ step } + " failed." };
+	}
+
+#ifdef _WIN32
+	struct handle_closer final
+	{
+		HANDLE handle;
+		~handle_closer() { if (handle != nullptr && handle != INVALID_HANDLE_VALUE) CloseHandle(handle); }
+	};
+#else
+	struct descriptor_closer final
+	{
+		int descriptor;
+		~descriptor_closer() { if (descriptor != -1) close(descriptor); }
+	};
+#endif
+}
+
+cjm::mapped_file::mapped_file(fsv_t file_name) : m_data{ nullptr }, m_size{ 0 }
+{
+	const auto name = fstr_t{ file_name };
+#ifdef _WIN32
+	const auto file = handle_closer{ CreateFileA(name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+	if (file.handle == INVALID_HANDLE_VALUE)
+		throw_map_failure(file_name, "CreateFile"sv);
+	LARGE_INTEGER file_size{};
+	if (!GetFileSizeEx(file.handle, &file_size))
+		throw_map_failure(file_name, "GetFileSizeEx"sv);
+	if (file_size.QuadPart == 0)
+		return;
+	if (static_cast<unsigned long long>(file_size.QuadPart) > std::numeric_limits<size_t>::max())
+		throw_map_failure(file_name, "fitting the file in the address space"sv);
+	const auto mapping = handle_closer{ CreateFileMappingA(file.handle, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+	if (mapping.handle == nullptr)
+		throw_map_failure(file_name, "CreateFileMapping"sv);
+	const void* view = MapViewOfFile(mapping.handle, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+		throw_map_failure(file_name, "MapViewOfFile"sv);
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+	const auto file = descriptor_closer{ open(name.c_str(), O_RDONLY) };
+	if (file.descriptor == -1)
+		throw_map_failure(file_name, "open"sv);
+	struct stat status{};
+	if (fstat(file.descriptor, &status) != 0)
+		throw_map_failure(file_name, "fstat"sv);
+	if (status.st_size == 0)
+		return;
+	if (static_cast<unsigned long long>(status.st_size) > std::numeric_limits<size_t>::max())
+		throw_map_failure(file_name, "fitting the file in the address space"sv);
+	const auto size = static_cast<size_t>(status.st_size);
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.descriptor, 0);
+	if (view == MAP_FAILED)
+		throw_map_failure(file_name, "mmap"sv);
+	//the mapping is scanned front to back by each worker's slice.
+	(void) madvise(view, size, MADV_SEQUENTIAL);
+	m_data = static_cast<const unsigned char*>(view);
+	m_size = size;
+#endif
+}
+
+cjm::mapped_file::mapped_file(mapped_file&& other) noexcept : m_data{ other.m_data }, m_size{ other.m_size }
+{
+	other.m_data = nullptr;
+	other.m_size = 0;
+}
+
+cjm::mapped_file& cjm::mapped_file::operator=(mapped_file&& other) noexcept
+{
+	if (this != &other)
+	{
+		unmap();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+	return *this;
+}
+
+cjm::mapped_file::~mapped_file()
+{
+	unmap();
+}
+
+void cjm::mapped_file::unmap() noexcept
+{
+	if (m_data == nullptr)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+#else
+	munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef CJM_MAPPED_FILE_HPP_
+#define CJM_MAPPED_FILE_HPP_
+#include "helper.hpp"
+#include <cstddef>
+namespace cjm
+{
+	//Read only view of an entire file mapped into memory (mmap on POSIX, CreateFileMapping on Windows).
+	//An empty file is represented by a null view of size zero.
+	class mapped_file final
+	{
+	public:
+		explicit mapped_file(fsv_t file_name);
+		mapped_file(const mapped_file& other) = delete;
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file& operator=(const mapped_file& other) = delete;
+		mapped_file& operator=(mapped_file&& other) noexcept;
+		~mapped_file();
+
+		[[nodiscard]] const unsigned char* data() const noexcept { return m_data; }
+		[[nodiscard]] size_t size() const noexcept { return m_size; }
+		[[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+	private:
+		void unmap() noexcept;
+
+		const unsigned char* m_data;
+		size_t m_size;
+	};
+}
+#endif // CJM_MAPPED_FILE_HPP_
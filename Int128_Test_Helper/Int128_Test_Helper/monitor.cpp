@@ -0,0 +1,116 @@
+#include "monitor.hpp"
+#include <iomanip>
+
+namespace
+{
+	constexpr double to_seconds(std::uint64_t nanoseconds) noexcept
+	{
+		return static_cast<double>(nanoseconds) / 1e9;
+	}
+
+	//hh:mm:ss (hours unbounded)
+	void print_duration(std::ostream& ostr, double seconds)
+	{
+		const auto whole = static_cast<std::uint64_t>(seconds < 0.0 ? 0.0 : seconds + 0.5);
+		const auto fill = ostr.fill('0');
+		ostr << std::setw(2) << whole / 3600 << ':' << std::setw(2) << whole / 60 % 60 << ':' << std::setw(2) << whole % 60;
+		ostr.fill(fill);
+	}
+}
+
+cjm::generation_monitor::generation_monitor(std::uint64_t total_records, std::ostream* progress_stream,
+	clock_t::duration interval) : m_total{ total_records }, m_records{}, m_progress_stream{ progress_stream },
+	m_interval{ interval }, m_start{ clock_t::now() }, m_next_report{ m_start + interval }, m_end{ m_start }, m_nanoseconds{}, m_items{}
+{
+	if (interval <= clock_t::duration::zero())
+	{
+		m_progress_stream = nullptr;
+	}
+}
+
+void cjm::generation_monitor::add(generation_stage stage, std::uint64_t items, clock_t::duration elapsed) noexcept
+{
+	const auto idx = static_cast<size_t>(stage);
+	m_nanoseconds[idx].fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+		std::memory_order_relaxed);
+	m_items[idx].fetch_add(items, std::memory_order_relaxed);
+}
+
+void cjm::generation_monitor::complete(std::uint64_t records)
+{
+	m_records += records;
+	const clock_t::time_point now = clock_t::now();
+	if (m_records >= m_total)
+	{
+		m_end = now;
+		return;
+	}
+	if (!m_progress_stream)
+		return;
+	if (now < m_next_report)
+		return;
+	m_next_report = now + m_interval;
+	print_progress();
+}
+
+double cjm::generation_monitor::elapsed_seconds() const noexcept
+{
+	return std::chrono::duration<double>((m_records >= m_total ? m_end : clock_t::now()) - m_start).count();
+}
+
+double cjm::generation_monitor::stage_seconds(generation_stage stage) const noexcept
+{
+	return to_seconds(m_nanoseconds[static_cast<size_t>(stage)].load(std::memory_order_relaxed));
+}
+
+std::uint64_t cjm::generation_monitor::stage_items(generation_stage stage) const noexcept
+{
+	return m_items[static_cast<size_t>(stage)].load(std::memory_order_relaxed);
+}
+
+double cjm::generation_monitor::records_per_second() const noexcept
+{
+	const double seconds = elapsed_seconds();
+	return seconds > 0.0 ? static_cast<double>(m_records) / seconds : 0.0;
+}
+
+double cjm::generation_monitor::eta_seconds() const noexcept
+{
+	const double rate = records_per_second();
+	return rate > 0.0 && m_total > m_records ? static_cast<double>(m_total - m_records) / rate : 0.0;
+}
+
+void cjm::generation_monitor::print_progress() const
+{
+	std::ostream& ostr = *m_progress_stream;
+	const auto precision = ostr.precision();
+	const double percent = m_total > 0 ? 100.0 * static_cast<double>(m_records) / static_cast<double>(m_total) : 100.0;
+	ostr << newl << "Progress: " << m_records << " / " << m_total << " records (" << std::fixed << std::setprecision(1)
+		<< percent << "%); " << std::setprecision(0) << records_per_second() << " records/sec; elapsed ";
+	print_duration(ostr, elapsed_seconds());
+	ostr << "; ETA ";
+	print_duration(ostr, eta_seconds());
+	ostr << "." << std::defaultfloat << std::setprecision(precision) << std::flush;
+}
+
+void cjm::generation_monitor::print_json(std::ostream& ostr, fsv_t battery_name, fsv_t file_name, unsigned thread_count) const
+{
+	const auto precision = ostr.precision();
+	ostr << "{" << newl << "\t\"battery\": \"" << json_escape(battery_name) << "\"," << newl
+		<< "\t\"file\": \"" << json_escape(file_name) << "\"," << newl
+		<< "\t\"threads\": " << thread_count << "," << newl
+		<< "\t\"records\": " << m_records << "," << newl
+		<< std::fixed << std::setprecision(3) << "\t\"seconds\": " << elapsed_seconds() << "," << newl
+		<< std::setprecision(0) << "\t\"records_per_second\": " << records_per_second() << "," << newl
+		<< "\t\"stages\": [";
+	for (size_t i = 0; i < generation_stage_count; ++i)
+	{
+		const auto stage = static_cast<generation_stage>(i);
+		const std::uint64_t items = stage_items(stage);
+		const double seconds = stage_seconds(stage);
+		ostr << (i == 0 ? "" : ",") << newl << "\t\t{ \"name\": \"" << name(stage) << "\", \"items\": " << items
+			<< std::setprecision(3) << ", \"seconds\": " << seconds << ", \"ns_per_item\": "
+			<< (items > 0 ? seconds * 1e9 / static_cast<double>(items) : 0.0) << " }";
+	}
+	ostr << newl << "\t]" << newl << "}" << newl << std::defaultfloat << std::setprecision(precision);
+}
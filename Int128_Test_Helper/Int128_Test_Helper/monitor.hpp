@@ -0,0 +1,105 @@
+#ifndef CJM_MONITOR_HPP_
+#define CJM_MONITOR_HPP_
+#include "helper.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <cstdint>
+namespace cjm
+{
+	//the stages of writing a generated battery
+	enum class generation_stage : unsigned int
+	{
+		draw = 0, //drawing operands (cjm_helper_rgen)
+		calculate, //binary_operation::calculate_result
+		format, //formatting records as text
+		io_wait //the writing thread blocked on the disk (the async writer's I/O thread, or a synchronous write)
+	};
+	constexpr size_t generation_stage_count = 4;
+	constexpr std::array<fsv_t, generation_stage_count> stage_name_lookup = { "draw"sv, "calculate"sv, "format"sv, "io_wait"sv };
+
+	class generation_monitor;
+	class stage_timer;
+
+	constexpr fsv_t name(generation_stage stage) noexcept
+	{
+		const auto idx = static_cast<size_t>(stage);
+		return idx < stage_name_lookup.size() ? stage_name_lookup[idx] : fsv_t{};
+	}
+
+	//Per-stage counters and progress of one battery being written.  Workers add the time they spend in each stage
+	//(so with several workers the stage times add up to more than the elapsed time); the writing thread reports the
+	//records it has written, which prints a progress line with records/sec and an ETA at most once per interval.
+	class generation_monitor final
+	{
+	public:
+		using clock_t = std::chrono::steady_clock;
+		static constexpr std::chrono::seconds default_progress_interval{ 10 };
+
+		//no progress lines if progress_stream is null or interval is zero.
+		explicit generation_monitor(std::uint64_t total_records, std::ostream* progress_stream = nullptr,
+			clock_t::duration interval = default_progress_interval);
+		generation_monitor(const generation_monitor& other) = delete;
+		generation_monitor(generation_monitor&& other) noexcept = delete;
+		generation_monitor& operator=(const generation_monitor& other) = delete;
+		generation_monitor& operator=(generation_monitor&& other) noexcept = delete;
+		~generation_monitor() = default;
+
+		//thread safe.
+		void add(generation_stage stage, std::uint64_t items, clock_t::duration elapsed) noexcept;
+		//the writing thread only.
+		void complete(std::uint64_t records);
+
+		[[nodiscard]] std::uint64_t total_records() const noexcept { return m_total; }
+		[[nodiscard]] std::uint64_t records() const noexcept { return m_records; }
+		//until the last record is reported
+		[[nodiscard]] double elapsed_seconds() const noexcept;
+		[[nodiscard]] double stage_seconds(generation_stage stage) const noexcept;
+		[[nodiscard]] std::uint64_t stage_items(generation_stage stage) const noexcept;
+		//records per second so far, and the estimated seconds to write the rest at that rate
+		[[nodiscard]] double records_per_second() const noexcept;
+		[[nodiscard]] double eta_seconds() const noexcept;
+
+		//the final summary: the battery, the records and elapsed time and every stage's time and item count.
+		void print_json(std::ostream& ostr, fsv_t battery_name, fsv_t file_name, unsigned thread_count) const;
+
+	private:
+		void print_progress() const;
+
+		std::uint64_t m_total;
+		std::uint64_t m_records;
+		std::ostream* m_progress_stream;
+		clock_t::duration m_interval;
+		clock_t::time_point m_start;
+		clock_t::time_point m_next_report;
+		clock_t::time_point m_end;
+		std::array<std::atomic<std::uint64_t>, generation_stage_count> m_nanoseconds;
+		std::array<std::atomic<std::uint64_t>, generation_stage_count> m_items;
+	};
+
+	//adds the time from construction to destruction to a stage of monitor (if not null).
+	class stage_timer final
+	{
+	public:
+		stage_timer(generation_monitor* monitor, generation_stage stage, std::uint64_t items) noexcept
+			: m_monitor{ monitor }, m_stage{ stage }, m_items{ items },
+			m_start{ monitor ? generation_monitor::clock_t::now() : generation_monitor::clock_t::time_point{} } {}
+		stage_timer(const stage_timer& other) = delete;
+		stage_timer(stage_timer&& other) noexcept = delete;
+		stage_timer& operator=(const stage_timer& other) = delete;
+		stage_timer& operator=(stage_timer&& other) noexcept = delete;
+		~stage_timer()
+		{
+			if (m_monitor)
+				m_monitor->add(m_stage, m_items, generation_monitor::clock_t::now() - m_start);
+		}
+
+	private:
+		generation_monitor* m_monitor;
+		generation_stage m_stage;
+		std::uint64_t m_items;
+		generation_monitor::clock_t::time_point m_start;
+	};
+}
+#endif // CJM_MONITOR_HPP_
@@ -0,0 +1,323 @@
+#include "mul_div.hpp"
+#include "conversion.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	using namespace std::string_view_literals;
+
+	struct uint256 final
+	{
+		cjm::uint128_t high;
+		cjm::uint128_t low;
+	};
+
+	uint256 multiply(cjm::uint128_t lhs, cjm::uint128_t rhs) noexcept
+	{
+		using cjm::uint128_t;
+		const std::uint64_t l0 = absl::Uint128Low64(lhs);
+		const std::uint64_t l1 = absl::Uint128High64(lhs);
+		const std::uint64_t r0 = absl::Uint128Low64(rhs);
+		const std::uint64_t r1 = absl::Uint128High64(rhs);
+		const uint128_t p00 = uint128_t{ l0 } * r0;
+		const uint128_t p01 = uint128_t{ l0 } * r1;
+		const uint128_t p10 = uint128_t{ l1 } * r0;
+		const uint128_t p11 = uint128_t{ l1 } * r1;
+		//at most 3 * (2^64 - 1): cannot overflow.
+		const uint128_t middle = uint128_t{ absl::Uint128High64(p00) } + absl::Uint128Low64(p01) + absl::Uint128Low64(p10);
+		return uint256{ p11 + absl::Uint128High64(p01) + absl::Uint128High64(p10) + absl::Uint128High64(middle),
+			absl::MakeUint128(absl::Uint128Low64(middle), absl::Uint128Low64(p00)) };
+	}
+
+	int leading_zeros(std::uint64_t value) noexcept
+	{
+		assert(value != 0);
+		int ret = 0;
+		for (std::uint64_t top = std::uint64_t{ 1 } << 63; (value & top) == 0; top >>= 1)
+		{
+			++ret;
+		}
+		return ret;
+	}
+
+	//Knuth's algorithm D (TAOCP 4.3.1) with 64 bit digits for a divisor of two digits: dividend.high < divisor.
+	cjm::uint128_t divide_two_digit(uint256 dividend, cjm::uint128_t divisor) noexcept
+	{
+		using cjm::uint128_t;
+		using cjm::int128_t;
+		constexpr uint128_t base = uint128_t{ 1 } << 64;
+		//normalize so the divisor's top bit is set; the dividend gains a fifth digit.
+		const int shift = leading_zeros(absl::Uint128High64(divisor));
+		const uint128_t v = divisor << shift;
+		const auto vn = std::array<std::uint64_t, 2>{ absl::Uint128Low64(v), absl::Uint128High64(v) };
+		const auto u = std::array<std::uint64_t, 4>{ absl::Uint128Low64(dividend.low), absl::Uint128High64(dividend.low),
+			absl::Uint128Low64(dividend.high), absl::Uint128High64(dividend.high) };
+		auto un = std::array<std::uint64_t, 5>{};
+		un[4] = shift == 0 ? 0 : u[3] >> (64 - shift);
+		for (size_t i = 3; i > 0; --i)
+		{
+			un[i] = (u[i] << shift) | (shift == 0 ? 0 : u[i - 1] >> (64 - shift));
+		}
+		un[0] = u[0] << shift;
+
+		auto q = std::array<std::uint64_t, 3>{};
+		for (size_t j = 3; j-- > 0;)
+		{
+			const uint128_t numerator = absl::MakeUint128(un[j + 2], un[j + 1]);
+			uint128_t qhat = numerator / vn[1];
+			uint128_t rhat = numerator - qhat * vn[1];
+			while (qhat >= base || qhat * vn[0] > absl::MakeUint128(absl::Uint128Low64(rhat), un[j]))
+			{
+				--qhat;
+				rhat += vn[1];
+				if (rhat >= base)
+					break;
+			}
+			//un[j .. j + 2] -= qhat * vn
+			int128_t borrow = 0;
+			int128_t t;
+			for (size_t i = 0; i < 2; ++i)
+			{
+				const uint128_t product = qhat * vn[i];
+				t = int128_t{ un[i + j] } - borrow - static_cast<int128_t>(absl::Uint128Low64(product));
+				un[i + j] = absl::Int128Low64(t);
+				borrow = static_cast<int128_t>(absl::Uint128High64(product)) - (t >> 64);
+			}
+			t = int128_t{ un[j + 2] } - borrow;
+			un[j + 2] = absl::Int128Low64(t);
+			q[j] = absl::Uint128Low64(qhat);
+			if (t < 0)
+			{
+				//qhat was one too large: add the divisor back.
+				--q[j];
+				uint128_t carry = 0;
+				for (size_t i = 0; i < 2; ++i)
+				{
+					const uint128_t sum = uint128_t{ un[i + j] } + vn[i] + carry;
+					un[i + j] = absl::Uint128Low64(sum);
+					carry = sum >> 64;
+				}
+				un[j + 2] += absl::Uint128Low64(carry);
+			}
+		}
+		assert(q[2] == 0);
+		return absl::MakeUint128(q[1], q[0]);
+	}
+
+	//dividend / divisor where dividend.high < divisor, so the quotient fits in 128 bits.
+	cjm::uint128_t divide(uint256 dividend, cjm::uint128_t divisor) noexcept
+	{
+		using cjm::uint128_t;
+		assert(dividend.high < divisor);
+		if (dividend.high == 0)
+			return dividend.low / divisor;
+		if (absl::Uint128High64(divisor) == 0)
+		{
+			//two 128 / 64 bit steps: each partial remainder is less than the divisor, so each quotient digit fits in 64 bits.
+			const std::uint64_t d = absl::Uint128Low64(divisor);
+			const uint128_t upper = absl::MakeUint128(absl::Uint128Low64(dividend.high), absl::Uint128High64(dividend.low));
+			const uint128_t lower = absl::MakeUint128(absl::Uint128Low64(upper % d), absl::Uint128Low64(dividend.low));
+			return absl::MakeUint128(absl::Uint128Low64(upper / d), absl::Uint128Low64(lower / d));
+		}
+		return divide_two_digit(dividend, divisor);
+	}
+
+	int bit_length(cjm::uint128_t value) noexcept
+	{
+		const std::uint64_t high = absl::Uint128High64(value);
+		const std::uint64_t low = absl::Uint128Low64(value);
+		if (high != 0)
+			return 128 - leading_zeros(high);
+		return low != 0 ? 64 - leading_zeros(low) : 0;
+	}
+
+	cjm::uint128_t magnitude(cjm::int128_t value) noexcept
+	{
+		return value < 0 ? -static_cast<cjm::uint128_t>(value) : static_cast<cjm::uint128_t>(value);
+	}
+
+	//uniformly distributed among the values whose highest set bit is bit_length - 1.
+	cjm::uint128_t random_magnitude(std::mt19937_64& engine, int bit_length)
+	{
+		assert(bit_length > 0 && bit_length <= 127);
+		const cjm::uint128_t bits = absl::MakeUint128(engine(), engine());
+		const cjm::uint128_t top = cjm::uint128_t{ 1 } << (bit_length - 1);
+		return (bits & (top - 1)) | top;
+	}
+
+	cjm::int128_t random_signed(std::mt19937_64& engine, int bit_length)
+	{
+		const auto value = static_cast<cjm::int128_t>(random_magnitude(engine, bit_length));
+		return (engine() & 1u) != 0 ? -value : value;
+	}
+
+	int bit_length_between(std::mt19937_64& engine, int min_bits, int max_bits)
+	{
+		return min_bits + static_cast<int>(engine() % static_cast<std::uint64_t>(max_bits - min_bits + 1));
+	}
+
+	const std::array<cjm::tick_conversion, cjm::default_stopwatch_frequencies.size()>& default_conversions()
+	{
+		static const auto conversions = []() -> std::array<cjm::tick_conversion, cjm::default_stopwatch_frequencies.size()>
+		{
+			auto ret = std::array<cjm::tick_conversion, cjm::default_stopwatch_frequencies.size()>{};
+			std::transform(cjm::default_stopwatch_frequencies.cbegin(), cjm::default_stopwatch_frequencies.cend(), ret.begin(),
+				&cjm::tick_conversion::for_frequency);
+			return ret;
+		}();
+		return conversions;
+	}
+}
+
+std::optional<cjm::int128_t> cjm::mul_div(int128_t multiplicand, int128_t multiplier, int128_t divisor) noexcept
+{
+	if (divisor == 0)
+		return std::nullopt;
+	const bool negative = ((multiplicand < 0) != (multiplier < 0)) != (divisor < 0);
+	const uint256 product = multiply(magnitude(multiplicand), magnitude(multiplier));
+	const uint128_t abs_divisor = magnitude(divisor);
+	if (product.high >= abs_divisor)
+		return std::nullopt;
+	const uint128_t quotient = divide(product, abs_divisor);
+	constexpr auto max = static_cast<uint128_t>(std::numeric_limits<int128_t>::max());
+	if (quotient > (negative ? max + 1 : max))
+		return std::nullopt;
+	return static_cast<int128_t>(negative ? -quotient : quotient);
+}
+
+void cjm::mul_div_operation::calculate_result()
+{
+	m_result = mul_div(m_multiplicand, m_multiplier, m_divisor);
+	if (!m_result.has_value())
+		throw std::domain_error{ "The quotient of the operation is undefined or does not fit in an int128." };
+}
+
+cjm::mul_div_operation cjm::random_conversion_mul_div(std::mt19937_64& engine)
+{
+	const tick_conversion& conversion = default_conversions()[engine() % default_conversions().size()];
+	const int128_t ticks = random_timespan_ticks(engine, conversion.max_ticks);
+	return (engine() & 1u) != 0
+		? mul_div_operation{ ticks, conversion.factor, conversion.divisor }
+		: mul_div_operation{ conversion.to_stopwatch_ticks(ticks), conversion.divisor, conversion.factor };
+}
+
+cjm::mul_div_operation cjm::random_wide_mul_div(std::mt19937_64& engine)
+{
+	const int128_t multiplicand = random_signed(engine, bit_length_between(engine, 1, 127));
+	const int128_t multiplier = random_signed(engine, bit_length_between(engine, 1, 127));
+	const int product_bits = bit_length(magnitude(multiplicand)) + bit_length(magnitude(multiplier));
+	//a divisor at least product_bits - 127 bits long keeps the quotient within (or just past) 127 bits.
+	const int min_divisor_bits = std::max(1, product_bits - 127);
+	auto ret = mul_div_operation{};
+	do
+	{
+		ret = mul_div_operation{ multiplicand, multiplier, random_signed(engine, bit_length_between(engine, min_divisor_bits, 127)) };
+	} while (!ret.is_defined());
+	return ret;
+}
+
+cjm::mul_div_operation cjm::random_mul_div_operation(std::mt19937_64& engine)
+{
+	return (engine() & 1u) != 0 ? random_conversion_mul_div(engine) : random_wide_mul_div(engine);
+}
+
+void cjm::generate_mul_div_block(std::uint64_t base_seed, std::uint64_t block_idx, size_t skip, size_t count,
+	std::vector<mul_div_operation>& fill_me)
+{
+	auto engine = std::mt19937_64{ derive_block_seed(base_seed, block_idx) };
+	for (size_t i = 0; i < skip; ++i)
+	{
+		(void) random_mul_div_operation(engine);
+	}
+	fill_me.clear();
+	fill_me.reserve(count);
+	while (fill_me.size() < count)
+	{
+		mul_div_operation& op = fill_me.emplace_back(random_mul_div_operation(engine));
+		op.calculate_result();
+	}
+}
+
+cjm::tostrm_t& cjm::operator<<(tostrm_t& ostr, const std::vector<mul_div_operation>& ops)
+{
+	constexpr size_t records_per_write = 1'024;
+	auto buffer = std::vector<tchar_t>(records_per_write * (max_serialized_mul_div_record_size + 1));
+	for (size_t first = 0; first < ops.size(); first += records_per_write)
+	{
+		tchar_t* dest = buffer.data();
+		for (size_t i = first; i < std::min(first + records_per_write, ops.size()); ++i)
+		{
+			mul_div_operation op = ops[i];
+			if (!op.has_result())
+			{
+				op.calculate_result();
+			}
+			dest = format_mul_div_record(dest, op.multiplicand(), op.multiplier(), op.divisor(), op.result().value());
+			*dest++ = binary_operation_serdeser::item_delimiter[0];
+		}
+		ostr.write(buffer.data(), dest - buffer.data());
+	}
+	return ostr;
+}
+
+void cjm::serialize_mul_div_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+	unsigned thread_count, std::uint64_t first_record)
+{
+	if (file_name.empty())
+	{
+		throw std::invalid_argument{ "File name supplied cannot be empty." };
+	}
+	if (count == 0)
+	{
+		throw std::invalid_argument{ "Count of operations must be positive." };
+	}
+	try
+	{
+		std::cout << "Saving " << count << " operations of " << test_battery_name << " to file [" << file_name << "] using "
+			<< resolve_thread_count(thread_count) << " threads... ";
+		auto stream = tofstrm_t{};
+		stream.exceptions(std::ios::badbit | std::ios::failbit);
+		stream.open(file_name.data());
+		stream << battery_header{ test_battery_name, "mt19937_64"sv, seed, random_op_block_size, first_record, count };
+		generate_blocks<mul_div_operation>(first_record, count, thread_count, random_op_block_size,
+			[&](size_t, std::uint64_t block_idx, size_t skip, size_t length, std::vector<mul_div_operation>& block) -> void
+		{
+			generate_mul_div_block(seed, block_idx, skip, length, block);
+		}, [&](const std::vector<mul_div_operation>& block) -> void
+		{
+			stream << block;
+		});
+		stream.close();
+	}
+	catch (const std::exception& ex)
+	{
+		fstr_stream_t message;
+		message << "Unable to save "sv << test_battery_name << " to file "sv << file_name
+			<< " because of exception: ["sv << ex.what() << "]."sv;
+		throw std::runtime_error{ message.str() };
+	}
+	std::cout << " successfully saved battery " << test_battery_name << " to file: [" << file_name << "]." << newl;
+}
+
+std::vector<cjm::mul_div_operation> cjm::load_mul_div_battery(fsv_t file_name)
+{
+	auto stream = std::ifstream{};
+	stream.open(fstr_t{ file_name });
+	if (!stream.is_open())
+		throw std::invalid_argument{ "Unable to open the MulDiv battery." };
+	auto ret = std::vector<mul_div_operation>{};
+	fstr_t line;
+	while (std::getline(stream, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty() || line.front() == static_cast<char>(battery_header::comment_marker))
+			continue;
+		mul_div_operation& op = ret.emplace_back();
+		if (!try_parse_mul_div_record(fsv_t{ line }, op))
+			throw std::invalid_argument{ "Unable to parse record " + std::to_string(ret.size()) + " of the MulDiv battery." };
+	}
+	return ret;
+}
@@ -0,0 +1,125 @@
+#ifndef CJM_MUL_DIV_HPP_
+#define CJM_MUL_DIV_HPP_
+#include "helper.hpp"
+#include "hex.hpp"
+#include <optional>
+#include <random>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	constexpr tsv_t mul_div_name = u"MulDiv"sv;
+	//"MulDiv;lo\thi\t;lo\thi\t;lo\thi\t;lo\thi\t;"
+	constexpr size_t max_serialized_mul_div_record_size = max_op_name_size + 1 + 4 * (serialized_int128_size + 1);
+	static_assert(mul_div_name.size() <= max_op_name_size, "max_op_name_size must accommodate MulDiv.");
+
+	class mul_div_operation;
+
+	//multiplicand * multiplier / divisor truncated toward zero, with the product held exactly in 256 bits; nullopt if the
+	//divisor is zero or the quotient does not fit in an int128.
+	std::optional<int128_t> mul_div(int128_t multiplicand, int128_t multiplier, int128_t divisor) noexcept;
+	//a TimeSpan <-> Stopwatch tick conversion at one of default_stopwatch_frequencies, in either direction.
+	mul_div_operation random_conversion_mul_div(std::mt19937_64& engine);
+	//operands of random bit length and sign whose product may need up to 254 bits; the quotient always fits.
+	mul_div_operation random_wide_mul_div(std::mt19937_64& engine);
+	//half conversions, half wide.
+	mul_div_operation random_mul_div_operation(std::mt19937_64& engine);
+	void generate_mul_div_block(std::uint64_t base_seed, std::uint64_t block_idx, size_t skip, size_t count,
+		std::vector<mul_div_operation>& fill_me);
+	void serialize_mul_div_ops(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+		unsigned thread_count = 0, std::uint64_t first_record = 0);
+	std::vector<mul_div_operation> load_mul_div_battery(fsv_t file_name);
+	tostrm_t& operator<<(tostrm_t& ostr, const std::vector<mul_div_operation>& ops);
+
+	template<typename Char>
+	constexpr Char* format_mul_div_record(Char* dest, int128_t multiplicand, int128_t multiplier, int128_t divisor,
+		int128_t result) noexcept;
+	template<typename Char>
+	bool try_parse_mul_div_record(std::basic_string_view<Char> line, mul_div_operation& op);
+
+	//The ternary counterpart of binary_operation: a * b / c as one operation, so that tick conversions whose
+	//product exceeds 128 bits still have a reference result.
+	class mul_div_operation final
+	{
+	public:
+		friend bool operator==(const mul_div_operation& lhs, const mul_div_operation& rhs) noexcept
+		{
+			return lhs.m_multiplicand == rhs.m_multiplicand
+				&& lhs.m_multiplier == rhs.m_multiplier
+				&& lhs.m_divisor == rhs.m_divisor;
+		}
+		friend bool operator!=(const mul_div_operation& lhs, const mul_div_operation& rhs) noexcept { return !(lhs == rhs); }
+
+		mul_div_operation() noexcept : mul_div_operation{ 0, 0, 1 } {}
+		mul_div_operation(int128_t multiplicand, int128_t multiplier, int128_t divisor) noexcept
+			: m_multiplicand{ multiplicand }, m_multiplier{ multiplier }, m_divisor{ divisor }, m_result{} {}
+		mul_div_operation(int128_t multiplicand, int128_t multiplier, int128_t divisor, int128_t result) noexcept
+			: m_multiplicand{ multiplicand }, m_multiplier{ multiplier }, m_divisor{ divisor }, m_result{ result } {}
+
+		[[nodiscard]] int128_t multiplicand() const noexcept { return m_multiplicand; }
+		[[nodiscard]] int128_t multiplier() const noexcept { return m_multiplier; }
+		[[nodiscard]] int128_t divisor() const noexcept { return m_divisor; }
+		[[nodiscard]] std::optional<int128_t> result() const noexcept { return m_result; }
+		[[nodiscard]] bool has_result() const noexcept { return m_result.has_value(); }
+		[[nodiscard]] bool is_defined() const noexcept { return mul_div(m_multiplicand, m_multiplier, m_divisor).has_value(); }
+		[[nodiscard]] bool has_correct_result() const noexcept
+		{
+			return m_result.has_value() && mul_div(m_multiplicand, m_multiplier, m_divisor) == m_result;
+		}
+
+		//throws std::domain_error if the operation has no int128 result.
+		void calculate_result();
+
+	private:
+		int128_t m_multiplicand;
+		int128_t m_multiplier;
+		int128_t m_divisor;
+		std::optional<int128_t> m_result;
+	};
+
+	//writes at most max_serialized_mul_div_record_size characters: format_record with a third operand.
+	template<typename Char>
+	constexpr Char* format_mul_div_record(Char* dest, int128_t multiplicand, int128_t multiplier, int128_t divisor,
+		int128_t result) noexcept
+	{
+		constexpr auto field_delim = static_cast<Char>(binary_operation_serdeser::item_field_delimiter);
+		for (const tchar_t c : mul_div_name)
+		{
+			*dest++ = static_cast<Char>(c);
+		}
+		*dest++ = field_delim;
+		for (const int128_t value : { multiplicand, multiplier, divisor, result })
+		{
+			dest = format_int128(dest, value);
+			*dest++ = field_delim;
+		}
+		return dest;
+	}
+
+	//parses one record written by format_mul_div_record (without its item delimiter).
+	template<typename Char>
+	bool try_parse_mul_div_record(std::basic_string_view<Char> line, mul_div_operation& op)
+	{
+		using sv_t = std::basic_string_view<Char>;
+		constexpr auto field_delim = static_cast<Char>(binary_operation_serdeser::item_field_delimiter);
+		size_t delim_at = line.find(field_delim);
+		if (delim_at != mul_div_name.size() || !std::equal(mul_div_name.cbegin(), mul_div_name.cend(), line.cbegin(),
+			[](tchar_t expected, Char actual) -> bool { return expected == static_cast<tchar_t>(actual); }))
+			return false;
+
+		auto values = std::array<int128_t, 4>{};
+		size_t pos = delim_at + 1;
+		for (auto& value : values)
+		{
+			delim_at = line.find(field_delim, pos);
+			if (delim_at == sv_t::npos || !try_parse_int128(line.substr(pos, delim_at - pos), value))
+				return false;
+			pos = delim_at + 1;
+		}
+		if (pos != line.size())
+			return false;
+		op = mul_div_operation{ values[0], values[1], values[2], values[3] };
+		return true;
+	}
+}
+#endif // CJM_MUL_DIV_HPP_
@@ -0,0 +1,131 @@
+#include "operation_table.hpp"
+#include "batch.hpp"
+#include "hex.hpp"
+#include <algorithm>
+
+cjm::tostrm_t& cjm::operator<<(tostrm_t& ostr, const operation_table& table)
+{
+	//same text as operator<< for std::vector<binary_operation>.
+	constexpr size_t rows_per_write = 1'024;
+	auto buffer = std::vector<tchar_t>(rows_per_write * (max_serialized_record_size + 1));
+	for (size_t first = 0; first < table.size(); first += rows_per_write)
+	{
+		tchar_t* dest = buffer.data();
+		for (size_t row = first; row < std::min(first + rows_per_write, table.size()); ++row)
+		{
+			const int128_t lhs = table.left_operand(row);
+			const int128_t rhs = table.right_operand(row);
+			int128_t result = table.results()[row];
+			if (!table.has_result(row))
+			{
+				evaluate_batch(table.op_code(row), &lhs, &rhs, &result, 1);
+			}
+			dest = format_record(dest, table.op_code(row), lhs, rhs, result);
+			*dest++ = binary_operation_serdeser::item_delimiter[0];
+		}
+		ostr.write(buffer.data(), dest - buffer.data());
+	}
+	return ostr;
+}
+
+bool cjm::operator==(const operation_table& lhs, const operation_table& rhs) noexcept
+{
+	return lhs.m_op_codes == rhs.m_op_codes
+		&& lhs.m_lhs == rhs.m_lhs
+		&& lhs.m_rhs == rhs.m_rhs
+		&& lhs.m_results == rhs.m_results
+		&& lhs.m_has_result == rhs.m_has_result;
+}
+
+cjm::operation_table::operation_table(const std::vector<binary_operation>& ops) : operation_table{}
+{
+	reserve(ops.size());
+	for (const binary_operation& op : ops)
+	{
+		push_back(op);
+	}
+}
+
+void cjm::operation_table::reserve(size_t rows)
+{
+	m_op_codes.reserve(rows);
+	m_lhs.reserve(rows);
+	m_rhs.reserve(rows);
+	m_results.reserve(rows);
+	m_has_result.reserve((rows + 63) / 64);
+}
+
+void cjm::operation_table::clear() noexcept
+{
+	m_op_codes.clear();
+	m_lhs.clear();
+	m_rhs.clear();
+	m_results.clear();
+	m_has_result.clear();
+}
+
+void cjm::operation_table::push_back(const binary_operation& op)
+{
+	if (op.has_result())
+		push_back(op.op_code(), op.left_operand(), op.right_operand(), op.result().value());
+	else
+		push_back(op.op_code(), op.left_operand(), op.right_operand());
+}
+
+void cjm::operation_table::push_back(binary_op op, int128_t lhs, int128_t rhs, int128_t result)
+{
+	push_back(op, lhs, rhs);
+	m_results.back() = result;
+	set_has_result(size() - 1);
+}
+
+void cjm::operation_table::push_back(binary_op op, int128_t lhs, int128_t rhs)
+{
+	if (static_cast<size_t>(op) >= binary_op_count)
+		throw std::invalid_argument{ "The op code is not recognized." };
+	if (!is_defined(op, lhs, rhs))
+		throw std::invalid_argument{ "The operation has no defined result." };
+	if (size() % 64 == 0)
+	{
+		m_has_result.push_back(0);
+	}
+	m_op_codes.push_back(static_cast<std::uint8_t>(op));
+	m_lhs.push_back(lhs);
+	m_rhs.push_back(rhs);
+	m_results.push_back(0);
+}
+
+std::optional<cjm::int128_t> cjm::operation_table::result(size_t row) const noexcept
+{
+	return has_result(row) ? std::optional<int128_t>{ m_results[row] } : std::nullopt;
+}
+
+cjm::binary_operation cjm::operation_table::operator[](size_t row) const
+{
+	return has_result(row)
+		? binary_operation{ op_code(row), m_lhs[row], m_rhs[row], m_results[row] }
+		: binary_operation{ op_code(row), m_lhs[row], m_rhs[row] };
+}
+
+void cjm::operation_table::calculate_results()
+{
+	for (size_t row = 0; row < size(); ++row)
+	{
+		if (!has_result(row))
+		{
+			evaluate_batch(op_code(row), &m_lhs[row], &m_rhs[row], &m_results[row], 1);
+			set_has_result(row);
+		}
+	}
+}
+
+std::vector<cjm::binary_operation> cjm::operation_table::to_vector() const
+{
+	auto ret = std::vector<binary_operation>{};
+	ret.reserve(size());
+	for (size_t row = 0; row < size(); ++row)
+	{
+		ret.push_back((*this)[row]);
+	}
+	return ret;
+}
@@ -0,0 +1,66 @@
+#ifndef CJM_OPERATION_TABLE_HPP_
+#define CJM_OPERATION_TABLE_HPP_
+#include "helper.hpp"
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	class operation_table;
+
+	bool operator==(const operation_table& lhs, const operation_table& rhs) noexcept;
+	tostrm_t& operator<<(tostrm_t& ostr, const operation_table& table);
+
+	//Columnar storage for binary operations: op code, left operand, right operand and result columns plus a bitmap
+	//recording which rows have a result.  A row costs 49 bytes and a bit, against sizeof(binary_operation) for the
+	//vector form, and each column can be scanned sequentially.
+	class operation_table final
+	{
+	public:
+		friend bool operator==(const operation_table& lhs, const operation_table& rhs) noexcept;
+		friend bool operator!=(const operation_table& lhs, const operation_table& rhs) noexcept { return !(lhs == rhs); }
+
+		static constexpr double bytes_per_row = sizeof(std::uint8_t) + 3 * sizeof(int128_t) + 1.0 / 8.0;
+
+		operation_table() = default;
+		explicit operation_table(const std::vector<binary_operation>& ops);
+
+		[[nodiscard]] size_t size() const noexcept { return m_op_codes.size(); }
+		[[nodiscard]] bool empty() const noexcept { return m_op_codes.empty(); }
+		void reserve(size_t rows);
+		void clear() noexcept;
+
+		//throws std::invalid_argument for an unrecognized op code or an operation without a defined result (is_defined):
+		//every row can be evaluated.
+		void push_back(const binary_operation& op);
+		void push_back(binary_op op, int128_t lhs, int128_t rhs);
+		void push_back(binary_op op, int128_t lhs, int128_t rhs, int128_t result);
+
+		[[nodiscard]] binary_op op_code(size_t row) const noexcept { return static_cast<binary_op>(m_op_codes[row]); }
+		[[nodiscard]] int128_t left_operand(size_t row) const noexcept { return m_lhs[row]; }
+		[[nodiscard]] int128_t right_operand(size_t row) const noexcept { return m_rhs[row]; }
+		[[nodiscard]] bool has_result(size_t row) const noexcept { return (m_has_result[row / 64] >> (row % 64)) & 1u; }
+		[[nodiscard]] std::optional<int128_t> result(size_t row) const noexcept;
+		//the row as a binary_operation
+		[[nodiscard]] binary_operation operator[](size_t row) const;
+
+		//calculates the result of every row that lacks one.
+		void calculate_results();
+		[[nodiscard]] std::vector<binary_operation> to_vector() const;
+
+		[[nodiscard]] const std::vector<std::uint8_t>& op_codes() const noexcept { return m_op_codes; }
+		[[nodiscard]] const std::vector<int128_t>& left_operands() const noexcept { return m_lhs; }
+		[[nodiscard]] const std::vector<int128_t>& right_operands() const noexcept { return m_rhs; }
+		//rows without a result hold zero
+		[[nodiscard]] const std::vector<int128_t>& results() const noexcept { return m_results; }
+
+	private:
+		void set_has_result(size_t row) noexcept { m_has_result[row / 64] |= std::uint64_t{ 1 } << (row % 64); }
+
+		std::vector<std::uint8_t> m_op_codes;
+		std::vector<int128_t> m_lhs;
+		std::vector<int128_t> m_rhs;
+		std::vector<int128_t> m_results;
+		std::vector<std::uint64_t> m_has_result;
+	};
+}
+#endif // CJM_OPERATION_TABLE_HPP_
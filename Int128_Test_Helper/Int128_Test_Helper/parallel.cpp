@@ -0,0 +1,42 @@
+#include "parallel.hpp"
+#include "monitor.hpp"
+
+unsigned cjm::resolve_thread_count(unsigned requested) noexcept
+{
+	if (requested > 0)
+		return requested;
+	const unsigned hardware = std::thread::hardware_concurrency();
+	return hardware > 0 ? hardware : 1;
+}
+
+size_t cjm::block_worker_count(std::uint64_t first_record, size_t count, unsigned thread_count, size_t block_size) noexcept
+{
+	if (count == 0 || block_size == 0)
+		return 0;
+	const auto block_count = static_cast<size_t>((first_record + count - 1) / block_size - first_record / block_size + 1);
+	return std::min<size_t>(resolve_thread_count(thread_count), block_count);
+}
+
+void cjm::generate_random_block(cjm_helper_rgen& gen, std::uint64_t base_seed, std::uint64_t block_idx,
+	size_t skip, size_t count, std::vector<binary_operation>& fill_me, generation_monitor* monitor)
+{
+	fill_me.clear();
+	fill_me.reserve(count);
+	{
+		const auto timer = stage_timer{ monitor, generation_stage::draw, skip + count };
+		gen.seek_block(base_seed, block_idx);
+		for (size_t i = 0; i < skip; ++i)
+		{
+			(void) gen.random_operation();
+		}
+		while (fill_me.size() < count)
+		{
+			fill_me.emplace_back(gen.random_operation());
+		}
+	}
+	const auto timer = stage_timer{ monitor, generation_stage::calculate, count };
+	for (binary_operation& op : fill_me)
+	{
+		op.calculate_result();
+	}
+}
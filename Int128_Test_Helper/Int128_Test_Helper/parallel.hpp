@@ -0,0 +1,129 @@
+#ifndef CJM_PARALLEL_HPP_
+#define CJM_PARALLEL_HPP_
+#include "helper.hpp"
+#include <thread>
+#include <future>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+namespace cjm
+{
+	class generation_monitor;
+
+	unsigned resolve_thread_count(unsigned requested) noexcept;
+	//the number of workers generate_blocks uses: never more than there are blocks in the slice.
+	size_t block_worker_count(std::uint64_t first_record, size_t count, unsigned thread_count, size_t block_size) noexcept;
+
+	//draws block block_idx from gen after gen.seek_block(base_seed, block_idx).  monitor (if not null) gets the time
+	//spent drawing and calculating the records.
+	void generate_random_block(cjm_helper_rgen& gen, std::uint64_t base_seed, std::uint64_t block_idx,
+		size_t skip, size_t count, std::vector<binary_operation>& fill_me, generation_monitor* monitor = nullptr);
+
+	template<typename TRecord = binary_operation, typename TBlockFiller, typename TBlockSink>
+	void generate_blocks(std::uint64_t first_record, size_t count, unsigned thread_count, size_t block_size,
+		TBlockFiller&& fill, TBlockSink&& sink);
+
+	template<typename TBlockSink>
+	void generate_random_blocks(std::uint64_t base_seed, std::uint64_t first_record, size_t count, unsigned thread_count,
+		TBlockSink&& sink, size_t block_size = random_op_block_size,
+		operand_distribution distribution = operand_distribution::uniform, rgen_engine engine = rgen_engine::mt19937_64,
+		generation_monitor* monitor = nullptr);
+
+	//Fills records [first_record, first_record + count) block by block on thread_count workers.
+	//fill(worker, block_idx, skip, length, block) must put records [skip, skip + length) of block block_idx into block
+	//(a std::vector<TRecord>); calls with different worker indices run concurrently.  Every block is handed to sink on
+	//the calling thread in block order.  While the sink consumes one round of blocks the workers are already filling the next.
+	template<typename TRecord, typename TBlockFiller, typename TBlockSink>
+	void generate_blocks(std::uint64_t first_record, size_t count, unsigned thread_count, size_t block_size,
+		TBlockFiller&& fill, TBlockSink&& sink)
+	{
+		if (block_size == 0)
+			throw std::invalid_argument{ "Block size must be positive." };
+		if (count == 0)
+			return;
+
+		const std::uint64_t end_record = first_record + count;
+		const std::uint64_t first_block = first_record / block_size;
+		const size_t block_count = static_cast<size_t>((end_record - 1) / block_size - first_block + 1);
+		const size_t workers = block_worker_count(first_record, count, thread_count, block_size);
+
+		std::array<std::vector<std::vector<TRecord>>, 2> banks;
+		for (auto& bank : banks)
+		{
+			bank.resize(workers);
+		}
+
+		//[skip, skip + length) of the block are part of the requested slice.
+		const auto block_extent = [=](size_t block_idx) -> std::pair<size_t, size_t>
+		{
+			const std::uint64_t block_begin = (first_block + block_idx) * block_size;
+			const std::uint64_t begin = std::max(block_begin, first_record);
+			const std::uint64_t end = std::min(block_begin + block_size, end_record);
+			return std::make_pair(static_cast<size_t>(begin - block_begin), static_cast<size_t>(end - begin));
+		};
+
+		const auto fill_round = [&](size_t bank_idx, size_t round_first_block) -> void
+		{
+			auto& bank = banks[bank_idx];
+			std::vector<std::future<void>> pending;
+			pending.reserve(workers);
+			for (size_t worker = 0; worker < workers && round_first_block + worker < block_count; ++worker)
+			{
+				pending.emplace_back(std::async(std::launch::async, [&, worker]() -> void
+				{
+					const size_t block_idx = round_first_block + worker;
+					auto [skip, length] = block_extent(block_idx);
+					fill(worker, first_block + block_idx, skip, length, bank[worker]);
+				}));
+			}
+			for (auto& f : pending)
+			{
+				f.get();
+			}
+		};
+
+		size_t round_first_block = 0;
+		size_t bank_idx = 0;
+		auto round = std::async(std::launch::async, fill_round, bank_idx, round_first_block);
+		while (round_first_block < block_count)
+		{
+			round.get();
+			const size_t next_first_block = round_first_block + workers;
+			if (next_first_block < block_count)
+			{
+				round = std::async(std::launch::async, fill_round, bank_idx ^ 1, next_first_block);
+			}
+			for (size_t worker = 0; worker < workers && round_first_block + worker < block_count; ++worker)
+			{
+				sink(static_cast<const std::vector<TRecord>&>(banks[bank_idx][worker]));
+			}
+			round_first_block = next_first_block;
+			bank_idx ^= 1;
+		}
+	}
+
+	//Generates records [first_record, first_record + count) of the battery identified by base_seed on thread_count
+	//workers.  Every block is drawn from its own stream (cjm_helper_rgen::seek_block: a reseed, or at most 64 jumps for
+	//xoshiro256**), so the sequence seen by sink
+	//is identical for any thread count and any slice of a battery can be regenerated without generating what
+	//precedes it.
+	template<typename TBlockSink>
+	void generate_random_blocks(std::uint64_t base_seed, std::uint64_t first_record, size_t count, unsigned thread_count,
+		TBlockSink&& sink, size_t block_size, operand_distribution distribution, rgen_engine engine, generation_monitor* monitor)
+	{
+		const size_t workers = block_worker_count(first_record, count, thread_count, block_size);
+		std::vector<std::unique_ptr<cjm_helper_rgen>> generators;
+		generators.reserve(workers);
+		for (size_t i = 0; i < workers; ++i)
+		{
+			generators.emplace_back(cjm_helper_rgen::make_rgen(base_seed, distribution, engine));
+		}
+		generate_blocks(first_record, count, thread_count, block_size,
+			[&](size_t worker, std::uint64_t block_idx, size_t skip, size_t length, std::vector<binary_operation>& block) -> void
+		{
+			generate_random_block(*generators[worker], base_seed, block_idx, skip, length, block, monitor);
+		}, std::forward<TBlockSink>(sink));
+	}
+}
+#endif // CJM_PARALLEL_HPP_
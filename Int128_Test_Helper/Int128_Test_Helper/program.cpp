@@ -7,7 +7,13 @@ int main(int argc, char* argv[])
 	try
 	{
 		std::ios_base::sync_with_stdio(false);
-		cjm::tests::run_tests();
+		if (cjm::self_tests_requested(argc, argv))
+		{
+			cjm::tests::run_tests();
+			//--self_test alone: there is nothing to generate.
+			if (argc == 2)
+				return 0;
+		}
 		return cjm::execute(argc, argv);
 	}
 	catch (...)
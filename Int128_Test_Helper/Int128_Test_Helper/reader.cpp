@@ -0,0 +1,573 @@
+#include "reader.hpp"
+#include "parallel.hpp"
+#include "hex.hpp"
+#include "mapped_file.hpp"
+#include "batch.hpp"
+#include "compressed.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+	constexpr std::array<unsigned char, 3> utf8_bom = { 0xef, 0xbb, 0xbf };
+	constexpr std::array<unsigned char, 2> utf16le_bom = { 0xff, 0xfe };
+	constexpr std::array<unsigned char, 2> utf16be_bom = { 0xfe, 0xff };
+
+	template<size_t N>
+	bool starts_with(const unsigned char* bytes, size_t available, const std::array<unsigned char, N>& prefix) noexcept
+	{
+		return available >= N && std::equal(prefix.cbegin(), prefix.cend(), bytes);
+	}
+
+	struct block_verification final
+	{
+		std::uint64_t records = 0;
+		std::uint64_t failures = 0;
+		//indices are relative to the start of the block
+		std::vector<std::pair<std::uint64_t, cjm::binary_operation>> first_failures;
+		std::uint32_t crc = 0;
+	};
+
+	//checks the records of one block or slice in partitioned batches.
+	class block_verifier final
+	{
+	public:
+		void check(const cjm::binary_operation& op)
+		{
+			m_batch.push_back(op, m_result.records++);
+			if (m_batch.full())
+				flush();
+		}
+
+		block_verification finish()
+		{
+			flush();
+			return std::move(m_result);
+		}
+
+	private:
+		void flush()
+		{
+			if (m_batch.empty())
+				return;
+			m_failed.clear();
+			m_result.failures += m_batch.verify([&](std::uint64_t index, const cjm::binary_operation& op) -> void
+			{
+				m_failed.emplace_back(index, op);
+			});
+			//the batch reports failures by op kind: restore record order before keeping the first few.
+			std::sort(m_failed.begin(), m_failed.end(), [](const auto& lhs, const auto& rhs) -> bool
+			{
+				return lhs.first < rhs.first;
+			});
+			for (auto& failure : m_failed)
+			{
+				if (m_result.first_failures.size() == cjm::verify_summary::max_reported_failures)
+					break;
+				m_result.first_failures.emplace_back(std::move(failure));
+			}
+		}
+
+		cjm::partitioned_batch m_batch;
+		block_verification m_result;
+		std::vector<std::pair<std::uint64_t, cjm::binary_operation>> m_failed;
+	};
+
+	block_verification verify_block(const std::vector<cjm::binary_operation>& block)
+	{
+		auto verifier = block_verifier{};
+		for (const cjm::binary_operation& op : block)
+		{
+			verifier.check(op);
+		}
+		return verifier.finish();
+	}
+
+	//parses and checks each record of a slice of a mapped text battery in place: nothing is allocated per record.
+	template<typename Char>
+	block_verification verify_text_slice(std::basic_string_view<Char> slice, size_t slice_offset)
+	{
+		using sv_t = std::basic_string_view<Char>;
+		constexpr auto line_feed = static_cast<Char>('\n');
+		constexpr auto carriage_return = static_cast<Char>('\r');
+		constexpr auto comment_marker = static_cast<Char>(cjm::battery_header::comment_marker);
+		auto verifier = block_verifier{};
+		auto op = cjm::binary_operation{};
+		size_t pos = 0;
+		while (pos < slice.size())
+		{
+			const size_t line_begin = pos;
+			const size_t line_end = std::min(slice.find(line_feed, pos), slice.size());
+			pos = line_end + 1;
+			sv_t line = slice.substr(line_begin, line_end - line_begin);
+			if (!line.empty() && line.back() == carriage_return)
+				line.remove_suffix(1);
+			if (line.empty() || line[0] == comment_marker)
+				continue;
+			if (!cjm::try_parse_record(line, op))
+			{
+				throw std::invalid_argument{ "The line at byte offset " + std::to_string(slice_offset + line_begin * sizeof(Char))
+					+ " of the battery is not a binary operation record." };
+			}
+			if (!op.is_defined())
+			{
+				throw std::invalid_argument{ "The record at byte offset " + std::to_string(slice_offset + line_begin * sizeof(Char))
+					+ " of the battery has no defined result." };
+			}
+			verifier.check(op);
+		}
+		return verifier.finish();
+	}
+
+	block_verification verify_binary_slice(const unsigned char* records, size_t count, size_t slice_offset)
+	{
+		auto verifier = block_verifier{};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const cjm::binary_operation op = cjm::read_binary_record(records + i * cjm::binary_record_size);
+			if (!op.is_defined())
+			{
+				throw std::invalid_argument{ "The record at byte offset " + std::to_string(slice_offset + i * cjm::binary_record_size)
+					+ " of the binary operation battery has no defined result." };
+			}
+			verifier.check(op);
+		}
+		block_verification ret = verifier.finish();
+		auto crc = cjm::crc32{};
+		crc.update(records, count * cjm::binary_record_size);
+		ret.crc = crc.value();
+		return ret;
+	}
+
+	//splits text into (at most) parts slices of similar size, each ending just after a line feed or at the end of the text.
+	template<typename Char>
+	std::vector<std::basic_string_view<Char>> split_at_lines(std::basic_string_view<Char> text, size_t parts)
+	{
+		std::vector<std::basic_string_view<Char>> ret;
+		ret.reserve(parts);
+		size_t begin = 0;
+		for (size_t part = 1; part <= parts && begin < text.size(); ++part)
+		{
+			size_t end = text.size();
+			if (part < parts)
+			{
+				const size_t target = std::max(begin, text.size() / parts * part);
+				end = std::min(text.find(static_cast<Char>('\n'), target), text.size() - 1) + 1;
+			}
+			ret.emplace_back(text.substr(begin, end - begin));
+			begin = end;
+		}
+		return ret;
+	}
+
+	void merge(cjm::verify_summary& summary, block_verification& verified)
+	{
+		for (auto& [index, op] : verified.first_failures)
+		{
+			if (summary.first_failures.size() == cjm::verify_summary::max_reported_failures)
+				break;
+			summary.first_failures.emplace_back(summary.records + index, std::move(op));
+		}
+		summary.records += verified.records;
+		summary.failures += verified.failures;
+	}
+
+	template<typename Char>
+	void verify_mapped_text(cjm::verify_summary& summary, const unsigned char* payload, size_t payload_size, size_t payload_offset,
+		size_t workers)
+	{
+		if (payload_size % sizeof(Char) != 0 || reinterpret_cast<std::uintptr_t>(payload) % alignof(Char) != 0)
+			throw std::invalid_argument{ "The battery ends in the middle of a UTF-16 code unit." };
+		const auto text = std::basic_string_view<Char>{ reinterpret_cast<const Char*>(payload), payload_size / sizeof(Char) };
+		std::vector<std::future<block_verification>> pending;
+		for (const auto slice : split_at_lines(text, workers))
+		{
+			const size_t slice_offset = payload_offset + static_cast<size_t>(slice.data() - text.data()) * sizeof(Char);
+			pending.emplace_back(std::async(std::launch::async, verify_text_slice<Char>, slice, slice_offset));
+		}
+		for (auto& f : pending)
+		{
+			block_verification verified = f.get();
+			merge(summary, verified);
+		}
+	}
+
+	template<typename Char>
+	block_verification verify_frame(const std::vector<unsigned char>& text, size_t skip, size_t frame_offset)
+	{
+		if ((text.size() - skip) % sizeof(Char) != 0)
+			throw std::invalid_argument{ "The battery ends in the middle of a UTF-16 code unit." };
+		const auto slice = std::basic_string_view<Char>{ reinterpret_cast<const Char*>(text.data() + skip),
+			(text.size() - skip) / sizeof(Char) };
+		return verify_text_slice(slice, frame_offset + skip);
+	}
+
+	//workers decompress and check one frame at a time; the offsets in error messages are into the uncompressed battery.
+	void verify_compressed(cjm::verify_summary& summary, const cjm::compressed_battery& battery, size_t workers)
+	{
+		if (battery.frame_count() == 0)
+			return;
+		auto first_frame = std::vector<unsigned char>{};
+		battery.decompress(0, first_frame);
+		const cjm::battery_layout layout = cjm::detect_battery_layout(first_frame.data(),
+			std::min(first_frame.size(), cjm::binary_battery_header::size));
+		if (layout.format == cjm::battery_format::binary)
+			throw std::invalid_argument{ "A compressed battery must hold a text battery." };
+
+		auto verified = std::vector<block_verification>(battery.frame_count());
+		std::atomic<size_t> next_frame{ 0 };
+		std::vector<std::future<void>> pending;
+		pending.reserve(workers);
+		for (size_t worker = 0; worker < std::min(workers, battery.frame_count()); ++worker)
+		{
+			pending.emplace_back(std::async(std::launch::async, [&]() -> void
+			{
+				auto text = std::vector<unsigned char>{};
+				for (size_t frame = next_frame++; frame < battery.frame_count(); frame = next_frame++)
+				{
+					battery.decompress(frame, text);
+					const size_t skip = frame == 0 ? layout.payload_offset : 0;
+					const auto offset = static_cast<size_t>(battery.frame_position(frame));
+					verified[frame] = layout.encoding == cjm::text_encoding::utf16le
+						? verify_frame<char16_t>(text, skip, offset)
+						: verify_frame<char>(text, skip, offset);
+				}
+			}));
+		}
+		for (auto& f : pending)
+		{
+			f.get();
+		}
+		for (auto& frame_verified : verified)
+		{
+			merge(summary, frame_verified);
+		}
+	}
+
+	void verify_mapped_binary(cjm::verify_summary& summary, const cjm::mapped_file& file, size_t workers)
+	{
+		const auto header = cjm::binary_battery_header::read_from(file.data());
+		const std::uint64_t payload_size = file.size() - cjm::binary_battery_header::size;
+		if (payload_size / cjm::binary_record_size < header.count)
+			throw std::invalid_argument{ "The binary operation battery contains fewer records than its header declares." };
+		if (payload_size != header.count * cjm::binary_record_size)
+			throw std::invalid_argument{ "The binary operation battery contains more data than its header declares." };
+
+		const auto count = static_cast<size_t>(header.count);
+		const size_t per_slice = std::max<size_t>((count + workers - 1) / workers, 1);
+		const unsigned char* records = file.data() + cjm::binary_battery_header::size;
+		std::vector<std::future<block_verification>> pending;
+		for (size_t first = 0; first < count; first += per_slice)
+		{
+			pending.emplace_back(std::async(std::launch::async, verify_binary_slice, records + first * cjm::binary_record_size,
+				std::min(per_slice, count - first), cjm::binary_battery_header::size + first * cjm::binary_record_size));
+		}
+		auto crc = cjm::crc32{}.value();
+		for (auto& f : pending)
+		{
+			block_verification verified = f.get();
+			crc = cjm::crc32::combine(crc, verified.crc, verified.records * cjm::binary_record_size);
+			merge(summary, verified);
+		}
+		if (crc != header.crc)
+			throw std::invalid_argument{ "The binary operation battery failed its crc check." };
+	}
+}
+
+cjm::battery_layout cjm::detect_battery_layout(const unsigned char* first_bytes, size_t available)
+{
+	auto ret = battery_layout{};
+	const auto& magic = binary_battery_header::magic;
+	if (available >= magic.size() && std::memcmp(first_bytes, magic.data(), magic.size()) == 0)
+	{
+		if (available < binary_battery_header::size)
+			throw std::invalid_argument{ "The binary operation battery is shorter than its header." };
+		ret.format = battery_format::binary;
+		ret.payload_offset = binary_battery_header::size;
+	}
+	else if (starts_with(first_bytes, available, utf8_bom))
+	{
+		ret.payload_offset = utf8_bom.size();
+	}
+	else if (starts_with(first_bytes, available, utf16le_bom))
+	{
+		ret.encoding = text_encoding::utf16le;
+		ret.payload_offset = utf16le_bom.size();
+	}
+	else if (starts_with(first_bytes, available, utf16be_bom))
+	{
+		throw std::invalid_argument{ "Big endian UTF-16 batteries are not supported." };
+	}
+	return ret;
+}
+
+cjm::battery_reader::battery_reader(fsv_t file_name, size_t chunk_size) : m_stream{}, m_compressed{},
+	m_format{ battery_format::text }, m_encoding{ text_encoding::utf8 }, m_header{}, m_records{ 0 }, m_line{ 0 }, m_narrow{},
+	m_wide{}, m_pos{ 0 }, m_end{ 0 }, m_eof{ false }, m_chunk_size{ chunk_size }, m_binary_header{}, m_bytes{}, m_crc{}
+{
+	if (chunk_size == 0)
+		throw std::invalid_argument{ "A battery_reader needs a chunk of at least one code unit." };
+	m_stream.exceptions(std::ios::badbit);
+	m_stream.open(fstr_t{ file_name }, std::ios::binary);
+	if (!m_stream.is_open())
+		throw std::invalid_argument{ "Unable to open battery file [" + fstr_t{ file_name } + "]." };
+
+	auto first_bytes = std::array<unsigned char, binary_battery_header::size>{};
+	m_stream.read(reinterpret_cast<char*>(first_bytes.data()), static_cast<std::streamsize>(first_bytes.size()));
+	auto available = static_cast<size_t>(m_stream.gcount());
+	if (compressed_battery_header::matches(first_bytes.data(), available))
+	{
+		m_stream.close();
+		m_compressed = std::make_unique<compressed_stream>(file_name);
+		available = m_compressed->read(first_bytes.data(), first_bytes.size());
+	}
+	const battery_layout layout = detect_battery_layout(first_bytes.data(), available);
+	m_format = layout.format;
+	m_encoding = layout.encoding;
+	if (m_format == battery_format::binary)
+	{
+		if (m_compressed)
+			throw std::invalid_argument{ "A compressed battery must hold a text battery." };
+		m_binary_header = binary_battery_header::read_from(first_bytes.data());
+		return;
+	}
+	if (m_compressed)
+	{
+		m_compressed->seek(layout.payload_offset);
+		return;
+	}
+	m_stream.clear();
+	m_stream.seekg(static_cast<std::streamoff>(layout.payload_offset));
+}
+
+cjm::battery_reader::~battery_reader() = default;
+
+size_t cjm::battery_reader::read_payload(char* dest, size_t size)
+{
+	if (m_compressed)
+		return m_compressed->read(reinterpret_cast<unsigned char*>(dest), size);
+	m_stream.read(dest, static_cast<std::streamsize>(size));
+	return static_cast<size_t>(m_stream.gcount());
+}
+
+bool cjm::battery_reader::read(std::vector<binary_operation>& fill_me, size_t max_records)
+{
+	fill_me.clear();
+	if (max_records == 0)
+		throw std::invalid_argument{ "At least one record must be requested." };
+	if (m_format == battery_format::binary)
+		return read_binary(fill_me, max_records);
+	return m_encoding == text_encoding::utf16le
+		? read_text(m_wide, fill_me, max_records)
+		: read_text(m_narrow, fill_me, max_records);
+}
+
+template<typename Char>
+bool cjm::battery_reader::read_text(std::vector<Char>& buffer, std::vector<binary_operation>& fill_me, size_t max_records)
+{
+	constexpr auto comment_marker = static_cast<Char>(battery_header::comment_marker);
+	if (buffer.empty())
+	{
+		buffer.resize(m_chunk_size);
+	}
+	fill_me.reserve(max_records);
+	auto line = std::basic_string_view<Char>{};
+	auto op = binary_operation{};
+	while (fill_me.size() < max_records && next_line(buffer, line))
+	{
+		if (line.empty())
+			continue;
+		if (line[0] == comment_marker)
+		{
+			if (m_header.empty() && m_records == 0)
+			{
+				const size_t text_begin = std::min(line.find_first_not_of(static_cast<Char>(' '), 1), line.size());
+				std::transform(line.cbegin() + text_begin, line.cend(), std::back_inserter(m_header),
+					[](Char c) -> fchar_t { return static_cast<fchar_t>(c); });
+			}
+			continue;
+		}
+		if (!try_parse_record(line, op))
+		{
+			throw std::invalid_argument{ "Line " + std::to_string(m_line) + " of the battery is not a binary operation record." };
+		}
+		if (!op.is_defined())
+		{
+			throw std::invalid_argument{ "The record on line " + std::to_string(m_line) + " of the battery has no defined result." };
+		}
+		fill_me.push_back(op);
+		++m_records;
+	}
+	return !fill_me.empty();
+}
+
+template<typename Char>
+bool cjm::battery_reader::next_line(std::vector<Char>& buffer, std::basic_string_view<Char>& line)
+{
+	constexpr auto line_feed = static_cast<Char>('\n');
+	constexpr auto carriage_return = static_cast<Char>('\r');
+	for (;;)
+	{
+		const auto window = std::basic_string_view<Char>{ buffer.data() + m_pos, m_end - m_pos };
+		const size_t line_feed_at = window.find(line_feed);
+		if (line_feed_at != std::basic_string_view<Char>::npos || (m_eof && !window.empty()))
+		{
+			line = window.substr(0, line_feed_at);
+			m_pos += line_feed_at == std::basic_string_view<Char>::npos ? window.size() : line_feed_at + 1;
+			if (!line.empty() && line.back() == carriage_return)
+				line.remove_suffix(1);
+			++m_line;
+			return true;
+		}
+		if (m_eof)
+			return false;
+
+		//keep the partial line and refill the rest of the buffer behind it.
+		std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(m_pos), buffer.begin() + static_cast<std::ptrdiff_t>(m_end), buffer.begin());
+		m_end -= m_pos;
+		m_pos = 0;
+		if (m_end == buffer.size())
+			throw std::invalid_argument{ "Line " + std::to_string(m_line + 1) + " of the battery is too long to be a record." };
+		const size_t wanted_bytes = (buffer.size() - m_end) * sizeof(Char);
+		const size_t got_bytes = read_payload(reinterpret_cast<char*>(buffer.data() + m_end), wanted_bytes);
+		if (got_bytes % sizeof(Char) != 0)
+			throw std::invalid_argument{ "The battery ends in the middle of a UTF-16 code unit." };
+		m_end += got_bytes / sizeof(Char);
+		m_eof = got_bytes < wanted_bytes;
+	}
+}
+
+bool cjm::battery_reader::read_binary(std::vector<binary_operation>& fill_me, size_t max_records)
+{
+	const std::uint64_t remaining = m_binary_header.count - m_records;
+	if (remaining == 0)
+	{
+		//a header declaring no records (e.g. from a writer that was never closed) is still checked against the payload
+		if (m_records == 0)
+			check_binary_end();
+		return false;
+	}
+	const size_t records = static_cast<size_t>(std::min<std::uint64_t>(remaining, max_records));
+	const size_t bytes = records * binary_record_size;
+	m_bytes.resize(bytes);
+	m_stream.read(reinterpret_cast<char*>(m_bytes.data()), static_cast<std::streamsize>(bytes));
+	if (static_cast<size_t>(m_stream.gcount()) != bytes)
+		throw std::invalid_argument{ "The binary operation battery contains fewer records than its header declares." };
+	m_crc.update(m_bytes.data(), bytes);
+	fill_me.reserve(records);
+	for (size_t i = 0; i < records; ++i)
+	{
+		fill_me.emplace_back(read_binary_record(m_bytes.data() + i * binary_record_size));
+		if (!fill_me.back().is_defined())
+		{
+			throw std::invalid_argument{ "Record " + std::to_string(m_records + i)
+				+ " of the binary operation battery has no defined result." };
+		}
+	}
+	m_records += records;
+	if (m_records == m_binary_header.count)
+		check_binary_end();
+	return true;
+}
+
+void cjm::battery_reader::check_binary_end()
+{
+	if (m_stream.peek() != std::ifstream::traits_type::eof())
+		throw std::invalid_argument{ "The binary operation battery contains more data than its header declares." };
+	if (m_crc.value() != m_binary_header.crc)
+		throw std::invalid_argument{ "The binary operation battery failed its crc check." };
+}
+
+cjm::verify_summary cjm::verify_battery(fsv_t file_name, unsigned thread_count)
+{
+	const auto file = mapped_file{ file_name };
+	auto ret = verify_summary{};
+	ret.file_name = fstr_t{ file_name };
+	if (file.empty())
+		return ret;
+	const size_t workers = resolve_thread_count(thread_count);
+	if (compressed_battery_header::matches(file.data(), file.size()))
+	{
+		verify_compressed(ret, compressed_battery{ file.data(), file.size() }, workers);
+		return ret;
+	}
+	const battery_layout layout = detect_battery_layout(file.data(), std::min(file.size(), binary_battery_header::size));
+	ret.format = layout.format;
+	if (layout.format == battery_format::binary)
+	{
+		verify_mapped_binary(ret, file, workers);
+	}
+	else
+	{
+		const unsigned char* payload = file.data() + layout.payload_offset;
+		const size_t payload_size = file.size() - layout.payload_offset;
+		if (layout.encoding == text_encoding::utf16le)
+			verify_mapped_text<char16_t>(ret, payload, payload_size, layout.payload_offset, workers);
+		else
+			verify_mapped_text<char>(ret, payload, payload_size, layout.payload_offset, workers);
+	}
+	return ret;
+}
+
+cjm::verify_summary cjm::verify_streamed_battery(fsv_t file_name, unsigned thread_count)
+{
+	auto reader = battery_reader{ file_name };
+	auto ret = verify_summary{};
+	ret.file_name = fstr_t{ file_name };
+	ret.format = reader.format();
+
+	//the calling thread reads the next round of blocks while the workers verify the current one.
+	const size_t workers = resolve_thread_count(thread_count);
+	std::array<std::vector<std::vector<binary_operation>>, 2> banks;
+	for (auto& bank : banks)
+	{
+		bank.resize(workers);
+	}
+	std::vector<std::future<block_verification>> pending;
+	pending.reserve(workers);
+	const auto collect = [&]() -> void
+	{
+		for (auto& f : pending)
+		{
+			block_verification verified = f.get();
+			merge(ret, verified);
+		}
+		pending.clear();
+	};
+
+	size_t bank_idx = 0;
+	bool exhausted = false;
+	while (!exhausted)
+	{
+		auto& bank = banks[bank_idx];
+		size_t filled = 0;
+		while (filled < workers && reader.read(bank[filled], random_op_block_size))
+		{
+			++filled;
+		}
+		exhausted = filled < workers;
+		collect();
+		for (size_t worker = 0; worker < filled; ++worker)
+		{
+			pending.emplace_back(std::async(std::launch::async, verify_block, std::cref(bank[worker])));
+		}
+		bank_idx ^= 1;
+	}
+	collect();
+	return ret;
+}
+
+std::ostream& cjm::operator<<(std::ostream& ostr, const verify_summary& summary)
+{
+	ostr << "Verified " << summary.records << " records of " << (summary.format == battery_format::binary ? "binary" : "text")
+		<< " battery [" << summary.file_name << "]: " << summary.failures << " failures." << newl;
+	auto buffer = std::array<char, max_serialized_record_size>{};
+	for (const auto& [index, op] : summary.first_failures)
+	{
+		const char* const end = format_record(buffer.data(), op.op_code(), op.left_operand(), op.right_operand(),
+			op.result().value_or(0));
+		ostr << "\tRecord " << index << ": [" << fsv_t{ buffer.data(), static_cast<size_t>(end - buffer.data()) } << "]." << newl;
+	}
+	return ostr;
+}
@@ -0,0 +1,106 @@
+#ifndef CJM_READER_HPP_
+#define CJM_READER_HPP_
+#include "helper.hpp"
+#include "binary_format.hpp"
+#include <fstream>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	class battery_reader;
+	class compressed_stream;
+	struct battery_layout;
+	struct verify_summary;
+
+	battery_layout detect_battery_layout(const unsigned char* first_bytes, size_t available);
+	//verifies a memory mapped battery: each worker parses and checks a record aligned slice of the mapping in place (or,
+	//for a compressed battery, decompresses and checks one frame at a time).
+	verify_summary verify_battery(fsv_t file_name, unsigned thread_count = 0);
+	//verifies a battery read through a battery_reader: for files that cannot be mapped.
+	verify_summary verify_streamed_battery(fsv_t file_name, unsigned thread_count = 0);
+	std::ostream& operator<<(std::ostream& ostr, const verify_summary& summary);
+
+	//Where the records of a battery begin and how they are encoded, as detected from (up to binary_battery_header::size
+	//of) its first bytes: binary batteries start with binary_battery_header::magic, text batteries may start with a BOM.
+	struct battery_layout final
+	{
+		battery_format format = battery_format::text;
+		text_encoding encoding = text_encoding::utf8;
+		size_t payload_offset = 0;
+	};
+
+	//Streams the records of a text (binary_operation_serdeser format) or binary battery without loading the file.
+	//The format and text encoding (UTF-8 with or without a BOM, UTF-16LE with a BOM) are detected from the first bytes;
+	//blank lines and battery_header comment lines are skipped.  A compressed (text) battery is decompressed a frame at
+	//a time.
+	class battery_reader final
+	{
+	public:
+		static constexpr size_t default_chunk_size = 1 << 20;
+
+		//chunk_size: the code units of text buffered at a time; a line longer than that is rejected.
+		explicit battery_reader(fsv_t file_name, size_t chunk_size = default_chunk_size);
+		battery_reader(const battery_reader& other) = delete;
+		battery_reader(battery_reader&& other) noexcept = delete;
+		battery_reader& operator=(const battery_reader& other) = delete;
+		battery_reader& operator=(battery_reader&& other) noexcept = delete;
+		~battery_reader();
+
+		//replaces the contents of fill_me with up to max_records records: returns false once the battery is exhausted.
+		//throws std::invalid_argument on a malformed record, a record without a defined result (binary_operation::is_defined)
+		//or, for binary batteries, a failed crc check.
+		bool read(std::vector<binary_operation>& fill_me, size_t max_records);
+
+		[[nodiscard]] battery_format format() const noexcept { return m_format; }
+		[[nodiscard]] text_encoding encoding() const noexcept { return m_encoding; }
+		//the comment line preceding the first record of a text battery (without its marker), once read has been called
+		[[nodiscard]] const fstr_t& header() const noexcept { return m_header; }
+		[[nodiscard]] std::uint64_t records_read() const noexcept { return m_records; }
+
+	private:
+		template<typename Char>
+		bool read_text(std::vector<Char>& buffer, std::vector<binary_operation>& fill_me, size_t max_records);
+		template<typename Char>
+		bool next_line(std::vector<Char>& buffer, std::basic_string_view<Char>& line);
+		bool read_binary(std::vector<binary_operation>& fill_me, size_t max_records);
+		void check_binary_end();
+		//reads up to size bytes of the (decompressed) battery: returns how many.
+		size_t read_payload(char* dest, size_t size);
+
+		std::ifstream m_stream;
+		std::unique_ptr<compressed_stream> m_compressed; //null unless the file is a compressed battery
+		battery_format m_format;
+		text_encoding m_encoding;
+		fstr_t m_header;
+		std::uint64_t m_records;
+		std::uint64_t m_line;
+		//text batteries: the unparsed window [m_pos, m_end) of the buffer matching m_encoding
+		std::vector<char> m_narrow;
+		std::vector<char16_t> m_wide;
+		size_t m_pos;
+		size_t m_end;
+		bool m_eof;
+		size_t m_chunk_size;
+		//binary batteries
+		binary_battery_header m_binary_header;
+		std::vector<unsigned char> m_bytes;
+		crc32 m_crc;
+	};
+
+	struct verify_summary final
+	{
+		static constexpr size_t max_reported_failures = 10;
+
+		fstr_t file_name;
+		battery_format format = battery_format::text;
+		std::uint64_t records = 0;
+		std::uint64_t failures = 0;
+		//record index and record of the first max_reported_failures failures, in file order
+		std::vector<std::pair<std::uint64_t, binary_operation>> first_failures;
+
+		[[nodiscard]] bool passed() const noexcept { return failures == 0; }
+	};
+}
+#endif // CJM_READER_HPP_
@@ -0,0 +1,158 @@
+#include "shard.hpp"
+#include "binary_format.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+#include <atomic>
+#include <cassert>
+
+namespace
+{
+	using namespace std::string_view_literals;
+
+	//the position of the extension's '.' in the last path component, or npos.
+	size_t extension_at(cjm::fsv_t file_name) noexcept
+	{
+		const size_t dot = file_name.rfind('.');
+		const size_t separator = file_name.find_last_of("/\\"sv);
+		return dot == cjm::fsv_t::npos || (separator != cjm::fsv_t::npos && dot < separator) ? cjm::fsv_t::npos : dot;
+	}
+
+	cjm::shard_info write_shard(cjm::fsv_t test_battery_name, cjm::fstr_t file_name, std::uint64_t first_record, size_t count,
+		std::uint64_t seed, cjm::battery_format format, unsigned thread_count, cjm::operand_distribution distribution,
+		cjm::rgen_engine engine, cjm::text_encoding encoding)
+	{
+		using namespace cjm;
+		if (format == battery_format::binary)
+		{
+			write_random_ops_binary(file_name, count, seed, thread_count, first_record, distribution, engine);
+		}
+		else
+		{
+			write_random_ops(test_battery_name, file_name, count, seed, thread_count, first_record, distribution, engine,
+				encoding);
+		}
+		const auto file = mapped_file{ file_name };
+		auto crc = crc32{};
+		crc.update(file.data(), file.size());
+		return shard_info{ std::move(file_name), first_record, count, first_record / random_op_block_size,
+			(first_record + count - 1) / random_op_block_size, file.size(), crc.value() };
+	}
+}
+
+cjm::fstr_t cjm::shard_file_name(fsv_t file_name, size_t shard)
+{
+	fstr_stream_t stream;
+	const size_t dot = extension_at(file_name);
+	stream << file_name.substr(0, dot) << '.' << std::setw(5) << std::setfill('0') << shard;
+	if (dot != fsv_t::npos)
+	{
+		stream << file_name.substr(dot);
+	}
+	return stream.str();
+}
+
+cjm::fstr_t cjm::manifest_file_name(fsv_t file_name)
+{
+	return fstr_t{ file_name.substr(0, extension_at(file_name)) } + ".manifest.json";
+}
+
+std::vector<std::uint64_t> cjm::shard_boundaries(std::uint64_t first_record, size_t count, size_t shard_count, size_t block_size)
+{
+	if (shard_count == 0 || shard_count > count)
+		throw std::invalid_argument{ "The number of shards must be between one and the number of records." };
+	auto ret = std::vector<std::uint64_t>{};
+	ret.reserve(shard_count + 1);
+	ret.push_back(first_record);
+	const bool align = count / shard_count >= block_size;
+	for (size_t shard = 1; shard < shard_count; ++shard)
+	{
+		const std::uint64_t boundary = first_record + static_cast<std::uint64_t>(count) * shard / shard_count;
+		ret.push_back(align ? std::max(boundary - boundary % block_size, ret.back() + 1) : boundary);
+	}
+	ret.push_back(first_record + count);
+	return ret;
+}
+
+cjm::shard_manifest cjm::write_sharded_battery(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+	size_t shard_count, battery_format format, unsigned thread_count, std::uint64_t first_record, operand_distribution distribution,
+	rgen_engine engine, text_encoding encoding)
+{
+	if (file_name.empty())
+	{
+		throw std::invalid_argument{ "File name supplied cannot be empty." };
+	}
+	const std::vector<std::uint64_t> boundaries = shard_boundaries(first_record, count, shard_count, random_op_block_size);
+	auto manifest = shard_manifest{ fstr_t{ test_battery_name }, format, encoding, seed, distribution, engine, random_op_block_size,
+		first_record, count, std::vector<shard_info>(shard_count) };
+
+	//up to one shard per thread; the threads left over when there are fewer shards are shared among them.
+	const unsigned threads = resolve_thread_count(thread_count);
+	const size_t writers = std::min<size_t>(threads, shard_count);
+	const auto threads_per_shard = static_cast<unsigned>(std::max<size_t>(1, threads / shard_count));
+	std::atomic<size_t> next_shard{ 0 };
+	std::vector<std::future<void>> pending;
+	pending.reserve(writers);
+	for (size_t writer = 0; writer < writers; ++writer)
+	{
+		pending.emplace_back(std::async(std::launch::async, [&]() -> void
+		{
+			for (size_t shard = next_shard++; shard < shard_count; shard = next_shard++)
+			{
+				manifest.shards[shard] = write_shard(test_battery_name, shard_file_name(file_name, shard), boundaries[shard],
+					static_cast<size_t>(boundaries[shard + 1] - boundaries[shard]), seed, format, threads_per_shard, distribution,
+					engine, encoding);
+			}
+		}));
+	}
+	for (auto& f : pending)
+	{
+		f.get();
+	}
+
+	auto stream = std::ofstream{};
+	stream.exceptions(std::ios::badbit | std::ios::failbit);
+	stream.open(manifest_file_name(file_name), std::ios::trunc);
+	manifest.write(stream);
+	stream.close();
+	return manifest;
+}
+
+void cjm::shard_manifest::write(std::ostream& ostr) const
+{
+	const auto hex = [](std::uint64_t value, int digits) -> fstr_t
+	{
+		fstr_stream_t stream;
+		stream << "0x" << std::hex << std::setw(digits) << std::setfill('0') << value;
+		return stream.str();
+	};
+	ostr << "{" << newl << "\t\"battery\": \"" << json_escape(battery_name) << "\"," << newl
+		<< "\t\"format\": \"" << (format == battery_format::binary ? "binary" : "text") << "\"," << newl
+		<< "\t\"encoding\": \"" << (encoding == text_encoding::utf16le ? "utf16" : "utf8") << "\"," << newl
+		<< "\t\"engine\": \"" << name(engine) << "\"," << newl
+		<< "\t\"seed\": \"" << hex(seed, 16) << "\"," << newl
+		<< "\t\"distribution\": \"" << name(distribution) << "\"," << newl
+		<< "\t\"block_size\": " << block_size << "," << newl
+		<< "\t\"first_record\": " << first_record << "," << newl
+		<< "\t\"count\": " << count << "," << newl
+		<< "\t\"shards\": [";
+	for (size_t i = 0; i < shards.size(); ++i)
+	{
+		const shard_info& shard = shards[i];
+		ostr << (i == 0 ? "" : ",") << newl << "\t\t{ \"file\": \"" << json_escape(shard.file_name) << "\", \"first_record\": " << shard.first_record
+			<< ", \"count\": " << shard.count << ", \"bytes\": " << shard.bytes << ", \"first_block\": " << shard.first_block
+			<< ", \"last_block\": " << shard.last_block << ", \"crc32\": \"" << hex(shard.crc, 8) << "\" }";
+	}
+	ostr << newl << "\t]" << newl << "}" << newl;
+}
+
+std::ostream& cjm::operator<<(std::ostream& ostr, const shard_manifest& manifest)
+{
+	ostr << "Wrote " << manifest.count << " records of " << manifest.battery_name << " as " << manifest.shards.size() << " shards:" << newl;
+	for (const shard_info& shard : manifest.shards)
+	{
+		ostr << "\t[" << shard.file_name << "]: records [" << shard.first_record << ", " << shard.first_record + shard.count
+			<< "); " << shard.bytes << " bytes; crc32 0x" << std::hex << std::setw(8) << std::setfill('0') << shard.crc
+			<< std::dec << std::setfill(' ') << "." << newl;
+	}
+	return ostr;
+}
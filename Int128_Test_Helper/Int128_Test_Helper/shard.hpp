@@ -0,0 +1,58 @@
+#ifndef CJM_SHARD_HPP_
+#define CJM_SHARD_HPP_
+#include "helper.hpp"
+#include <ostream>
+#include <vector>
+#include <cstdint>
+namespace cjm
+{
+	struct shard_info;
+	struct shard_manifest;
+
+	//"ops.txt", 3 -> "ops.00003.txt"
+	fstr_t shard_file_name(fsv_t file_name, size_t shard);
+	//"ops.txt" -> "ops.manifest.json"
+	fstr_t manifest_file_name(fsv_t file_name);
+	//the first record of each of shard_count shards of records [first_record, first_record + count), plus the end.  Shards
+	//at least a block long start on a block boundary so no worker generates records only to skip them.
+	std::vector<std::uint64_t> shard_boundaries(std::uint64_t first_record, size_t count, size_t shard_count, size_t block_size);
+	//Writes records [first_record, first_record + count) of the random battery identified by seed as shard_count
+	//batteries of roughly equal record count, each a slice that verify_battery checks on its own, and a manifest
+	//(manifest_file_name(file_name)) describing them.  Shards are written concurrently.
+	shard_manifest write_sharded_battery(fsv_t test_battery_name, fsv_t file_name, size_t count, std::uint64_t seed,
+		size_t shard_count, battery_format format, unsigned thread_count = 0, std::uint64_t first_record = 0,
+		operand_distribution distribution = operand_distribution::uniform, rgen_engine engine = rgen_engine::mt19937_64,
+		text_encoding encoding = text_encoding::utf8);
+	std::ostream& operator<<(std::ostream& ostr, const shard_manifest& manifest);
+
+	struct shard_info final
+	{
+		fstr_t file_name;
+		std::uint64_t first_record;
+		std::uint64_t count;
+		//records are drawn from the streams of blocks [first_block, last_block] of the battery (cjm_helper_rgen::seek_block)
+		std::uint64_t first_block;
+		std::uint64_t last_block;
+		std::uint64_t bytes;
+		//crc32 of the whole file
+		std::uint32_t crc;
+	};
+
+	struct shard_manifest final
+	{
+		fstr_t battery_name;
+		battery_format format;
+		text_encoding encoding; //of text shards
+		std::uint64_t seed;
+		operand_distribution distribution;
+		rgen_engine engine;
+		std::uint64_t block_size;
+		std::uint64_t first_record;
+		std::uint64_t count;
+		std::vector<shard_info> shards;
+
+		//writes the manifest as json.
+		void write(std::ostream& ostr) const;
+	};
+}
+#endif // CJM_SHARD_HPP_
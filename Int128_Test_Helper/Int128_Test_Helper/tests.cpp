@@ -1,76 +1,24 @@
 #include "tests.hpp"
+#include "parallel.hpp"
+#include "binary_format.hpp"
+#include "hex.hpp"
+#include "reader.hpp"
+#include "batch.hpp"
+#include "operation_table.hpp"
+#include "coverage.hpp"
+#include "conversion.hpp"
+#include "mul_div.hpp"
+#include "shard.hpp"
+#include "mapped_file.hpp"
+#include "async_writer.hpp"
+#include "compressed.hpp"
+#include "differential.hpp"
+#include "edge.hpp"
+#include "monitor.hpp"
+#include <boost/multiprecision/cpp_int.hpp>
+#include <set>
 #include <utility>
-std::pair<double, cjm::int128_t> calculate_percent_diff(cjm::int128_t left, cjm::int128_t right)
-{
-	if (left == right) return std::make_pair<double, cjm::int128_t>(0, 0);
-
-	if (left < 0 && right < 0)
-	{
-		if (left == std::numeric_limits<cjm::int128_t>::min())
-		{
-			left += 1; 
-			right -= 1; //since left does not equal right
-			if (right == std::numeric_limits<cjm::int128_t>::min()) //ok we switched places .... the difference is one and percent diff is 1 / min
-			{
-				return std::make_pair<double, cjm::int128_t>(static_cast<double>(1) / static_cast<double>(right == std::numeric_limits<cjm::int128_t>::min()), 1);
-			}
-		}
-		if (right == std::numeric_limits<cjm::int128_t>::min())
-		{
-			right += 1;
-			left -= 1; //since left does not equal right
-			if (left == std::numeric_limits<cjm::int128_t>::min()) //ok we switched places .... the difference is one and percent diff is 1 / min
-			{
-				return std::make_pair<double, cjm::int128_t>(static_cast<double>(1) / static_cast<double>(right == std::numeric_limits<cjm::int128_t>::min()), 1);
-			}			
-		}
-		//ok we know it's safe to make them both positive.
-		left = -left;
-		right = -right;		
-	}
-
-	auto throw_if_diff_too_big = [](cjm::int128_t bigger, cjm::int128_t smaller) -> cjm::int128_t
-	{
-		assert(bigger >= 0);
-		if (smaller < 0)
-		{
-			auto bigger_us = static_cast<cjm::uint128_t>(bigger);
-			auto smaller_us = static_cast<cjm::uint128_t>(smaller);
-			auto sum = bigger_us + smaller_us;
-			auto s_sum = static_cast<cjm::int128_t>(sum);
-			if (s_sum <= bigger) throw std::domain_error{ "The difference would cause signed integer overflow." };
-			return s_sum;
-		}
-		auto temp = bigger - smaller;
-		if (temp == std::numeric_limits<cjm::int128_t>::min()) throw std::domain_error{ "Difference cannot be expressed as a positive signed int128." };
-		return temp < 0 ? -temp : temp;
-	};
-	
-	auto bigger = left > right ? left : right;
-	auto smaller = left < right ? left : right;
-	//std::cout << "bigger comparand: [" << std::dec << bigger << "]; smaller comparand: [" << std::dec << smaller << "].";
-	const auto difference = throw_if_diff_too_big(bigger, smaller);
-
-	const auto doubleSmallest = static_cast<double>(std::numeric_limits<cjm::int128_t>::min());
-	if (difference == 0) return std::pair<double, cjm::int128_t>(0, 0);
-	double percentDiff;
-	
-	if (bigger < 0)
-	{
-		if (smaller == std::numeric_limits<cjm::int128_t>::min())
-		{
-			percentDiff = static_cast<double>(difference) / doubleSmallest;
-		}
-		else
-		{
-			percentDiff = static_cast<double>(difference) / static_cast<double>(-smaller);
-		}
-	}
-			
-	assert(difference != 0 && bigger != 0);
-	return std::make_pair<double, cjm::int128_t>(static_cast<double>(difference) / static_cast<double>(bigger), static_cast<cjm::int128_t>(difference < 0 ? -difference : difference));
-}
-
+#include <thread>
 template<typename Invocable>
 void do_test(cjm::fsv_t name, Invocable do_me)
 {
@@ -259,6 +207,121 @@ void cjm::tests::run_tests()
 			{
 				test_serialize_all_tc1_bin_op();
 			});
+		test_name = "test_random_op_chunk_reuse"sv;
+		do_test(test_name, []() -> void
+			{
+				test_random_op_chunk_reuse();
+			});
+		test_name = "test_parallel_generation_deterministic"sv;
+		do_test(test_name, []() -> void
+			{
+				test_parallel_generation_deterministic();
+			});
+		test_name = "test_battery_slice_regeneration"sv;
+		do_test(test_name, []() -> void
+			{
+				test_battery_slice_regeneration();
+			});
+		test_name = "test_binary_battery_round_trip"sv;
+		do_test(test_name, []() -> void
+			{
+				test_binary_battery_round_trip();
+			});
+		test_name = "test_hex_formatter"sv;
+		do_test(test_name, []() -> void
+			{
+				test_hex_formatter();
+			});
+		test_name = "test_hex_parser"sv;
+		do_test(test_name, []() -> void
+			{
+				test_hex_parser();
+			});
+		test_name = "test_battery_reader"sv;
+		do_test(test_name, []() -> void
+			{
+				test_battery_reader();
+			});
+		test_name = "test_undefined_records"sv;
+		do_test(test_name, [] () -> void
+		{
+			test_undefined_records();
+		});
+		test_name = "test_partitioned_batch"sv;
+		do_test(test_name, []() -> void
+			{
+				test_partitioned_batch();
+			});
+		test_name = "test_operation_table"sv;
+		do_test(test_name, []() -> void
+			{
+				test_operation_table();
+			});
+		test_name = "test_stratified_generation"sv;
+		do_test(test_name, []() -> void
+			{
+				test_stratified_generation();
+			});
+		test_name = "test_wide_generation"sv;
+		do_test(test_name, []() -> void
+			{
+				test_wide_generation();
+			});
+		test_name = "test_tick_conversion_battery"sv;
+		do_test(test_name, []() -> void
+			{
+				test_tick_conversion_battery();
+			});
+		test_name = "test_mul_div"sv;
+		do_test(test_name, []() -> void
+			{
+				test_mul_div();
+			});
+		test_name = "test_sharded_battery"sv;
+		do_test(test_name, []() -> void
+			{
+				test_sharded_battery();
+			});
+		test_name = "test_async_file_writer"sv;
+		do_test(test_name, []() -> void
+			{
+				test_async_file_writer();
+			});
+		test_name = "test_text_encoding"sv;
+		do_test(test_name, []() -> void
+			{
+				test_text_encoding();
+			});
+		test_name = "test_compressed_battery"sv;
+		do_test(test_name, []() -> void
+			{
+				test_compressed_battery();
+			});
+		test_name = "test_differential_backends"sv;
+		do_test(test_name, []() -> void
+			{
+				test_differential_backends();
+			});
+		test_name = "test_edge_cross_product"sv;
+		do_test(test_name, []() -> void
+			{
+				test_edge_cross_product();
+			});
+		test_name = "test_generation_monitor"sv;
+		do_test(test_name, []() -> void
+			{
+				test_generation_monitor();
+			});
+		test_name = "test_thread_rgen"sv;
+		do_test(test_name, []() -> void
+			{
+				test_thread_rgen();
+			});
+		test_name = "test_xoshiro_engine"sv;
+		do_test(test_name, []() -> void
+			{
+				test_xoshiro_engine();
+			});
 		
 	}
 	catch (const test::cjm_test_fail&)
@@ -360,6 +423,7 @@ void cjm::tests::test_edge_case_comparisons()
 {
 	try
 	{
+		const std::vector<binary_operation> edge_tests_comparison_v = edge_tests_comparison();
 		test::cjm_assert(!edge_tests_comparison_v.empty(), "edge test comparisons should not be empty.");
 		test::cjm_assert(std::all_of(edge_tests_comparison_v.cbegin(), edge_tests_comparison_v.cend(), [](const binary_operation& op) -> bool
 			{
@@ -375,3 +439,1694 @@ void cjm::tests::test_edge_case_comparisons()
 		throw test::cjm_test_fail{ fstr_t{ex.what()} };
 	}
 }
+
+void cjm::tests::test_random_op_chunk_reuse()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr size_t first_chunk = 64;
+		constexpr size_t second_chunk = 16;
+		auto chunk = std::vector<binary_operation>{};
+		create_random_ops(chunk, first_chunk);
+		cjm_assert(chunk.size() == first_chunk, "The first chunk does not contain the requested number of operations."sv);
+		const auto* const first_buffer = chunk.data();
+		create_random_ops(chunk, second_chunk);
+		cjm_assert(chunk.size() == second_chunk, "The second chunk does not contain the requested number of operations."sv);
+		cjm_assert(chunk.data() == first_buffer, "Refilling a smaller chunk should reuse the existing buffer."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_parallel_generation_deterministic()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr std::uint64_t seed = 0xc0de'd00d'fea2'b00b;
+		constexpr size_t count = 1'000;
+		constexpr size_t block_size = 128;
+		const auto generate = [=](unsigned threads) -> std::vector<binary_operation>
+		{
+			auto ret = std::vector<binary_operation>{};
+			ret.reserve(count);
+			generate_random_blocks(seed, 0, count, threads, [&](const std::vector<binary_operation>& block) -> void
+			{
+				ret.insert(ret.end(), block.cbegin(), block.cend());
+			}, block_size);
+			return ret;
+		};
+		const auto single = generate(1);
+		const auto several = generate(3);
+		cjm_assert(single.size() == count, "The generated battery does not contain the requested number of operations."sv);
+		cjm_assert(single == several, "The battery differs depending on the number of threads that generated it."sv);
+		cjm_assert(std::all_of(several.cbegin(), several.cend(), [](const binary_operation& op) -> bool
+			{
+				return op.has_correct_result();
+			}), "One or more generated operations lack the correct result."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_battery_slice_regeneration()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr std::uint64_t seed = 0x0123'4567'89ab'cdef;
+		constexpr size_t count = 1'000;
+		constexpr size_t block_size = 128;
+		constexpr std::uint64_t slice_begin = 300;
+		constexpr size_t slice_count = 250;
+		const auto generate = [=](std::uint64_t first_record, size_t how_many) -> std::vector<binary_operation>
+		{
+			auto ret = std::vector<binary_operation>{};
+			ret.reserve(how_many);
+			generate_random_blocks(seed, first_record, how_many, 2, [&](const std::vector<binary_operation>& block) -> void
+			{
+				ret.insert(ret.end(), block.cbegin(), block.cend());
+			}, block_size);
+			return ret;
+		};
+		const auto whole = generate(0, count);
+		const auto slice = generate(slice_begin, slice_count);
+		cjm_assert(slice.size() == slice_count, "The slice does not contain the requested number of operations."sv);
+		cjm_assert(std::equal(slice.cbegin(), slice.cend(), whole.cbegin() + slice_begin), 
+			"The regenerated slice differs from the same records of the whole battery."sv);
+		cjm_assert(generate(0, count) == whole, "The same seed did not reproduce the same battery."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_binary_battery_round_trip()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr fsv_t file_name = "binary_round_trip.bin";
+		constexpr std::uint64_t seed = 0xfea2'b00b'c0de'd00d;
+		auto ops = std::vector<binary_operation>{};
+		generate_random_blocks(seed, 0, 300, 2, [&](const std::vector<binary_operation>& block) -> void
+		{
+			ops.insert(ops.end(), block.cbegin(), block.cend());
+		}, 128);
+		const std::vector<binary_operation> edge_comparisons = edge_tests_comparison();
+		ops.insert(ops.end(), edge_comparisons.cbegin(), edge_comparisons.cend());
+
+		auto header = binary_battery_header{};
+		header.seed = seed;
+		header.block_size = 128;
+		header.set_engine_name(name(rgen_engine::mt19937_64));
+		{
+			auto writer = binary_battery_writer{ file_name, header };
+			writer.write(ops);
+			writer.close();
+			cjm_assert(writer.count() == ops.size(), "The writer did not count every record written."sv);
+		}
+		const auto loaded = load_binary_battery(file_name);
+		cjm_assert(loaded == ops, "The operations read back differ from the ones written."sv);
+		cjm_assert(std::all_of(loaded.cbegin(), loaded.cend(), [](const binary_operation& op) -> bool
+			{
+				return op.has_correct_result();
+			}), "One or more operations read back lack the correct result."sv);
+
+		{
+			auto corrupt = std::fstream{ fstr_t{ file_name }, std::ios::in | std::ios::out | std::ios::binary };
+			constexpr auto corrupt_at = static_cast<std::streamoff>(binary_battery_header::size + 5);
+			corrupt.seekg(corrupt_at);
+			const auto original = static_cast<char>(corrupt.get());
+			corrupt.seekp(corrupt_at);
+			corrupt.put(static_cast<char>(~original));
+		}
+		bool detected = false;
+		try
+		{
+			(void) load_binary_battery(file_name);
+		}
+		catch (const std::invalid_argument&)
+		{
+			detected = true;
+		}
+		cjm_assert(detected, "A corrupted binary battery was not detected by the crc check."sv);
+
+		{
+			//a count of 2^50 records: rejected before anything is reserved for them.
+			auto corrupt = std::fstream{ fstr_t{ file_name }, std::ios::in | std::ios::out | std::ios::binary };
+			corrupt.seekp(30);
+			corrupt.put(static_cast<char>(0x04));
+		}
+		detected = false;
+		try
+		{
+			(void) load_binary_battery(file_name);
+		}
+		catch (const std::invalid_argument&)
+		{
+			detected = true;
+		}
+		cjm_assert(detected, "A header declaring more records than its file holds was not rejected."sv);
+
+		{
+			auto abandoned = binary_battery_writer{ file_name, header };
+			abandoned.write(ops);
+		}
+		detected = false;
+		try
+		{
+			(void) load_binary_battery(file_name);
+		}
+		catch (const std::invalid_argument&)
+		{
+			detected = true;
+		}
+		cjm_assert(detected, "A binary battery whose writer was never closed passed verification."sv);
+		detected = false;
+		try
+		{
+			(void) verify_streamed_battery(file_name, 2);
+		}
+		catch (const std::invalid_argument&)
+		{
+			detected = true;
+		}
+		cjm_assert(detected, "A binary battery whose writer was never closed passed streamed verification."sv);
+		std::remove(file_name.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_hex_formatter()
+{
+	try
+	{
+		using test::cjm_assert;
+		//first record of comp_edge_ops.txt
+		constexpr tsv_t expected_record = u"Compare;ffffffffffffffff\t7fffffffffffffff\t;ffffffffffffffff\t7fffffffffffffff\t;"
+			u"0000000000000000\t0000000000000000\t;"sv;
+		constexpr int128_t max = std::numeric_limits<int128_t>::max();
+		auto record = std::array<tchar_t, max_serialized_record_size>{};
+		const tchar_t* end = format_record(record.data(), binary_op::compare, max, max, 0);
+		cjm_assert(tsv_t{ record.data(), static_cast<size_t>(end - record.data()) } == expected_record, 
+			"The formatted record does not match the reference text."sv);
+
+		const auto reference = [](int128_t value) -> fstr_t
+		{
+			fstr_stream_t stream;
+			stream << std::hex << std::setfill('0') << std::setw(hex_u64_digits) << absl::Int128Low64(value) << '\t'
+				<< std::setw(hex_u64_digits) << absl::Int128High64(value) << '\t';
+			return stream.str();
+		};
+		const auto values = std::array<int128_t, 6>{ 0, 1, -1, std::numeric_limits<int128_t>::min(), max,
+			absl::MakeInt128(0x0123'4567'89ab'cdef, 0xfedc'ba98'7654'3210) };
+		for (const int128_t value : values)
+		{
+			auto narrow = std::array<char, serialized_int128_size>{};
+			format_int128(narrow.data(), value);
+			cjm_assert(fsv_t{ narrow.data(), narrow.size() } == reference(value), "The narrow formatter disagrees with iostream formatting."sv);
+			cjm_assert(serialize(value) == to_tstr_t(reference(value)), "The wide formatter disagrees with iostream formatting."sv);
+		}
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_hex_parser()
+{
+	try
+	{
+		using test::cjm_assert;
+		using test::cjm_deny;
+		std::uint64_t value = 0;
+		cjm_assert(try_parse_hex_u64(u"c0ded00dfea2b00b"sv, value) && value == 0xc0de'd00d'fea2'b00b, "Failed to parse 16 lowercase digits."sv);
+		cjm_assert(try_parse_hex_u64("C0DED00DFEA2B00B"sv, value) && value == 0xc0de'd00d'fea2'b00b, "Failed to parse 16 uppercase digits."sv);
+		cjm_assert(try_parse_hex_u64(u"1f"sv, value) && value == 0x1f, "Failed to parse a short field."sv);
+		cjm_deny(try_parse_hex_u64(u""sv, value), "An empty field was accepted."sv);
+		cjm_deny(try_parse_hex_u64(u"c0ded00dfea2b00b0"sv, value), "Seventeen digits were accepted."sv);
+		cjm_deny(try_parse_hex_u64(u"c0ded00dfea2b0g0"sv, value), "A non hex digit was accepted."sv);
+		cjm_deny(try_parse_hex_u64(u"c0ded00dfea2b0\u0130"sv, value) || try_parse_hex_u64(u"c0ded00dfea2b0\u8030"sv, value),
+			"A wide character that narrows to a hex digit was accepted."sv);
+		cjm_deny(try_parse_hex_u64("0x1f"sv, value), "A prefix was accepted."sv);
+		cjm_deny(try_parse_hex_u64(u" 1f"sv, value), "Whitespace was accepted."sv);
+
+		int128_t parsed = 0;
+		cjm_assert(try_parse_int128(u"\t1\t\t8000000000000000\t"sv, parsed) && parsed == std::numeric_limits<int128_t>::min() + 1,
+			"Failed to parse tab delimited halves."sv);
+		cjm_deny(try_parse_int128(u"1\t"sv, parsed), "A value with only one half was accepted."sv);
+		cjm_deny(try_parse_int128(u"1\t2\t3\t"sv, parsed), "A value with three fields was accepted."sv);
+		bool threw = false;
+		try
+		{
+			(void)deserialize(u"0123\tz\t"sv);
+		}
+		catch (const std::invalid_argument&)
+		{
+			threw = true;
+		}
+		cjm_assert(threw, "deserialize did not reject malformed input."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_battery_reader()
+{
+	try
+	{
+		using test::cjm_assert;
+		using test::cjm_deny;
+		constexpr fsv_t text_file = "reader_round_trip.txt";
+		constexpr fsv_t utf16_file = "reader_round_trip_utf16.txt";
+		constexpr fsv_t binary_file = "reader_round_trip.bin";
+		constexpr std::uint64_t seed = 0xd00d'fea2'b00b'c0de;
+		auto ops = std::vector<binary_operation>{};
+		generate_random_blocks(seed, 0, 300, 2, [&](const std::vector<binary_operation>& block) -> void
+		{
+			ops.insert(ops.end(), block.cbegin(), block.cend());
+		}, 128);
+		const std::vector<binary_operation> edge_comparisons = edge_tests_comparison();
+		ops.insert(ops.end(), edge_comparisons.cbegin(), edge_comparisons.cend());
+
+		binary_operation parsed;
+		cjm_deny(try_parse_record("Compare;0\t0\t;0\t0\t;"sv, parsed), "A record missing its result was accepted."sv);
+		cjm_deny(try_parse_record("Exponent;0\t0\t;0\t0\t;0\t0\t;"sv, parsed), "A record with an unknown op was accepted."sv);
+		cjm_deny(try_parse_record("Add;0\t0\t;0\t0\t;0\t0\t;0"sv, parsed), "A record with trailing text was accepted."sv);
+
+		{
+			auto stream = tofstrm_t{};
+			stream.exceptions(std::ios::badbit | std::ios::failbit);
+			stream.open(text_file.data());
+			stream << battery_header{ "Reader Test Battery"sv, name(rgen_engine::mt19937_64), seed, 128, 0, ops.size() };
+			stream << ops;
+		}
+		{
+			auto text = tstr_t{ u'\xfeff' };
+			auto buffer = std::array<tchar_t, max_serialized_record_size>{};
+			for (const binary_operation& op : ops)
+			{
+				const tchar_t* end = format_record(buffer.data(), op.op_code(), op.left_operand(), op.right_operand(), op.result().value());
+				text.append(buffer.data(), static_cast<size_t>(end - buffer.data()));
+				text += u"\r\n"sv;
+			}
+			auto stream = std::ofstream{ fstr_t{ utf16_file }, std::ios::binary | std::ios::trunc };
+			for (const tchar_t c : text)
+			{
+				stream.put(static_cast<char>(c & 0xff));
+				stream.put(static_cast<char>(c >> 8));
+			}
+		}
+		{
+			auto header = binary_battery_header{};
+			header.seed = seed;
+			header.block_size = 128;
+			auto writer = binary_battery_writer{ binary_file, header };
+			writer.write(ops);
+			writer.close();
+		}
+
+		for (const fsv_t file : { text_file, utf16_file, binary_file })
+		{
+			auto reader = battery_reader{ file };
+			auto read_back = std::vector<binary_operation>{};
+			auto block = std::vector<binary_operation>{};
+			while (reader.read(block, 100))
+			{
+				cjm_assert(block.size() <= 100, "The reader returned more records than requested."sv);
+				read_back.insert(read_back.end(), block.cbegin(), block.cend());
+			}
+			cjm_assert(read_back == ops, "The records read back differ from the ones written."sv);
+			cjm_assert(reader.records_read() == ops.size(), "The reader miscounted the records read."sv);
+			//a chunk of a few lines: most reads refill the buffer behind a partial line.
+			auto small_chunks = battery_reader{ file, 512 };
+			read_back.clear();
+			while (small_chunks.read(block, 7))
+			{
+				read_back.insert(read_back.end(), block.cbegin(), block.cend());
+			}
+			cjm_assert(read_back == ops, "The records read through a small chunk differ from the ones written."sv);
+			for (const unsigned threads : { 1u, 3u })
+			{
+				const verify_summary mapped = verify_battery(file, threads);
+				cjm_assert(mapped.passed() && mapped.records == ops.size(), "A correct mapped battery failed verification."sv);
+				const verify_summary streamed = verify_streamed_battery(file, threads);
+				cjm_assert(streamed.passed() && streamed.records == ops.size(), "A correct streamed battery failed verification."sv);
+			}
+		}
+		{
+			auto reader = battery_reader{ text_file };
+			auto block = std::vector<binary_operation>{};
+			cjm_assert(reader.read(block, 1) && reader.header().find("seed=0xd00dfea2b00bc0de") != fstr_t::npos,
+				"The reader did not capture the battery header."sv);
+		}
+		cjm_assert(battery_reader{ utf16_file }.encoding() == text_encoding::utf16le, "The UTF-16 byte order mark was not detected."sv);
+		bool too_long = false;
+		try
+		{
+			auto reader = battery_reader{ text_file, 20 };
+			auto block = std::vector<binary_operation>{};
+			while (reader.read(block, 100)) {}
+		}
+		catch (const std::invalid_argument&)
+		{
+			too_long = true;
+		}
+		cjm_assert(too_long, "A line longer than the reader's chunk was accepted."sv);
+
+		//operator<< asserts every result it writes is correct, so the incorrect battery is formatted here.
+		constexpr size_t wrong_at = 257;
+		{
+			auto stream = std::ofstream{ fstr_t{ text_file }, std::ios::binary | std::ios::trunc };
+			auto buffer = std::array<char, max_serialized_record_size>{};
+			for (size_t i = 0; i < ops.size(); ++i)
+			{
+				const binary_operation& op = ops[i];
+				const int128_t result = i == wrong_at ? op.result().value() + 1 : op.result().value();
+				const char* end = format_record(buffer.data(), op.op_code(), op.left_operand(), op.right_operand(), result);
+				stream.write(buffer.data(), end - buffer.data());
+				stream.put(newl);
+			}
+		}
+		for (const verify_summary& summary : { verify_battery(text_file, 3), verify_streamed_battery(text_file, 3) })
+		{
+			cjm_assert(summary.failures == 1 && summary.first_failures.size() == 1 && summary.first_failures[0].first == wrong_at,
+				"Verification did not report exactly the one incorrect record."sv);
+		}
+
+		{
+			auto corrupt = std::fstream{ fstr_t{ binary_file }, std::ios::in | std::ios::out | std::ios::binary };
+			constexpr auto corrupt_at = static_cast<std::streamoff>(binary_battery_header::size + 300 * binary_record_size + 7);
+			corrupt.seekg(corrupt_at);
+			const auto original = static_cast<char>(corrupt.get());
+			corrupt.seekp(corrupt_at);
+			corrupt.put(static_cast<char>(~original));
+		}
+		bool detected = false;
+		try
+		{
+			(void) verify_battery(binary_file, 3);
+		}
+		catch (const std::invalid_argument&)
+		{
+			detected = true;
+		}
+		cjm_assert(detected, "The crc combined from the slices of a mapped binary battery missed a corrupted record."sv);
+		std::remove(text_file.data());
+		std::remove(utf16_file.data());
+		std::remove(binary_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_undefined_records()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr fsv_t text_file = "undefined_records.txt";
+		constexpr fsv_t binary_file = "undefined_records.bin";
+		constexpr fsv_t compressed_file = "undefined_records.cjmz";
+		constexpr int128_t min = std::numeric_limits<int128_t>::min();
+		const auto rejects = [](const auto& read) -> bool
+		{
+			try
+			{
+				read();
+			}
+			catch (const std::invalid_argument&)
+			{
+				return true;
+			}
+			return false;
+		};
+
+		//the results are arbitrary: none of these records can be evaluated.
+		constexpr int128_t any_result = 0;
+		for (const binary_operation& undefined : { binary_operation{ binary_op::divide, int128_t{ 1 } << 120, 0, any_result },
+			binary_operation{ binary_op::modulus, min, -1, any_result }, binary_operation{ binary_op::left_shift, 1, 128, any_result },
+			binary_operation{ binary_op::right_shift, 1, -1, any_result } })
+		{
+			const auto ops = std::vector<binary_operation>{ binary_operation{ binary_op::add, 1, 2, true }, undefined };
+			auto text = std::string{};
+			auto buffer = std::array<char, max_serialized_record_size>{};
+			for (const binary_operation& op : ops)
+			{
+				const char* end = format_record(buffer.data(), op.op_code(), op.left_operand(), op.right_operand(), op.result().value());
+				text.append(buffer.data(), static_cast<size_t>(end - buffer.data()));
+				text += newl;
+			}
+			{
+				auto stream = std::ofstream{ fstr_t{ text_file }, std::ios::binary | std::ios::trunc };
+				stream << text;
+			}
+			{
+				auto writer = compressed_battery_writer{ compressed_file };
+				writer.write_text(text.data(), text.size(), text_encoding::utf8);
+				writer.close();
+			}
+			{
+				auto writer = binary_battery_writer{ binary_file, binary_battery_header{} };
+				writer.write(ops);
+				writer.close();
+			}
+			for (const fsv_t file : { text_file, binary_file, compressed_file })
+			{
+				cjm_assert(rejects([&]() { (void) verify_battery(file, 2); }), "Mapped verification accepted an undefined record."sv);
+				cjm_assert(rejects([&]() { (void) verify_streamed_battery(file, 2); }),
+					"Streamed verification accepted an undefined record."sv);
+			}
+			cjm_assert(rejects([&]() { (void) load_binary_battery(binary_file); }),
+				"load_binary_battery accepted an undefined record."sv);
+		}
+		std::remove(text_file.data());
+		std::remove(binary_file.data());
+		std::remove(compressed_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_partitioned_batch()
+{
+	try
+	{
+		using test::cjm_assert;
+		auto ops = std::vector<binary_operation>{};
+		generate_random_blocks(0xb00b'c0de'd00d'fea2, 0, 1'000, 1, [&](const std::vector<binary_operation>& block) -> void
+		{
+			ops.insert(ops.end(), block.cbegin(), block.cend());
+		});
+		const std::vector<binary_operation> edge_comparisons = edge_tests_comparison();
+		ops.insert(ops.end(), edge_comparisons.cbegin(), edge_comparisons.cend());
+
+		auto lhs = std::vector<int128_t>{};
+		auto rhs = std::vector<int128_t>{};
+		auto results = std::vector<int128_t>{};
+		for (size_t op_idx = 0; op_idx < binary_op_count; ++op_idx)
+		{
+			lhs.clear();
+			rhs.clear();
+			auto expected = std::vector<int128_t>{};
+			for (const binary_operation& op : ops)
+			{
+				if (op.op_code() != static_cast<binary_op>(op_idx))
+					continue;
+				lhs.push_back(op.left_operand());
+				rhs.push_back(op.right_operand());
+				expected.push_back(op.result().value());
+			}
+			results.assign(lhs.size(), 0);
+			evaluate_batch(static_cast<binary_op>(op_idx), lhs.data(), rhs.data(), results.data(), lhs.size());
+			cjm_assert(results == expected, "evaluate_batch disagrees with binary_operation::calculate_result."sv);
+		}
+
+		constexpr auto wrong = std::array<size_t, 3>{ 3, 512, 999 };
+		auto batch = partitioned_batch{ 100 };
+		auto failed = std::vector<std::uint64_t>{};
+		std::uint64_t failures = 0;
+		const auto on_failure = [&](std::uint64_t index, const binary_operation& op) -> void
+		{
+			cjm_assert(op == ops[index], "A failure was reported for the wrong operation."sv);
+			failed.push_back(index);
+		};
+		for (size_t i = 0; i < ops.size(); ++i)
+		{
+			const binary_operation& op = ops[i];
+			const bool corrupt = std::find(wrong.cbegin(), wrong.cend(), i) != wrong.cend();
+			batch.push_back(corrupt ? binary_operation{ op.op_code(), op.left_operand(), op.right_operand(), op.result().value() ^ 1 } : op, i);
+			if (batch.full())
+				failures += batch.verify(on_failure);
+		}
+		failures += batch.verify(on_failure);
+		cjm_assert(batch.empty(), "Verifying a batch did not empty it."sv);
+		std::sort(failed.begin(), failed.end());
+		cjm_assert(failures == wrong.size() && std::equal(failed.cbegin(), failed.cend(), wrong.cbegin(), wrong.cend()),
+			"The batch did not report exactly the incorrect results."sv);
+
+		//rows without a defined result must neither trap nor pass, whatever result they claim.
+		constexpr int128_t min = std::numeric_limits<int128_t>::min();
+		const auto undefined = std::array<binary_operation, 5>{ binary_operation{ binary_op::divide, 7, 0, int128_t{ 0 } },
+			binary_operation{ binary_op::modulus, min, -1, int128_t{ 0 } }, binary_operation{ binary_op::divide, min, -1, min },
+			binary_operation{ binary_op::left_shift, 1, 128, int128_t{ 1 } }, binary_operation{ binary_op::right_shift, -1, -5, int128_t{ -1 } } };
+		for (size_t i = 0; i < undefined.size(); ++i)
+		{
+			batch.push_back(undefined[i], i);
+			batch.push_back(ops[i], undefined.size() + i);
+		}
+		failed.clear();
+		failures = batch.verify([&](std::uint64_t index, const binary_operation&) -> void
+		{
+			failed.push_back(index);
+		});
+		std::sort(failed.begin(), failed.end());
+		cjm_assert(failures == undefined.size() && failed == std::vector<std::uint64_t>{ 0, 1, 2, 3, 4 },
+			"The batch did not report exactly the operations without a defined result."sv);
+		for (const binary_operation& op : undefined)
+		{
+			const int128_t lhs_column = op.left_operand();
+			const int128_t rhs_column = op.right_operand();
+			int128_t result = 1;
+			evaluate_batch(op.op_code(), &lhs_column, &rhs_column, &result, 1);
+			cjm_assert(result == 0, "evaluate_batch gave a result to an operation without a defined result."sv);
+		}
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_operation_table()
+{
+	try
+	{
+		using test::cjm_assert;
+		using test::cjm_deny;
+		constexpr fsv_t vector_file = "operation_table_vector.txt";
+		constexpr fsv_t table_file = "operation_table_table.txt";
+		static_assert(operation_table::bytes_per_row < sizeof(binary_operation), "The table must be denser than the vector.");
+
+		auto table = operation_table{};
+		create_random_ops(table, 500);
+		cjm_assert(table.size() == 500, "create_random_ops did not fill the table."sv);
+		cjm_deny(table.has_result(0) || table.has_result(499), "Freshly generated rows should not have results."sv);
+		table.calculate_results();
+		auto ops = table.to_vector();
+		cjm_assert(std::all_of(ops.cbegin(), ops.cend(), [](const binary_operation& op) -> bool
+			{
+				return op.has_correct_result();
+			}), "calculate_results produced an incorrect result."sv);
+
+		const std::vector<binary_operation> edge_comparisons = edge_tests_comparison();
+		ops.insert(ops.end(), edge_comparisons.cbegin(), edge_comparisons.cend());
+		ops.emplace_back(binary_op::multiply, 3, 5);
+		const auto round_trip = operation_table{ ops };
+		cjm_assert(round_trip.size() == ops.size() && !round_trip.has_result(ops.size() - 1), "Rows or result flags were lost."sv);
+		for (size_t row = 0; row < ops.size(); ++row)
+		{
+			const binary_operation op = round_trip[row];
+			cjm_assert(op == ops[row] && op.result() == ops[row].result(), "A row differs from the operation it was built from."sv);
+		}
+		cjm_assert(round_trip == operation_table{ round_trip.to_vector() }, "A table did not survive a round trip through a vector."sv);
+
+		serialize_binary_ops("Operation Table Test Battery"sv, vector_file, ops);
+		serialize_binary_ops("Operation Table Test Battery"sv, table_file, round_trip);
+		const auto read_all = [](fsv_t file_name) -> fstr_t
+		{
+			auto stream = std::ifstream{ fstr_t{ file_name }, std::ios::binary };
+			fstr_stream_t contents;
+			contents << stream.rdbuf();
+			return contents.str();
+		};
+		cjm_assert(read_all(vector_file) == read_all(table_file), "A table serializes differently from the equivalent vector."sv);
+		std::remove(vector_file.data());
+		std::remove(table_file.data());
+		cjm_assert(edge_comparison_table() == operation_table{ edge_comparisons }, "The edge comparison table differs from the vector."sv);
+
+		const auto rejects = [&](binary_op op, int128_t lhs, int128_t rhs) -> bool
+		{
+			try
+			{
+				table.push_back(op, lhs, rhs);
+			}
+			catch (const std::invalid_argument&)
+			{
+				return true;
+			}
+			return false;
+		};
+		const size_t rows = table.size();
+		cjm_assert(rejects(binary_op::divide, 1, 0) && rejects(binary_op::modulus, std::numeric_limits<int128_t>::min(), -1)
+			&& rejects(binary_op::left_shift, 1, 128) && rejects(binary_op::right_shift, 1, -1) && table.size() == rows,
+			"A table accepted an operation without a defined result."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_stratified_generation()
+{
+	try
+	{
+		using test::cjm_assert;
+		using test::cjm_deny;
+		constexpr int128_t max = std::numeric_limits<int128_t>::max();
+		constexpr int128_t min = std::numeric_limits<int128_t>::min();
+		cjm_assert(classify_operand(min) == operand_stratum::extreme && classify_operand(-1) == operand_stratum::unit,
+			"Extremes or units were misclassified."sv);
+		cjm_assert(classify_operand(-(int128_t{ 1 } << 64)) == operand_stratum::limb_boundary
+			&& classify_operand(absl::MakeInt128(5, std::numeric_limits<std::uint64_t>::max())) == operand_stratum::carry_pattern,
+			"Limb boundaries or carry patterns were misclassified."sv);
+		cjm_assert(classify_operand(0xffff'ffff) == operand_stratum::small && classify_operand(max - 5) == operand_stratum::full_width
+			&& classify_operand((int128_t{ 1 } << 100) + 3) == operand_stratum::high_limb, "Bit lengths were misclassified."sv);
+		cjm_deny(is_defined(binary_op::divide, min, -1) || is_defined(binary_op::modulus, 1, 0)
+			|| is_defined(binary_op::left_shift, 1, 128), "An undefined operation was reported as defined."sv);
+
+		constexpr std::uint64_t seed = 0x5eed'5eed'c0de'd00d;
+		constexpr size_t count = 20'000;
+		auto ops = std::vector<binary_operation>{};
+		auto stratified = operand_coverage{};
+		generate_random_blocks(seed, 0, count, 3, [&](const std::vector<binary_operation>& block) -> void
+		{
+			ops.insert(ops.end(), block.cbegin(), block.cend());
+			stratified.add(block);
+		}, 1'000, operand_distribution::stratified);
+		auto single_thread = std::vector<binary_operation>{};
+		generate_random_blocks(seed, 0, count, 1, [&](const std::vector<binary_operation>& block) -> void
+		{
+			single_thread.insert(single_thread.end(), block.cbegin(), block.cend());
+		}, 1'000, operand_distribution::stratified);
+		cjm_assert(ops == single_thread, "Stratified generation depends on the thread count."sv);
+		cjm_assert(std::all_of(ops.cbegin(), ops.cend(), [](const binary_operation& op) -> bool
+			{
+				return is_defined(op.op_code(), op.left_operand(), op.right_operand()) && op.has_correct_result();
+			}), "A stratified operation is undefined or lacks its correct result."sv);
+
+		auto uniform = operand_coverage{};
+		generate_random_blocks(seed, 0, count, 1, [&](const std::vector<binary_operation>& block) -> void
+		{
+			uniform.add(block);
+		}, 1'000);
+		for (size_t bucket = 0; bucket < operand_bucket_count; ++bucket)
+		{
+			cjm_assert(bucket == 1 || stratified.left_hits(bucket) > 0, "A stratum was never drawn."sv);
+		}
+		cjm_assert(stratified.combinations_hit() > 4 * uniform.combinations_hit() && stratified.boundary_shifts() > 4 * uniform.boundary_shifts(),
+			"Stratified operands do not cover markedly more than uniform ones."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_wide_generation()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr int128_t max_low_limb = std::numeric_limits<std::uint64_t>::max();
+		constexpr size_t count = 5'000;
+		auto gen = cjm_helper_rgen::make_rgen(0x0123'4567'89ab'cdef, operand_distribution::wide);
+		for (const binary_op op : { binary_op::divide, binary_op::modulus })
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				binary_operation operation = gen->random_operation(op);
+				operation.calculate_result();
+				const int128_t lhs = operation.left_operand();
+				const int128_t rhs = operation.right_operand();
+				cjm_assert(rhs > max_low_limb || rhs < -max_low_limb, "A wide divisor fits in 64 bits."sv);
+				const int128_t quotient = apply_op<binary_op::divide>(lhs, rhs);
+				const int128_t remainder = apply_op<binary_op::modulus>(lhs, rhs);
+				cjm_assert(quotient * rhs + remainder == lhs && (remainder == 0 || (remainder < 0) == (lhs < 0))
+					&& (remainder < 0 ? -remainder : remainder) < (rhs < 0 ? -rhs : rhs),
+					"A 128 / 128 bit quotient and remainder do not reconstruct the dividend."sv);
+				cjm_assert(operation.has_correct_result(), "A wide operation lacks its correct result."sv);
+			}
+		}
+
+		size_t truncated = 0;
+		size_t exact = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			binary_operation operation = gen->random_operation(binary_op::multiply);
+			operation.calculate_result();
+			const int128_t lhs = operation.left_operand();
+			const int128_t rhs = operation.right_operand();
+			cjm_assert(operation.has_correct_result(), "A wide product lacks its correct result."sv);
+			//the product overflowed iff dividing it by one factor does not give back the other.
+			if (operation.result().value() / rhs == lhs && (lhs != -1 || rhs != std::numeric_limits<int128_t>::min()))
+				++exact;
+			else
+				++truncated;
+			cjm_assert(apply_op<binary_op::multiply>(lhs, rhs) == apply_op<binary_op::multiply>(rhs, lhs),
+				"A truncated product is not commutative."sv);
+		}
+		cjm_assert(exact > count / 8 && truncated > count / 8, "Wide products do not straddle overflow."sv);
+
+		const auto uniform = cjm_helper_rgen::make_rgen(0x0123'4567'89ab'cdef)->random_operation(binary_op::add);
+		const auto wide = cjm_helper_rgen::make_rgen(0x0123'4567'89ab'cdef, operand_distribution::wide)->random_operation(binary_op::add);
+		cjm_assert(uniform == wide, "Wide generation changed an op other than multiply, divide or modulus."sv);
+		cjm_assert(parse_distribution("wide"sv) == operand_distribution::wide, "The wide distribution was not parsed."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_tick_conversion_battery()
+{
+	try
+	{
+		using test::cjm_assert;
+		const tick_conversion qpc = tick_conversion::for_frequency(2'441'418);
+		cjm_assert(qpc.factor == 1'220'709 && qpc.divisor == 5'000'000, "The conversion ratio was not reduced to lowest terms."sv);
+		cjm_assert(qpc.to_timespan_ticks(qpc.to_stopwatch_ticks(-7'670'048'174'861'859'330)) == -7'670'048'174'861'859'329,
+			"The round trip differs from run_mult_div_test_case_1."sv);
+		const tick_conversion nanoseconds = tick_conversion::for_frequency(1'000'000'000);
+		cjm_assert(nanoseconds.to_stopwatch_ticks(nanoseconds.max_ticks) <= std::numeric_limits<std::int64_t>::max()
+			&& nanoseconds.to_stopwatch_ticks(nanoseconds.max_ticks + 1) > std::numeric_limits<std::int64_t>::max(),
+			"max_ticks is not the largest convertible tick count."sv);
+		auto [percent_diff, diff] = calculate_percent_diff(0, -3);
+		cjm_assert(diff == 3 && percent_diff == 1.0, "A difference of mixed sign values was miscalculated."sv);
+
+		constexpr std::uint64_t seed = 0xfeed'face'dead'beef;
+		constexpr size_t count = 2 * random_op_block_size + 4'000;
+		constexpr std::uint64_t slice_first = random_op_block_size - 6;
+		const std::vector<tick_conversion> conversions = make_tick_conversions({ 10'000'000, 2'441'418, 3'579'545 });
+		const auto generate = [&](std::uint64_t first_record, size_t records, unsigned threads) -> std::vector<binary_operation>
+		{
+			auto ret = std::vector<binary_operation>{};
+			generate_blocks(first_record, records, threads, random_op_block_size,
+				[&](size_t, std::uint64_t block_idx, size_t skip, size_t length, std::vector<binary_operation>& block) -> void
+			{
+				generate_conversion_block(conversions, seed, block_idx, skip, length, block);
+			}, [&](const std::vector<binary_operation>& block) -> void
+			{
+				ret.insert(ret.end(), block.cbegin(), block.cend());
+			});
+			return ret;
+		};
+		const std::vector<binary_operation> battery = generate(0, count, 3);
+		cjm_assert(battery.size() == count && battery == generate(0, count, 1), "Conversion batteries depend on the thread count."sv);
+		const std::vector<binary_operation> slice = generate(slice_first, 100, 2);
+		cjm_assert(std::equal(slice.cbegin(), slice.cend(), battery.cbegin() + slice_first), "A regenerated slice differs."sv);
+		cjm_assert(std::all_of(battery.cbegin(), battery.cend(), [](const binary_operation& op) -> bool { return op.has_correct_result(); }),
+			"A conversion record lacks its correct result."sv);
+
+		auto stats = std::vector<round_trip_stats>(conversions.size());
+		add_round_trips(stats, 0, battery);
+		cjm_assert(stats[0].exact == stats[0].round_trips && stats[0].round_trips == count / 12,
+			"Conversions at the TimeSpan frequency must round trip exactly."sv);
+		cjm_assert(stats[1].max_difference > 0 && stats[1].max_difference <= 5 && stats[2].round_trips == count / 12,
+			"Round trip errors at 2441418 Hz are out of the expected range."sv);
+		auto slice_stats = std::vector<round_trip_stats>(conversions.size());
+		add_round_trips(slice_stats, slice_first, slice);
+		cjm_assert(slice_stats[0].round_trips + slice_stats[1].round_trips + slice_stats[2].round_trips == 24,
+			"Only round trips wholly inside a slice may be counted."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_mul_div()
+{
+	try
+	{
+		using test::cjm_assert;
+		using boost::multiprecision::int256_t;
+		constexpr int128_t max = std::numeric_limits<int128_t>::max();
+		constexpr int128_t min = std::numeric_limits<int128_t>::min();
+		cjm_assert(mul_div(-7'670'048'174'861'859'330, 1'220'709, 5'000'000) == -1'872'579'367'497'489'088,
+			"mul_div differs from run_mult_div_test_case_1."sv);
+		cjm_assert(mul_div(max, max, max) == max && mul_div(min, min, min) == min && mul_div(min, -1, -1) == min,
+			"mul_div does not hold its product exactly."sv);
+		cjm_assert(!mul_div(min, -1, 1).has_value() && !mul_div(min, 1, -1).has_value() && !mul_div(1, 1, 0).has_value()
+			&& !mul_div(max, 2, 1).has_value(), "An undefined mul_div has a result."sv);
+
+		const auto to_int256 = [](int128_t value) -> int256_t
+		{
+			return (int256_t{ static_cast<std::int64_t>(absl::Int128High64(value)) } << 64) + int256_t{ absl::Int128Low64(value) };
+		};
+		const int256_t max_256 = to_int256(max);
+		const int256_t min_256 = to_int256(min);
+		const auto check = [&](int128_t a, int128_t b, int128_t c) -> void
+		{
+			const std::optional<int128_t> result = mul_div(a, b, c);
+			if (c == 0)
+			{
+				cjm_assert(!result.has_value(), "Division by zero has a result."sv);
+				return;
+			}
+			const int256_t expected = to_int256(a) * to_int256(b) / to_int256(c);
+			const bool fits = expected >= min_256 && expected <= max_256;
+			cjm_assert(result.has_value() == fits && (!fits || to_int256(*result) == expected),
+				"mul_div differs from boost::multiprecision::int256_t."sv);
+		};
+		auto engine = std::mt19937_64{ 0xdead'beef'cafe'f00d };
+		for (int i = 0; i < 20'000; ++i)
+		{
+			const mul_div_operation op = random_mul_div_operation(engine);
+			check(op.multiplicand(), op.multiplier(), op.divisor());
+			//unconstrained operands: mostly overflowing quotients.
+			const int shift = static_cast<int>(engine() % 128);
+			check(static_cast<int128_t>(absl::MakeUint128(engine(), engine())), static_cast<int128_t>(absl::MakeUint128(engine(), engine())) >> shift,
+				static_cast<int128_t>(absl::MakeUint128(engine(), engine())));
+		}
+
+		mul_div_operation wide = random_wide_mul_div(engine);
+		wide.calculate_result();
+		auto text = std::array<tchar_t, max_serialized_mul_div_record_size>{};
+		const tchar_t* end = format_mul_div_record(text.data(), wide.multiplicand(), wide.multiplier(), wide.divisor(), wide.result().value());
+		auto parsed = mul_div_operation{};
+		cjm_assert(try_parse_mul_div_record(tsv_t{ text.data(), static_cast<size_t>(end - text.data()) }, parsed)
+			&& parsed == wide && parsed.result() == wide.result(), "A MulDiv record did not round trip."sv);
+		cjm_assert(!try_parse_mul_div_record(u"Multiply;0\t0\t;0\t0\t;0\t0\t;0\t0\t;"sv, parsed), "A Multiply record parsed as MulDiv."sv);
+
+		//a slice straddling a block boundary, so each worker seeds its own block.
+		constexpr fsv_t file_name = "mul_div_battery.txt"sv;
+		constexpr size_t count = 300;
+		constexpr std::uint64_t first_record = random_op_block_size - 150;
+		constexpr std::uint64_t seed = 0x0bad'cafe'0000'0015;
+		serialize_mul_div_ops("MulDiv Test Battery"sv, file_name, count, seed, 3, first_record);
+		const std::vector<mul_div_operation> loaded = load_mul_div_battery(file_name);
+		std::remove(file_name.data());
+		auto generated = std::vector<mul_div_operation>{};
+		generate_blocks<mul_div_operation>(first_record, count, 1, random_op_block_size,
+			[&](size_t, std::uint64_t block_idx, size_t skip, size_t length, std::vector<mul_div_operation>& block) -> void
+		{
+			generate_mul_div_block(seed, block_idx, skip, length, block);
+		}, [&](const std::vector<mul_div_operation>& block) -> void
+		{
+			generated.insert(generated.end(), block.cbegin(), block.cend());
+		});
+		cjm_assert(loaded.size() == count && loaded == generated, "The saved MulDiv battery differs from the generated one."sv);
+		cjm_assert(std::all_of(loaded.cbegin(), loaded.cend(), [](const mul_div_operation& op) -> bool { return op.has_correct_result(); }),
+			"A saved MulDiv record lacks its correct result."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_sharded_battery()
+{
+	try
+	{
+		using test::cjm_assert;
+		cjm_assert(shard_file_name("ops.txt"sv, 3) == "ops.00003.txt" && shard_file_name("dir.d/ops"sv, 12) == "dir.d/ops.00012"
+			&& manifest_file_name("ops.bin"sv) == "ops.manifest.json", "Unexpected shard or manifest file name."sv);
+		const std::vector<std::uint64_t> aligned = shard_boundaries(10, 10 * random_op_block_size, 3, random_op_block_size);
+		cjm_assert(aligned.size() == 4 && aligned.front() == 10 && aligned.back() == 10 + 10 * random_op_block_size
+			&& aligned[1] % random_op_block_size == 0 && aligned[2] % random_op_block_size == 0, "Shards do not start on block boundaries."sv);
+		const std::vector<std::uint64_t> small = shard_boundaries(0, 5, 5, random_op_block_size);
+		cjm_assert(small == std::vector<std::uint64_t>{ 0, 1, 2, 3, 4, 5 }, "Small shards are not one record each."sv);
+
+		//too few records to align the shards (checked above): the middle one straddles a block boundary.
+		constexpr size_t count = 300;
+		constexpr std::uint64_t first_record = random_op_block_size - 123;
+		constexpr std::uint64_t seed = 0x0bad'cafe'0000'0016;
+		auto generated = std::vector<binary_operation>{};
+		generate_random_blocks(seed, first_record, count, 1, [&](const std::vector<binary_operation>& block) -> void
+		{
+			generated.insert(generated.end(), block.cbegin(), block.cend());
+		});
+		for (const auto& [format, file_name] : { std::make_pair(battery_format::text, "sharded.txt"sv),
+			std::make_pair(battery_format::binary, "sharded.bin"sv) })
+		{
+			const shard_manifest manifest = write_sharded_battery("Sharded Test Battery"sv, file_name, count, seed, 3, format, 2,
+				first_record);
+			cjm_assert(manifest.shards.size() == 3 && manifest.count == count && manifest.first_record == first_record,
+				"The manifest does not describe the battery."sv);
+			auto loaded = std::vector<binary_operation>{};
+			std::uint64_t next_record = first_record;
+			for (const shard_info& shard : manifest.shards)
+			{
+				cjm_assert(shard.first_record == next_record && shard.count > 0, "The shards do not partition the battery."sv);
+				next_record += shard.count;
+				const verify_summary summary = verify_battery(shard.file_name, 1);
+				cjm_assert(summary.passed() && summary.format == format && summary.records == shard.count,
+					"A shard does not verify on its own."sv);
+				const auto file = mapped_file{ shard.file_name };
+				auto crc = crc32{};
+				crc.update(file.data(), file.size());
+				cjm_assert(file.size() == shard.bytes && crc.value() == shard.crc, "The manifest size or checksum of a shard is wrong."sv);
+				auto reader = battery_reader{ shard.file_name };
+				auto records = std::vector<binary_operation>{};
+				while (reader.read(records, battery_reader::default_chunk_size))
+				{
+					loaded.insert(loaded.end(), records.cbegin(), records.cend());
+				}
+			}
+			cjm_assert(loaded == generated, "The concatenated shards differ from the unsharded battery."sv);
+			cjm_assert(std::ifstream{ manifest_file_name(file_name) }.good(), "The manifest was not written."sv);
+			for (const shard_info& shard : manifest.shards)
+			{
+				std::remove(shard.file_name.c_str());
+			}
+			std::remove(manifest_file_name(file_name).c_str());
+		}
+
+		//windows paths and names with quotes are escaped
+		cjm_assert(json_escape("C:\\out\\\"ops\".txt\n\x01"sv) == "C:\\\\out\\\\\\\"ops\\\".txt\\n\\u0001",
+			"Unexpected json escapes."sv);
+		auto manifest = shard_manifest{ "Quoted \"Battery\""s, battery_format::text, text_encoding::utf8, seed,
+			operand_distribution::uniform, rgen_engine::mt19937_64, random_op_block_size, 0, 1,
+			{ shard_info{ "C:\\out\\ops.00000.txt"s, 0, 1, 0, 0, 10, 0 } } };
+		auto json = std::stringstream{};
+		manifest.write(json);
+		cjm_assert(json.str().find("\"battery\": \"Quoted \\\"Battery\\\"\","sv) != std::string::npos
+			&& json.str().find("\"file\": \"C:\\\\out\\\\ops.00000.txt\","sv) != std::string::npos,
+			"The manifest does not escape its strings."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_async_file_writer()
+{
+	try
+	{
+		using test::cjm_assert;
+		const auto read_file = [](fsv_t file_name) -> std::string
+		{
+			const auto file = mapped_file{ file_name };
+			return std::string{ reinterpret_cast<const char*>(file.data()), file.size() };
+		};
+
+		//buffers much smaller than the writes, so most writes span several buffers and wait on the I/O thread.
+		constexpr fsv_t pattern_file = "async_writer_pattern.bin"sv;
+		auto expected = std::string{};
+		{
+			auto writer = async_file_writer{ pattern_file, 7, 3 };
+			for (size_t i = 0; i < 1'000; ++i)
+			{
+				const auto bytes = std::string(i % 23, static_cast<char>('a' + i % 26));
+				writer.write(bytes);
+				expected += bytes;
+			}
+			writer.close();
+			cjm_assert(writer.bytes_written() == expected.size(), "The writer miscounted the bytes written."sv);
+		}
+		cjm_assert(read_file(pattern_file) == expected, "The async writer did not write its bytes in order."sv);
+
+		//write_random_ops must write exactly what the tofstrm_t it replaced wrote, across a block boundary.
+		constexpr fsv_t stream_file = "async_writer_stream.txt"sv;
+		constexpr fsv_t async_file = "async_writer_async.txt"sv;
+		constexpr size_t count = 400;
+		constexpr std::uint64_t first_record = random_op_block_size - 200;
+		constexpr std::uint64_t seed = 0x0bad'cafe'0000'0017;
+		{
+			auto stream = tofstrm_t{};
+			stream.exceptions(std::ios::badbit | std::ios::failbit);
+			stream.open(fstr_t{ stream_file });
+			stream << battery_header{ "Async Writer Test Battery"sv, name(rgen_engine::mt19937_64), seed, random_op_block_size,
+				first_record, count, operand_distribution::wide };
+			generate_random_blocks(seed, first_record, count, 3, [&](const std::vector<binary_operation>& block) -> void
+			{
+				stream << block;
+			}, random_op_block_size, operand_distribution::wide);
+		}
+		write_random_ops("Async Writer Test Battery"sv, async_file, count, seed, 3, first_record, operand_distribution::wide);
+		cjm_assert(read_file(stream_file) == read_file(async_file), "write_random_ops differs from writing through a tofstrm_t."sv);
+		std::remove(pattern_file.data());
+		std::remove(stream_file.data());
+		std::remove(async_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_text_encoding()
+{
+	try
+	{
+		using test::cjm_assert;
+		const std::string line_end = to_file_text(u"\n"sv);
+		cjm_assert(line_end == "\n" || line_end == "\r\n", "Unexpected line ending."sv);
+		auto expected_utf16 = std::string{ "\xff\xfe" "a\0" "\xe9\0" "\xac\x20"sv };
+		for (const char c : line_end)
+		{
+			expected_utf16 += c;
+			expected_utf16 += '\0';
+		}
+		cjm_assert(to_file_text(u"a\u00e9\u20ac\n"sv, text_encoding::utf16le, true) == expected_utf16
+			&& to_file_text(u"a\u00e9\u20ac\n"sv) == "a\xc3\xa9\xe2\x82\xac" + line_end, "to_file_text encoded text wrongly."sv);
+
+		constexpr fsv_t utf8_file = "encoding_utf8.txt"sv;
+		constexpr fsv_t utf16_file = "encoding_utf16.txt"sv;
+		constexpr size_t count = 300;
+		constexpr std::uint64_t seed = 0x0bad'cafe'0000'0018;
+		write_random_ops("Encoding Test Battery"sv, utf8_file, count, seed, 2, 0, operand_distribution::uniform,
+			rgen_engine::mt19937_64, text_encoding::utf8);
+		write_random_ops("Encoding Test Battery"sv, utf16_file, count, seed, 2, 0, operand_distribution::uniform,
+			rgen_engine::mt19937_64, text_encoding::utf16le);
+		cjm_assert(mapped_file{ utf16_file }.size() == 2 * mapped_file{ utf8_file }.size() + 2,
+			"A UTF-16 battery is not its UTF-8 text as UTF-16LE with a BOM."sv);
+
+		const auto read_all = [](fsv_t file_name, text_encoding encoding) -> std::vector<binary_operation>
+		{
+			auto reader = battery_reader{ file_name };
+			auto ret = std::vector<binary_operation>{};
+			auto records = std::vector<binary_operation>{};
+			while (reader.read(records, battery_reader::default_chunk_size))
+			{
+				ret.insert(ret.end(), records.cbegin(), records.cend());
+			}
+			cjm_assert(reader.encoding() == encoding, "The reader detected the wrong encoding."sv);
+			return ret;
+		};
+		const std::vector<binary_operation> utf8_ops = read_all(utf8_file, text_encoding::utf8);
+		cjm_assert(utf8_ops.size() == count && utf8_ops == read_all(utf16_file, text_encoding::utf16le),
+			"The UTF-8 and UTF-16 batteries hold different records."sv);
+		const verify_summary summary = verify_battery(utf16_file, 2);
+		cjm_assert(summary.passed() && summary.records == count, "The UTF-16 battery does not verify."sv);
+		std::remove(utf8_file.data());
+		std::remove(utf16_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_compressed_battery()
+{
+	try
+	{
+		using test::cjm_assert;
+		const auto round_trips = [](const std::vector<unsigned char>& bytes) -> bool
+		{
+			auto compressed = std::vector<unsigned char>(lz4::compress_bound(bytes.size()));
+			compressed.resize(lz4::compress(bytes.data(), bytes.size(), compressed.data()));
+			auto decompressed = std::vector<unsigned char>(bytes.size());
+			lz4::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size());
+			return decompressed == bytes;
+		};
+		auto engine = std::mt19937_64{ 0x0bad'cafe'0000'0019 };
+		auto random_bytes = std::vector<unsigned char>(100'000);
+		std::generate(random_bytes.begin(), random_bytes.end(), [&]() -> unsigned char { return static_cast<unsigned char>(engine()); });
+		auto repeats = std::vector<unsigned char>(100'000, 'a');
+		for (size_t i = 0; i < repeats.size(); i += 1'000)
+		{
+			repeats[i] = static_cast<unsigned char>('b' + i % 7);
+		}
+		cjm_assert(round_trips({}) && round_trips({ 'x' }) && round_trips(std::vector<unsigned char>(12, 'y'))
+			&& round_trips(random_bytes) && round_trips(repeats), "An LZ4 block did not round trip."sv);
+		auto compressed = std::vector<unsigned char>(lz4::compress_bound(repeats.size()));
+		compressed.resize(lz4::compress(repeats.data(), repeats.size(), compressed.data()));
+		cjm_assert(compressed.size() < repeats.size() / 20, "Repetitive bytes did not compress."sv);
+		auto decompressed = std::vector<unsigned char>(repeats.size());
+		bool threw = false;
+		try
+		{
+			lz4::decompress(compressed.data(), compressed.size() - 1, decompressed.data(), decompressed.size());
+		}
+		catch (const std::invalid_argument&)
+		{
+			threw = true;
+		}
+		cjm_assert(threw, "A truncated LZ4 block decompressed."sv);
+		auto check = crc32{};
+		constexpr auto check_text = "123456789"sv;
+		check.update(reinterpret_cast<const unsigned char*>(check_text.data()), check_text.size());
+		auto sliced = crc32{};
+		sliced.update(random_bytes.data(), 3);
+		sliced.update(random_bytes.data() + 3, random_bytes.size() - 3);
+		auto whole = crc32{};
+		whole.update(random_bytes.data(), random_bytes.size());
+		cjm_assert(check.value() == 0xcbf4'3926 && sliced.value() == whole.value(), "Unexpected crc32."sv);
+
+		constexpr fsv_t raw_file = "compressed_battery.txt"sv;
+		constexpr fsv_t compressed_file = "compressed_battery.cjmz"sv;
+		//the header and each of the two blocks the slice straddles get their own frames.
+		constexpr size_t count = 300;
+		constexpr std::uint64_t first_record = random_op_block_size - 150;
+		constexpr std::uint64_t seed = 0x0bad'cafe'0001'0019;
+		write_random_ops("Compressed Test Battery"sv, raw_file, count, seed, 2, first_record, operand_distribution::uniform);
+		write_compressed_random_ops("Compressed Test Battery"sv, compressed_file, count, seed, 2, first_record,
+			operand_distribution::uniform);
+		{
+			const auto raw = mapped_file{ raw_file };
+			auto stream = compressed_stream{ compressed_file };
+			const compressed_battery& battery = stream.battery();
+			cjm_assert(battery.frame_count() > 2 && battery.size() == raw.size(), "Unexpected frames of the compressed battery."sv);
+			auto text = std::vector<unsigned char>(raw.size() + 1);
+			cjm_assert(stream.read(text.data(), text.size()) == raw.size() && std::equal(raw.data(), raw.data() + raw.size(), text.cbegin()),
+				"The compressed battery does not decompress to the text battery."sv);
+			const std::uint64_t position = battery.frame_position(2) + 5;
+			stream.seek(position);
+			cjm_assert(stream.read(text.data(), 1'000) == 1'000 && std::equal(text.cbegin(), text.cbegin() + 1'000, raw.data() + position),
+				"Seeking into the compressed battery read the wrong bytes."sv);
+			for (size_t frame = 1; frame < battery.frame_count(); ++frame)
+			{
+				cjm_assert(raw.data()[battery.frame_position(frame) - 1] == '\n', "A frame does not start at the start of a line."sv);
+			}
+			//frames cut within a block end at line ends too.
+			auto small_frames = compressed_frames{};
+			compress_text(reinterpret_cast<const char*>(raw.data()), raw.size(), text_encoding::utf8, 1'000, small_frames);
+			size_t framed = 0;
+			for (const compressed_frame& frame : small_frames.frames)
+			{
+				framed += frame.size;
+				cjm_assert(frame.size <= 1'000 && raw.data()[framed - 1] == '\n', "A small frame does not end at a line end."sv);
+			}
+			cjm_assert(small_frames.frames.size() > 10 && framed == raw.size(), "The text was not cut into small frames."sv);
+		}
+
+		auto loaded = std::vector<binary_operation>{};
+		bool has_header = false;
+		{
+			auto reader = battery_reader{ compressed_file };
+			auto records = std::vector<binary_operation>{};
+			while (reader.read(records, 100))
+			{
+				loaded.insert(loaded.end(), records.cbegin(), records.cend());
+			}
+			has_header = !reader.header().empty();
+		}
+		auto generated = std::vector<binary_operation>{};
+		generate_random_blocks(seed, first_record, count, 1, [&](const std::vector<binary_operation>& block) -> void
+		{
+			generated.insert(generated.end(), block.cbegin(), block.cend());
+		});
+		cjm_assert(loaded == generated && has_header, "Streaming the compressed battery read different records."sv);
+		const verify_summary summary = verify_battery(compressed_file, 3);
+		cjm_assert(summary.passed() && summary.records == count, "The compressed battery does not verify."sv);
+		std::remove(raw_file.data());
+		std::remove(compressed_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_differential_backends()
+{
+	using test::cjm_assert;
+	using test::cjm_deny;
+	constexpr auto min = std::numeric_limits<int128_t>::min();
+	constexpr auto max = std::numeric_limits<int128_t>::max();
+	const auto values = std::array<int128_t, 16>{ min, min + 1, max, max - 1, int128_t{ std::numeric_limits<std::int64_t>::min() },
+		int128_t{ std::numeric_limits<std::int64_t>::max() }, int128_t{ std::numeric_limits<std::uint64_t>::max() },
+		-int128_t{ std::numeric_limits<std::uint64_t>::max() }, 0, 1, -1, 2, -2, 63, 64, 127 };
+	cjm_assert(is_available(int128_backend::abseil) && is_available(int128_backend::boost_multiprecision),
+		"The abseil and boost backends are always available."sv);
+	for (size_t op_idx = 0; op_idx < binary_op_count; ++op_idx)
+	{
+		const auto op = static_cast<binary_op>(op_idx);
+		for (const int128_t lhs : values)
+		{
+			for (const int128_t rhs : values)
+			{
+				if (!is_defined(op, lhs, rhs))
+				{
+					cjm_deny(evaluate(int128_backend::abseil, op, lhs, rhs).has_value(), "An undefined operation was evaluated."sv);
+					continue;
+				}
+				const auto expected = binary_operation{ op, lhs, rhs, true };
+				for (size_t backend_idx = 0; backend_idx < int128_backend_count; ++backend_idx)
+				{
+					const auto backend = static_cast<int128_backend>(backend_idx);
+					const std::optional<int128_t> result = evaluate(backend, op, lhs, rhs);
+					cjm_assert(result.has_value() == is_available(backend) && (!result.has_value() || result == expected.result()),
+						"A backend disagrees with absl::int128 on an edge value."sv);
+				}
+			}
+		}
+	}
+
+	for (const operand_distribution distribution : { operand_distribution::uniform, operand_distribution::wide })
+	{
+		const differential_summary summary = run_differential(random_op_block_size + 77, 0x0bad'cafe'0000'0020, 2, 5, distribution);
+		cjm_assert(summary.passed() && summary.records == random_op_block_size + 77 && summary.first_disagreements.empty(),
+			"A backend disagrees with absl::int128 on a random battery."sv);
+		for (const backend_timing& timing : summary.timings)
+		{
+			cjm_assert(timing.operations == (timing.available ? summary.records : 0) && timing.disagreements == 0,
+				"Every available backend must evaluate every record."sv);
+		}
+		cjm_assert(summary.timings[static_cast<size_t>(summary.fastest())].available, "The fastest backend must be available."sv);
+	}
+}
+
+void cjm::tests::test_edge_cross_product()
+{
+	try
+	{
+		using test::cjm_assert;
+		const std::vector<int128_t> defaults = make_edge_values(edge_value_set{});
+		cjm_assert(defaults.size() == 760 &&  std::is_sorted(defaults.cbegin(), defaults.cend())
+			&& std::binary_search(defaults.cbegin(), defaults.cend(), int128_t{ std::numeric_limits<std::int64_t>::max() - 1 })
+			&& std::binary_search(defaults.cbegin(), defaults.cend(), -((int128_t{ 1 } << 100) + 1)),
+			"Unexpected default edge values."sv);
+
+		//the boundaries alone: 11 values, 1,331 slots.
+		auto set = edge_value_set{};
+		set.powers_of_two = false;
+		set.neighbours = 0;
+		const auto edges = edge_cross_product{ make_edge_values(set) };
+		cjm_assert(edges.values().size() == edge_comparison_value_count, "Unexpected boundary edge values."sv);
+		//every pair of every op, by brute force, in slot order
+		auto shift_amounts = std::set<int128_t>{};
+		for (const int128_t value : edges.values())
+		{
+			shift_amounts.insert(std::clamp(value, int128_t{ 0 }, int128_t{ 127 }));
+		}
+		auto expected = std::vector<binary_operation>{};
+		for (size_t op_idx = 0; op_idx < binary_op_count; ++op_idx)
+		{
+			const auto op = static_cast<binary_op>(op_idx);
+			const bool is_shift = op == binary_op::left_shift || op == binary_op::right_shift;
+			const auto right_operands = is_shift ? std::vector<int128_t>{ shift_amounts.cbegin(), shift_amounts.cend() } : edges.values();
+			cjm_assert(right_operands == edges.right_operands(op) || op == binary_op::divide || op == binary_op::modulus,
+				"Unexpected right operands of the edge cross product."sv);
+			for (const int128_t lhs : edges.values())
+			{
+				for (const int128_t rhs : right_operands)
+				{
+					if (is_defined(op, lhs, rhs))
+						expected.emplace_back(op, lhs, rhs, true);
+				}
+			}
+		}
+		cjm_assert(edges.size() == expected.size() && edges.slot_count() == expected.size() + 2,
+			"Unexpected size of the edge cross product."sv);
+
+		auto filled = std::vector<binary_operation>{};
+		edges.fill(0, static_cast<size_t>(edges.slot_count()), filled);
+		cjm_assert(filled == expected, "The edge cross product differs from the brute force cross product."sv);
+		auto slice = std::vector<binary_operation>{};
+		const std::uint64_t first_slot = edges.slot_count() / 3;
+		edges.fill(first_slot, 500, slice);
+		cjm_assert(slice.size() == edges.size(first_slot, 500)
+			&& std::equal(slice.cbegin(), slice.cend(), filled.cbegin() + static_cast<std::ptrdiff_t>(edges.size(0, static_cast<size_t>(first_slot)))),
+			"A slice of the edge cross product differs from the whole."sv);
+
+		constexpr fsv_t text_file = "edge_battery.txt"sv;
+		constexpr fsv_t binary_file = "edge_battery.bin"sv;
+		const auto all = static_cast<size_t>(edges.slot_count());
+		cjm_assert(write_edge_ops("Edge Test Battery"sv, text_file, edges, 0, all + 10, battery_format::text, 3,
+			text_encoding::utf16le) == expected.size()
+			&& write_edge_ops("Edge Test Battery"sv, binary_file, edges, 0, all, battery_format::binary, 3) == expected.size(),
+			"Unexpected number of edge records written."sv);
+		for (const fsv_t file : { text_file, binary_file })
+		{
+			auto loaded = std::vector<binary_operation>{};
+			auto reader = battery_reader{ file };
+			auto records = std::vector<binary_operation>{};
+			while (reader.read(records, 500))
+			{
+				loaded.insert(loaded.end(), records.cbegin(), records.cend());
+			}
+			cjm_assert(loaded == expected, "The edge battery does not hold the edge cross product."sv);
+			cjm_assert(verify_battery(file, 2).passed(), "The edge battery does not verify."sv);
+		}
+		std::remove(text_file.data());
+		std::remove(binary_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_generation_monitor()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr fsv_t plain_file = "monitor_plain.txt"sv;
+		constexpr fsv_t monitored_file = "monitor_monitored.txt"sv;
+		constexpr fsv_t binary_file = "monitor_monitored.bin"sv;
+		//straddles a block boundary so a progress line is written before the last block completes.
+		constexpr size_t count = 300;
+		constexpr std::uint64_t first_record = random_op_block_size - 100;
+		constexpr std::uint64_t seed = 0x0bad'cafe'0000'0022;
+		write_random_ops("Monitor Test Battery"sv, plain_file, count, seed, 2, first_record, operand_distribution::uniform);
+		//the skipped records of the first block count as drawn
+		auto progress = std::stringstream{};
+		auto monitor = generation_monitor{ count, &progress, std::chrono::nanoseconds{ 1 } };
+		write_random_ops("Monitor Test Battery"sv, monitored_file, count, seed, 2, first_record, operand_distribution::uniform,
+			rgen_engine::mt19937_64, text_encoding::utf8, &monitor);
+		size_t monitored_size = 0;
+		{
+			const auto plain = mapped_file{ plain_file };
+			const auto monitored = mapped_file{ monitored_file };
+			cjm_assert(plain.size() == monitored.size() && std::equal(plain.data(), plain.data() + plain.size(), monitored.data()),
+				"Monitoring changed the battery written."sv);
+			monitored_size = monitored.size();
+		}
+		cjm_assert(monitor.records() == count && monitor.stage_items(generation_stage::draw) == count + first_record
+			&& monitor.stage_items(generation_stage::calculate) == count && monitor.stage_items(generation_stage::format) == count
+			&& monitor.stage_items(generation_stage::io_wait) == monitored_size
+			&& monitor.stage_seconds(generation_stage::draw) > 0.0 && monitor.eta_seconds() == 0.0,
+			"Unexpected stage counters of a text battery."sv);
+		cjm_assert(progress.str().find("Progress: "sv) != std::string::npos && progress.str().find("ETA "sv) != std::string::npos,
+			"No progress lines were written."sv);
+
+		auto summary = std::stringstream{};
+		monitor.print_json(summary, "Monitor \"Test\" Battery"sv, "C:\\out\\monitor.txt"sv, 2);
+		cjm_assert(summary.str().find("\"records\": " + std::to_string(count) + ",") != std::string::npos
+			&& summary.str().find("\"name\": \"io_wait\""sv) != std::string::npos, "Unexpected generation summary."sv);
+		cjm_assert(summary.str().find("\"battery\": \"Monitor \\\"Test\\\" Battery\","sv) != std::string::npos
+			&& summary.str().find("\"file\": \"C:\\\\out\\\\monitor.txt\","sv) != std::string::npos,
+			"The generation summary does not escape its strings."sv);
+
+		auto binary_monitor = generation_monitor{ count };
+		write_random_ops_binary(binary_file, count, seed, 3, first_record, operand_distribution::uniform,
+			rgen_engine::mt19937_64, &binary_monitor);
+		cjm_assert(binary_monitor.records() == count && binary_monitor.stage_items(generation_stage::draw) == count + first_record
+			&& binary_monitor.stage_items(generation_stage::format) == 0
+			&& binary_monitor.stage_items(generation_stage::io_wait) == count * binary_record_size,
+			"Unexpected stage counters of a binary battery."sv);
+		std::remove(plain_file.data());
+		std::remove(monitored_file.data());
+		std::remove(binary_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_thread_rgen()
+{
+	try
+	{
+		using test::cjm_assert;
+		constexpr size_t thread_count = 4;
+		constexpr size_t count = 1'000;
+		struct thread_draws
+		{
+			const cjm_helper_rgen* rgen = nullptr;
+			std::uint64_t seed = 0;
+			bool same_rgen = false;
+			std::vector<binary_operation> ops;
+		};
+		auto draws = std::vector<thread_draws>(thread_count);
+		auto threads = std::vector<std::thread>{};
+		for (size_t i = 0; i < thread_count; ++i)
+		{
+			threads.emplace_back([&draws, i]() -> void
+			{
+				thread_draws& mine = draws[i];
+				mine.rgen = &thread_rgen();
+				mine.seed = thread_rgen().seed();
+				mine.ops = create_random_ops(count);
+				mine.same_rgen = &thread_rgen() == mine.rgen;
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		auto seeds = std::set<std::uint64_t>{ thread_rgen().seed() };
+		for (const thread_draws& mine : draws)
+		{
+			cjm_assert(mine.same_rgen && mine.rgen != &thread_rgen(), "A thread did not keep its own generator."sv);
+			cjm_assert(seeds.insert(mine.seed).second, "Two threads' generators share a seed."sv);
+			//each seed is derived from the base seed and the order the threads first asked for a generator in
+			size_t stream = 0;
+			while (stream < 1'024 && derive_block_seed(thread_rgen_base_seed(), stream) != mine.seed)
+				++stream;
+			cjm_assert(stream < 1'024, "A thread's seed was not derived from the base seed."sv);
+			//a fresh generator with the same seed reproduces the thread's draws
+			auto gen = cjm_helper_rgen::make_rgen(mine.seed);
+			for (const binary_operation& op : mine.ops)
+			{
+				cjm_assert(gen->random_operation() == op, "A thread's operations do not match its seed."sv);
+			}
+		}
+		cjm_assert(draws[0].ops != draws[1].ops, "Two threads drew the same operations."sv);
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
+
+void cjm::tests::test_xoshiro_engine()
+{
+	try
+	{
+		using test::cjm_assert;
+		//the reference implementation's outputs, seeded by splitmix64 from 0x0123456789abcdef
+		auto engine = xoshiro256ss{ 0x0123'4567'89ab'cdef };
+		cjm_assert(engine() == 0xa2c2'a420'38d4'ec3d && engine() == 0x05fc'25d0'738e'7b0f,
+			"xoshiro256** does not match the reference implementation."sv);
+		engine.seed(0x0123'4567'89ab'cdef);
+		engine.jump();
+		cjm_assert(engine() == 0xa6c7'c7bc'2f6f'5f50, "xoshiro256**'s jump does not match the reference implementation."sv);
+		cjm_assert(xoshiro256ss::jump_polynomials()[0] == xoshiro256ss::jump_polynomial{ 0x180e'c6d3'3cfd'0aba,
+			0xd5a6'1266'f0c9'392c, 0xa958'2618'e03f'c9aa, 0x39ab'dc45'29b1'661c }, "The derived jump polynomial is not jump's."sv);
+		for (const std::uint64_t count : { 2u, 3u, 6u })
+		{
+			auto stepped = xoshiro256ss{ 0x0123'4567'89ab'cdef };
+			for (std::uint64_t i = 0; i < count; ++i)
+			{
+				stepped.jump();
+			}
+			engine.seed(0x0123'4567'89ab'cdef);
+			engine.jump(count);
+			cjm_assert(engine == stepped, "jump(count) is not count jumps."sv);
+		}
+
+		//2^64 mod 3 == 1: an output of zero is rejected, 2^63 * 3 has a high half of one.
+		struct scripted_engine
+		{
+			using result_type = std::uint64_t;
+			static constexpr result_type min() noexcept { return 0; }
+			static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+			std::array<std::uint64_t, 2> outputs;
+			size_t next;
+			result_type operator()() noexcept { return outputs[next++]; }
+		};
+		auto scripted = scripted_engine{ { 0, std::uint64_t{ 1 } << 63 }, 0 };
+		cjm_assert(bounded_uniform(scripted, 3) == 1 && scripted.next == 2, "bounded_uniform did not reject a biased product."sv);
+		auto counts = std::array<size_t, 6>{};
+		engine.seed(0x0bad'cafe'0000'0025);
+		for (size_t i = 0; i < 60'000; ++i)
+		{
+			const std::uint64_t value = bounded_uniform(engine, counts.size());
+			cjm_assert(value < counts.size(), "bounded_uniform returned a value out of range."sv);
+			++counts[static_cast<size_t>(value)];
+		}
+		cjm_assert(std::all_of(counts.cbegin(), counts.cend(), [](size_t c) -> bool { return c > 9'500 && c < 10'500; }),
+			"bounded_uniform is not uniform."sv);
+
+		cjm_assert(parse_engine("xoshiro256**"sv) == rgen_engine::xoshiro256ss && parse_engine("xoshiro256ss"sv) == rgen_engine::xoshiro256ss
+			&& parse_engine(name(rgen_engine::mt19937_64)) == rgen_engine::mt19937_64 && !parse_engine("pcg64"sv).has_value(),
+			"Unexpected engine names."sv);
+
+		//block k of a battery is its seed's stream jumped k times, sought forwards or backwards: op codes are drawn
+		//with bounded_uniform.
+		constexpr std::uint64_t seed = 0x0bad'cafe'0000'0025;
+		auto gen = cjm_helper_rgen::make_rgen(seed, operand_distribution::uniform, rgen_engine::xoshiro256ss);
+		for (const std::uint64_t block_idx : { 3u, 5u, 1u, 5u, 0u })
+		{
+			gen->seek_block(seed, block_idx);
+			auto jumped = xoshiro256ss{ seed };
+			for (std::uint64_t i = 0; i < block_idx; ++i)
+			{
+				jumped.jump();
+			}
+			for (int i = 0; i < 16; ++i)
+			{
+				cjm_assert(gen->random_binary_op() == static_cast<binary_op>(bounded_uniform(jumped, binary_op_count)),
+					"seek_block did not jump to the block's stream."sv);
+			}
+		}
+
+		//a block beyond 2^32 is reached in at most 64 jumps, not one jump per block
+		constexpr std::uint64_t far_block = (std::uint64_t{ 1 } << 33) + 5;
+		const auto seek_start = std::chrono::steady_clock::now();
+		auto far = std::vector<binary_operation>{};
+		generate_random_blocks(seed, far_block * random_op_block_size + 3, 10, 2, [&](const std::vector<binary_operation>& block) -> void
+		{
+			far.insert(far.end(), block.cbegin(), block.cend());
+		}, random_op_block_size, operand_distribution::uniform, rgen_engine::xoshiro256ss);
+		cjm_assert(std::chrono::steady_clock::now() - seek_start < std::chrono::seconds{ 1 },
+			"Seeking a distant block took time linear in its index."sv);
+		gen->seek_block(seed, far_block);
+		for (int i = 0; i < 3; ++i)
+		{
+			(void) gen->random_operation();
+		}
+		cjm_assert(far.size() == 10 && std::all_of(far.cbegin(), far.cend(), [&](const binary_operation& op) -> bool
+		{
+			return op == gen->random_operation();
+		}), "A distant slice of a xoshiro256** battery differs from its block's stream."sv);
+		auto composed = xoshiro256ss{ seed };
+		composed.jump(std::uint64_t{ 1 } << 33);
+		composed.jump(5);
+		auto direct = xoshiro256ss{ seed };
+		direct.jump(far_block);
+		cjm_assert(composed == direct, "Jumps by a block index do not compose."sv);
+
+		//batteries: the same records for any thread count or slice (here straddling a block boundary), the engine in every
+		//header and portable records
+		constexpr size_t count = 300;
+		constexpr std::uint64_t first_record = random_op_block_size - 150;
+		constexpr size_t slice_skip = 100;
+		auto whole = std::vector<binary_operation>{};
+		generate_random_blocks(seed, first_record, count, 1, [&](const std::vector<binary_operation>& block) -> void
+		{
+			whole.insert(whole.end(), block.cbegin(), block.cend());
+		}, random_op_block_size, operand_distribution::wide, rgen_engine::xoshiro256ss);
+		auto slice = std::vector<binary_operation>{};
+		generate_random_blocks(seed, first_record + slice_skip, count - slice_skip, 3, [&](const std::vector<binary_operation>& block) -> void
+		{
+			slice.insert(slice.end(), block.cbegin(), block.cend());
+		}, random_op_block_size, operand_distribution::wide, rgen_engine::xoshiro256ss);
+		cjm_assert(whole.size() == count && std::equal(slice.cbegin(), slice.cend(), whole.cbegin() + slice_skip, whole.cend()),
+			"A slice of a xoshiro256** battery differs from the whole battery."sv);
+		cjm_assert(std::all_of(whole.cbegin(), whole.cend(), [](const binary_operation& op) -> bool { return op.has_correct_result(); }),
+			"A xoshiro256** battery has an incorrect result."sv);
+		const auto first_records = [seed](rgen_engine engine) -> std::vector<binary_operation>
+		{
+			auto ret = std::vector<binary_operation>{};
+			generate_random_blocks(seed, 0, 3, 1, [&](const std::vector<binary_operation>& block) -> void
+			{
+				ret = block;
+			}, random_op_block_size, operand_distribution::wide, engine);
+			return ret;
+		};
+		const std::vector<binary_operation> xoshiro_first = first_records(rgen_engine::xoshiro256ss);
+		cjm_assert(first_records(rgen_engine::mt19937_64).front() != xoshiro_first.front(), "The engines drew the same operation."sv);
+		//the seed's first records, the same on every toolchain
+		const auto golden = std::array<binary_operation, 3>{
+			binary_operation{ binary_op::left_shift, absl::MakeInt128(0, 0x62f3'02b4'a9cb'e637), 0x47 },
+			binary_operation{ binary_op::left_shift, absl::MakeInt128(-1, 0x974b'1a3f'19ed'f65a), 0 },
+			binary_operation{ binary_op::compare, absl::MakeInt128(static_cast<std::int64_t>(0xa9dc'1c81'a18f'a52a), 0x8465'5a73'e26d'cb4d),
+				absl::MakeInt128(0x700b'834e'acd2'38f7, 0x1404'7016'b7c9'c0c0) } };
+		cjm_assert(xoshiro_first.size() == golden.size() && std::equal(golden.cbegin(), golden.cend(), xoshiro_first.cbegin()),
+			"A xoshiro256** battery is not the one its seed names."sv);
+
+		constexpr fsv_t text_file = "xoshiro_ops.txt"sv;
+		constexpr fsv_t binary_file = "xoshiro_ops.bin"sv;
+		write_random_ops("Xoshiro Test Battery"sv, text_file, count, seed, 2, first_record, operand_distribution::wide,
+			rgen_engine::xoshiro256ss);
+		write_random_ops_binary(binary_file, count, seed, 2, first_record, operand_distribution::wide, rgen_engine::xoshiro256ss);
+		for (const fsv_t file : { text_file, binary_file })
+		{
+			auto reader = battery_reader{ file };
+			auto read = std::vector<binary_operation>{};
+			cjm_assert(reader.read(read, count + 1) && read == whole, "A xoshiro256** battery file has the wrong records."sv);
+			cjm_assert(file == binary_file || reader.header().find("engine=xoshiro256**;"sv) != fstr_t::npos,
+				"The text header does not name the engine."sv);
+		}
+		{
+			const auto binary = mapped_file{ binary_file };
+			const binary_battery_header header = binary_battery_header::read_from(binary.data());
+			cjm_assert(fsv_t{ header.engine_name.data(), name(rgen_engine::xoshiro256ss).size() } == name(rgen_engine::xoshiro256ss),
+				"The binary header does not name the engine."sv);
+		}
+		std::remove(text_file.data());
+		std::remove(binary_file.data());
+	}
+	catch (const test::cjm_test_fail&)
+	{
+		throw;
+	}
+	catch (const std::exception& ex)
+	{
+		throw test::cjm_test_fail{ fstr_t{ex.what()} };
+	}
+}
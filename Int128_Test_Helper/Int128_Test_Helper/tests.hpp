@@ -79,5 +79,28 @@ namespace cjm::tests
 	void test_serialize_all_tc1_bin_op();
 	void execute_test_case_one();
 	void test_edge_case_comparisons();
+	void test_random_op_chunk_reuse();
+	void test_parallel_generation_deterministic();
+	void test_battery_slice_regeneration();
+	void test_binary_battery_round_trip();
+	void test_hex_formatter();
+	void test_hex_parser();
+	void test_battery_reader();
+	void test_undefined_records();
+	void test_partitioned_batch();
+	void test_operation_table();
+	void test_stratified_generation();
+	void test_wide_generation();
+	void test_tick_conversion_battery();
+	void test_mul_div();
+	void test_sharded_battery();
+	void test_async_file_writer();
+	void test_text_encoding();
+	void test_compressed_battery();
+	void test_differential_backends();
+	void test_edge_cross_product();
+	void test_generation_monitor();
+	void test_thread_rgen();
+	void test_xoshiro_engine();
 }
 #endif // CJM_TESTS_HPP_
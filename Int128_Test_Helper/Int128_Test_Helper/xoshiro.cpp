@@ -0,0 +1,125 @@
+#include "xoshiro.hpp"
+#include <bitset>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	constexpr size_t state_bits = 256;
+	using wide_polynomial = std::bitset<2 * state_bits>;
+
+	cjm::xoshiro256ss::jump_polynomial to_jump_polynomial(const wide_polynomial& polynomial)
+	{
+		auto ret = cjm::xoshiro256ss::jump_polynomial{};
+		for (size_t bit = 0; bit < state_bits; ++bit)
+		{
+			if (polynomial.test(bit))
+				ret[bit / 64] |= std::uint64_t{ 1 } << (bit % 64);
+		}
+		return ret;
+	}
+
+	//Berlekamp-Massey over GF(2): the minimal polynomial of bits (coefficient i at bit i, degree at most state_bits).
+	wide_polynomial minimal_polynomial(const std::vector<std::uint8_t>& bits)
+	{
+		auto connection = std::vector<std::uint8_t>(bits.size() + 1);
+		auto previous = std::vector<std::uint8_t>(bits.size() + 1);
+		connection[0] = previous[0] = 1;
+		size_t length = 0;
+		size_t gap = 1;
+		for (size_t n = 0; n < bits.size(); ++n)
+		{
+			std::uint8_t discrepancy = bits[n];
+			for (size_t i = 1; i <= length; ++i)
+			{
+				discrepancy ^= connection[i] & bits[n - i];
+			}
+			if (discrepancy == 0)
+			{
+				++gap;
+				continue;
+			}
+			const std::vector<std::uint8_t> before = connection;
+			for (size_t i = 0; i + gap < connection.size(); ++i)
+			{
+				connection[i + gap] ^= previous[i];
+			}
+			if (2 * length <= n)
+			{
+				length = n + 1 - length;
+				previous = before;
+				gap = 1;
+			}
+			else
+			{
+				++gap;
+			}
+		}
+		if (length != state_bits)
+			throw std::logic_error{ "The xoshiro256** state sequence does not have a degree 256 minimal polynomial." };
+		//the characteristic polynomial is the connection polynomial reversed
+		auto ret = wide_polynomial{};
+		for (size_t i = 0; i <= length; ++i)
+		{
+			if (connection[length - i] != 0)
+				ret.set(i);
+		}
+		return ret;
+	}
+
+	wide_polynomial square_mod(const wide_polynomial& polynomial, const wide_polynomial& modulus)
+	{
+		auto ret = wide_polynomial{};
+		for (size_t bit = 0; bit < state_bits; ++bit)
+		{
+			if (polynomial.test(bit))
+				ret.set(2 * bit);
+		}
+		for (size_t bit = 2 * state_bits - 1; bit >= state_bits; --bit)
+		{
+			if (ret.test(bit))
+				ret ^= modulus << (bit - state_bits);
+		}
+		return ret;
+	}
+}
+
+void cjm::xoshiro256ss::jump(std::uint64_t count)
+{
+	const std::array<jump_polynomial, 64>& polynomials = jump_polynomials();
+	for (size_t i = 0; i < polynomials.size() && count != 0; ++i, count >>= 1)
+	{
+		if ((count & 1u) != 0)
+			jump_by(polynomials[i]);
+	}
+}
+
+const std::array<cjm::xoshiro256ss::jump_polynomial, 64>& cjm::xoshiro256ss::jump_polynomials()
+{
+	static const std::array<jump_polynomial, 64> s_polynomials = []() -> std::array<jump_polynomial, 64>
+	{
+		//the low bit of the first state word is a linear function of the state: its sequence has the transition's
+		//characteristic polynomial as its minimal polynomial.
+		auto engine = xoshiro256ss{ 1 };
+		auto bits = std::vector<std::uint8_t>(2 * state_bits);
+		for (std::uint8_t& bit : bits)
+		{
+			bit = static_cast<std::uint8_t>(engine.m_state[0] & 1u);
+			(void) engine();
+		}
+		const wide_polynomial modulus = minimal_polynomial(bits);
+		auto power = wide_polynomial{}.set(1); //x^(2^0)
+		for (size_t i = 0; i < 128; ++i)
+		{
+			power = square_mod(power, modulus);
+		}
+		auto ret = std::array<jump_polynomial, 64>{};
+		for (jump_polynomial& polynomial : ret)
+		{
+			polynomial = to_jump_polynomial(power);
+			power = square_mod(power, modulus);
+		}
+		return ret;
+	}();
+	return s_polynomials;
+}
@@ -0,0 +1,140 @@
+#ifndef CJM_XOSHIRO_HPP_
+#define CJM_XOSHIRO_HPP_
+#include <absl/numeric/int128.h>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+namespace cjm
+{
+	class xoshiro256ss;
+
+	//splitmix64: advances state and returns its next output.  Expands a 64 bit seed into xoshiro256**'s state.
+	constexpr std::uint64_t splitmix64_next(std::uint64_t& state) noexcept;
+
+	//A value uniformly distributed in [0, range) (range > 0) made from engine's 64 bit outputs by Lemire's multiply
+	//and reject method.  It is unbiased and seldom divides.  Unlike std::uniform_int_distribution its result is fixed
+	//by the outputs, so a seed yields the same values on every standard library.
+	template<typename TEngine>
+	std::uint64_t bounded_uniform(TEngine& engine, std::uint64_t range);
+
+	//xoshiro256** 1.0 (Blackman and Vigna).  It has 256 bits of state and a period of 2^256 - 1.  jump and long_jump
+	//advance the state by 2^128 and 2^192 outputs in 256 steps, so streams a jump apart never overlap.  jump(count)
+	//advances by count * 2^128 in at most 64 such steps.  Satisfies UniformRandomBitGenerator.
+	class xoshiro256ss final
+	{
+	public:
+		using result_type = std::uint64_t;
+		static constexpr result_type min() noexcept { return 0; }
+		static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+		constexpr explicit xoshiro256ss(std::uint64_t seed = 0) noexcept : m_state{} { this->seed(seed); }
+
+		//the state is four successive splitmix64 outputs from seed.
+		constexpr void seed(std::uint64_t seed) noexcept
+		{
+			for (std::uint64_t& word : m_state)
+			{
+				word = splitmix64_next(seed);
+			}
+		}
+
+		constexpr result_type operator()() noexcept
+		{
+			const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+			const std::uint64_t t = m_state[1] << 17;
+			m_state[2] ^= m_state[0];
+			m_state[3] ^= m_state[1];
+			m_state[1] ^= m_state[2];
+			m_state[0] ^= m_state[3];
+			m_state[2] ^= t;
+			m_state[3] = rotl(m_state[3], 45);
+			return result;
+		}
+
+		using jump_polynomial = std::array<std::uint64_t, 4>;
+
+		constexpr void jump() noexcept
+		{
+			jump_by({ 0x180e'c6d3'3cfd'0aba, 0xd5a6'1266'f0c9'392c, 0xa958'2618'e03f'c9aa, 0x39ab'dc45'29b1'661c });
+		}
+
+		constexpr void long_jump() noexcept
+		{
+			jump_by({ 0x76e1'5d3e'fefd'cbbf, 0xc500'4e44'1c52'2fb3, 0x7771'0069'854e'e241, 0x3910'9bb0'2acb'e635 });
+		}
+
+		//count jumps: one jump by jump_polynomials()[i] for each bit i set in count.
+		void jump(std::uint64_t count);
+
+		//x^(2^(128 + i)) mod the characteristic polynomial for i in [0, 64): jumps by 2^(128 + i) outputs.  Derived
+		//(on first use) from the state's own sequence, so jump_polynomials()[0] is jump's polynomial.
+		static const std::array<jump_polynomial, 64>& jump_polynomials();
+
+		friend constexpr bool operator==(const xoshiro256ss& lhs, const xoshiro256ss& rhs) noexcept
+		{
+			return lhs.m_state[0] == rhs.m_state[0] && lhs.m_state[1] == rhs.m_state[1]
+				&& lhs.m_state[2] == rhs.m_state[2] && lhs.m_state[3] == rhs.m_state[3];
+		}
+		friend constexpr bool operator!=(const xoshiro256ss& lhs, const xoshiro256ss& rhs) noexcept { return !(lhs == rhs); }
+
+	private:
+		static constexpr std::uint64_t rotl(std::uint64_t x, int k) noexcept
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+
+		//replaces the state with the sum (xor) of the states polynomial selects among the next 256.
+		constexpr void jump_by(const jump_polynomial& polynomial) noexcept
+		{
+			auto jumped = jump_polynomial{};
+			for (const std::uint64_t word : polynomial)
+			{
+				for (int bit = 0; bit < 64; ++bit)
+				{
+					if ((word & (std::uint64_t{ 1 } << bit)) != 0)
+					{
+						for (size_t i = 0; i < jumped.size(); ++i)
+						{
+							jumped[i] ^= m_state[i];
+						}
+					}
+					(void) (*this)();
+				}
+			}
+			m_state = jumped;
+		}
+
+		std::array<std::uint64_t, 4> m_state;
+	};
+
+	constexpr std::uint64_t splitmix64_next(std::uint64_t& state) noexcept
+	{
+		std::uint64_t z = (state += 0x9e37'79b9'7f4a'7c15);
+		z = (z ^ (z >> 30)) * 0xbf58'476d'1ce4'e5b9;
+		z = (z ^ (z >> 27)) * 0x94d0'49bb'1331'11eb;
+		return z ^ (z >> 31);
+	}
+
+	template<typename TEngine>
+	std::uint64_t bounded_uniform(TEngine& engine, std::uint64_t range)
+	{
+		static_assert(TEngine::min() == 0 && TEngine::max() == std::numeric_limits<std::uint64_t>::max(),
+			"bounded_uniform requires an engine of full 64 bit outputs.");
+		assert(range > 0);
+		absl::uint128 product = absl::uint128{ engine() } * range;
+		std::uint64_t low = absl::Uint128Low64(product);
+		if (low < range)
+		{
+			//2^64 mod range: the products whose low half is below it are the surplus that would bias the result.
+			const std::uint64_t threshold = (std::uint64_t{ 0 } - range) % range;
+			while (low < threshold)
+			{
+				product = absl::uint128{ engine() } * range;
+				low = absl::Uint128Low64(product);
+			}
+		}
+		return absl::Uint128High64(product);
+	}
+}
+#endif // CJM_XOSHIRO_HPP_
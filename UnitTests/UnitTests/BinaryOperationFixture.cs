@@ -1,9 +1,11 @@
 ﻿using System;
+using System.Buffers.Binary;
 using System.Collections.Immutable;
 using System.Diagnostics;
 using System.Globalization;
 using HpTimeStamps;
 using HpTimeStamps.BigMath;
+using HpTimeStamps.BigMath.Utils;
 using JetBrains.Annotations;
 
 namespace UnitTests
@@ -186,6 +188,8 @@ namespace UnitTests
 
     static class BinaryOpCodeParser
     {
+        public const char HeaderCommentMarker = '#';
+
         public static ImmutableArray<BinaryOperation> ParseMany([NotNull] string text)
         {
             if (text == null) throw new ArgumentNullException(nameof(text));
@@ -198,10 +202,65 @@ namespace UnitTests
             var bldr = ImmutableArray.CreateBuilder<BinaryOperation>(lines.Length);
             foreach (var line in lines)
             {
+                //generated batteries begin with a header line recording seed and generator parameters
+                if (line.TrimStart().StartsWith(HeaderCommentMarker)) continue;
                 bldr.Add(Parse(line));
             }
 
+            return bldr.ToImmutable();
+        }
+
+        public const int BinaryHeaderSize = 80;
+        public const int BinaryRecordSize = 49;
+        public const uint BinaryFormatVersion = 1;
+
+        /// <summary>
+        /// Parse a battery written in the helper's fixed-width little-endian binary format
+        /// (suitable for a memory-mapped file).
+        /// </summary>
+        /// <param name="battery">the entire contents of the battery</param>
+        /// <returns>the operations</returns>
+        /// <exception cref="InvalidOperationException">the data is not a valid binary battery.</exception>
+        public static ImmutableArray<BinaryOperation> ParseBinary(ReadOnlySpan<byte> battery)
+        {
+            ReadOnlySpan<byte> magic = stackalloc byte[] { (byte)'C', (byte)'J', (byte)'M', (byte)'I', (byte)'1', (byte)'2', (byte)'8', (byte)'B' };
+            if (battery.Length < BinaryHeaderSize || !battery.Slice(0, magic.Length).SequenceEqual(magic))
+                throw new InvalidOperationException("The data is not a binary operation battery.");
+            uint version = BinaryPrimitives.ReadUInt32LittleEndian(battery.Slice(8));
+            uint headerSize = BinaryPrimitives.ReadUInt32LittleEndian(battery.Slice(12));
+            uint recordSize = BinaryPrimitives.ReadUInt32LittleEndian(battery.Slice(16));
+            uint expectedCrc = BinaryPrimitives.ReadUInt32LittleEndian(battery.Slice(20));
+            ulong count = BinaryPrimitives.ReadUInt64LittleEndian(battery.Slice(24));
+            if (version != BinaryFormatVersion || headerSize != BinaryHeaderSize || recordSize != BinaryRecordSize)
+                throw new InvalidOperationException($"Binary battery version {version} (header size {headerSize}, record size {recordSize}) is not supported.");
+            ReadOnlySpan<byte> records = battery.Slice(BinaryHeaderSize);
+            if ((ulong) records.Length != count * BinaryRecordSize)
+                throw new InvalidOperationException($"Binary battery declares {count} records but contains {records.Length} bytes of records.");
+            var crc = new Crc32();
+            foreach (byte b in records)
+            {
+                crc.UpdateByte(b);
+            }
+            if (crc.Value != expectedCrc)
+                throw new InvalidOperationException("Binary battery failed its crc check.");
+
+            var bldr = ImmutableArray.CreateBuilder<BinaryOperation>((int) count);
+            for (int offset = 0; offset < records.Length; offset += BinaryRecordSize)
+            {
+                ReadOnlySpan<byte> record = records.Slice(offset, BinaryRecordSize);
+                var op = (BinaryOpCode) record[0];
+                if (!Enum.IsDefined(op))
+                    throw new InvalidOperationException($"Binary battery contains unrecognized op code {record[0]}.");
+                Int128 left = ReadInt128(record.Slice(1));
+                Int128 right = ReadInt128(record.Slice(17));
+                Int128 result = ReadInt128(record.Slice(33));
+                bldr.Add(new BinaryOperation(op, in left, in right, in result));
+            }
             return bldr.MoveToImmutable();
+
+            static Int128 ReadInt128(ReadOnlySpan<byte> bytes) => new Int128(
+                BinaryPrimitives.ReadUInt64LittleEndian(bytes.Slice(8)),
+                BinaryPrimitives.ReadUInt64LittleEndian(bytes));
         }
 
         public static BinaryOperation Parse([NotNull] string text)